@@ -6,7 +6,7 @@
  * SPDX-License-Identifier: GPL-2.0-or-later                               *
  ***************************************************************************/
 
-#include "Checksum.hpp"
+#include "Checksum_p.hpp"
 #include "SonicChaoGarden.inc.h"
 
 #include "util/byteswap.h"
@@ -25,6 +25,135 @@ using std::vector;
 
 namespace Checksum {
 
+/** CRC-16 lookup tables. **/
+
+/**
+ * CRC-16 tables are used for slice-by-8 processing.
+ * crc16_tbl[0] is the standard byte-wise table.
+ * crc16_tbl[k][i] is the CRC of byte i followed by k zero bytes.
+ */
+typedef uint16_t crc16_tbl_t[8][256];
+
+/**
+ * Calculate a single CRC-16 table entry.
+ * @param poly Polynomial. (reflected)
+ * @param crc Initial value.
+ * @param bits Number of bits remaining.
+ * @return Table entry.
+ */
+static constexpr uint16_t crc16_entry(uint16_t poly, uint16_t crc, int bits)
+{
+	return (bits == 0 ? crc :
+		crc16_entry(poly, ((crc & 1)
+			? (uint16_t)((crc >> 1) ^ poly)
+			: (uint16_t)(crc >> 1)), bits - 1));
+}
+
+/**
+ * Advance a CRC-16 table entry by one zero byte.
+ * @param poly Polynomial. (reflected)
+ * @param crc Previous table entry.
+ * @return Next table entry.
+ */
+static constexpr uint16_t crc16_next(uint16_t poly, uint16_t crc)
+{
+	return (uint16_t)(crc16_entry(poly, crc & 0xFF, 8) ^ (crc >> 8));
+}
+
+/**
+ * Calculate a slice-by-8 CRC-16 table entry.
+ * @param poly Polynomial. (reflected)
+ * @param k Table number.
+ * @param i Table index.
+ * @return Table entry.
+ */
+static constexpr uint16_t crc16_slice_entry(uint16_t poly, int k, uint16_t i)
+{
+	return (k == 0 ? crc16_entry(poly, i, 8) :
+		crc16_next(poly, crc16_slice_entry(poly, k - 1, i)));
+}
+
+// Compile-time index sequence for building the tables.
+template<int... Idx> struct crc16_idx_seq { };
+template<int N, int... Idx> struct crc16_make_idx_seq
+	: crc16_make_idx_seq<N - 1, N - 1, Idx...> { };
+template<int... Idx> struct crc16_make_idx_seq<0, Idx...>
+	{ typedef crc16_idx_seq<Idx...> type; };
+
+// The polynomial must be a template parameter in order
+// to use it when building the table at compile time.
+template<uint16_t poly, int... Idx>
+struct crc16_tbl_gen {
+	static const crc16_tbl_t tbl;
+};
+#define CRC16_TBL_ROW(k) {crc16_slice_entry(poly, k, Idx)...}
+template<uint16_t poly, int... Idx>
+const crc16_tbl_t crc16_tbl_gen<poly, Idx...>::tbl = {
+	CRC16_TBL_ROW(0), CRC16_TBL_ROW(1), CRC16_TBL_ROW(2), CRC16_TBL_ROW(3),
+	CRC16_TBL_ROW(4), CRC16_TBL_ROW(5), CRC16_TBL_ROW(6), CRC16_TBL_ROW(7),
+};
+#undef CRC16_TBL_ROW
+
+template<uint16_t poly, typename Seq> struct crc16_tbl_for;
+template<uint16_t poly, int... Idx>
+struct crc16_tbl_for<poly, crc16_idx_seq<Idx...> >
+	: crc16_tbl_gen<poly, Idx...> { };
+
+// CRC-16 table for CRC16_POLY_CCITT.
+static const crc16_tbl_t &crc16_tbl_ccitt =
+	crc16_tbl_for<CRC16_POLY_CCITT, crc16_make_idx_seq<256>::type>::tbl;
+
+/**
+ * Initialize CRC-16 tables for an arbitrary polynomial.
+ * @param tbl	[out] CRC-16 tables.
+ * @param poly	[in] Polynomial.
+ */
+static void crc16_tbl_init(crc16_tbl_t &tbl, uint16_t poly)
+{
+	for (int i = 0; i < 256; i++) {
+		uint16_t crc = (uint16_t)i;
+		for (int bit = 8; bit > 0; bit--) {
+			if (crc & 1)
+				crc = ((crc >> 1) ^ poly);
+			else
+				crc >>= 1;
+		}
+		tbl[0][i] = crc;
+	}
+	for (int k = 1; k < 8; k++) {
+		for (int i = 0; i < 256; i++) {
+			const uint16_t prev = tbl[k-1][i];
+			tbl[k][i] = (tbl[0][prev & 0xFF] ^ (prev >> 8));
+		}
+	}
+}
+
+/**
+ * CRC-16 algorithm. (slice-by-8)
+ * @param tbl CRC-16 tables.
+ * @param crc Initial CRC value.
+ * @param buf Data buffer.
+ * @param siz Length of data buffer.
+ * @return Updated CRC value. (not inverted)
+ */
+static uint16_t Crc16_slice8(const crc16_tbl_t &tbl, uint16_t crc, const uint8_t *buf, uint32_t siz)
+{
+	for (; siz >= 8; siz -= 8, buf += 8) {
+		const uint16_t c = crc ^ (buf[0] | (buf[1] << 8));
+		crc = tbl[7][c & 0xFF] ^ tbl[6][c >> 8] ^
+		      tbl[5][buf[2]] ^ tbl[4][buf[3]] ^
+		      tbl[3][buf[4]] ^ tbl[2][buf[5]] ^
+		      tbl[1][buf[6]] ^ tbl[0][buf[7]];
+	}
+
+	// Remaining bytes.
+	for (; siz != 0; siz--, buf++) {
+		crc = (tbl[0][(crc ^ *buf) & 0xFF] ^ (crc >> 8));
+	}
+
+	return crc;
+}
+
 /** Algorithms. **/
 
 /**
@@ -36,9 +165,22 @@ namespace Checksum {
  */
 uint16_t Crc16(const uint8_t *buf, uint32_t siz, uint16_t poly)
 {
-	// TODO: Add optimized version for poly == CRC16_POLY_CCITT.
-	uint16_t crc = 0xFFFF;
+	if (poly == CRC16_POLY_CCITT) {
+		// Use the precalculated tables.
+		return ~Crc16_slice8(crc16_tbl_ccitt, 0xFFFF, buf, siz);
+	}
+
+	// Other polynomials: Calculating the tables costs about
+	// as much as running the bitwise algorithm on 512 bytes,
+	// so only do it for larger buffers.
+	// NOTE: The tables are on the stack so this is reentrant.
+	if (siz >= 1024) {
+		crc16_tbl_t tbl;
+		crc16_tbl_init(tbl, poly);
+		return ~Crc16_slice8(tbl, 0xFFFF, buf, siz);
+	}
 
+	uint16_t crc = 0xFFFF;
 	for (; siz != 0; siz--, buf++) {
 		crc ^= (*buf & 0xFF);
 		for (int i = 8; i > 0; i--) {
@@ -70,41 +212,18 @@ uint32_t AddInvDual16(const uint16_t *buf, uint32_t siz, ChkEndian endian)
 	siz /= 2;
 
 	// NOTE: Integer overflow/underflow is expected here.
-	uint16_t chk1 = 0;
+	uint16_t chk1;
 	uint16_t chk2 = (uint16_t)(-(int)siz);
 
-	if (endian != CHKENDIAN_LITTLE) {
-		// Big-endian system. (PowerPC, etc.)
-		// Do four words at a time.
-		// TODO: Optimize byteswapping?
-		for (; siz > 4; siz -= 4, buf += 4) {
-			chk1 += be16_to_cpu(buf[0]);
-			chk1 += be16_to_cpu(buf[1]);
-			chk1 += be16_to_cpu(buf[2]);
-			chk1 += be16_to_cpu(buf[3]);
-		}
-
-		// Remaining words.
-		for (; siz != 0; siz--, buf++) {
-			chk1 += be16_to_cpu(*buf);
-		}
-	} else {
-		// Little-endian system. (x86, SH-4, etc.)
-		// Do four words at a time.
-		// TODO: Optimize byteswapping?
-		for (; siz > 4; siz -= 4, buf += 4) {
-			chk1 += le16_to_cpu(buf[0]);
-			chk1 += le16_to_cpu(buf[1]);
-			chk1 += le16_to_cpu(buf[2]);
-			chk1 += le16_to_cpu(buf[3]);
-		}
-
-		// Remaining words.
-		for (; siz != 0; siz--, buf++) {
-			chk1 += le16_to_cpu(*buf);
-		}
+#ifdef GCTOOLS_HAS_SSE2
+	if (cpuflags_has_sse2()) {
+		chk1 = SumWords16_sse2(buf, siz, endian);
+	} else
+#endif /* GCTOOLS_HAS_SSE2 */
+	{
+		chk1 = SumWords16_c(buf, siz, endian);
 	}
-	
+
 	// sum(word ^ 0xFFFF) = sum(0xFFFF - word) = 0xFFFF * siz - sum(word)
 	// On 16 bits using two's complement, 0xFFFF = -1, so chk2 can be simplified as -siz - chk1.
 	chk2 -= chk1;
@@ -129,6 +248,67 @@ uint32_t AddInvDual16(const uint16_t *buf, uint32_t siz, ChkEndian endian)
  * @return Checksum.
  */
 uint32_t AddBytes32(const uint8_t *buf, uint32_t siz)
+{
+#ifdef GCTOOLS_HAS_SSE2
+	if (cpuflags_has_sse2()) {
+		return SumBytes32_sse2(buf, siz);
+	}
+#endif /* GCTOOLS_HAS_SSE2 */
+	return SumBytes32_c(buf, siz);
+}
+
+/**
+ * Add 16-bit words together in a uint16_t.
+ * @param buf Data buffer.
+ * @param words Number of words.
+ * @param endian Endianness of the data.
+ * @return Sum of all words.
+ */
+uint16_t SumWords16_c(const uint16_t *buf, uint32_t words, ChkEndian endian)
+{
+	// NOTE: Integer overflow is expected here.
+	uint16_t sum = 0;
+
+	if (endian != CHKENDIAN_LITTLE) {
+		// Big-endian system. (PowerPC, etc.)
+		// Do four words at a time.
+		for (; words > 4; words -= 4, buf += 4) {
+			sum += be16_to_cpu(buf[0]);
+			sum += be16_to_cpu(buf[1]);
+			sum += be16_to_cpu(buf[2]);
+			sum += be16_to_cpu(buf[3]);
+		}
+
+		// Remaining words.
+		for (; words != 0; words--, buf++) {
+			sum += be16_to_cpu(*buf);
+		}
+	} else {
+		// Little-endian system. (x86, SH-4, etc.)
+		// Do four words at a time.
+		for (; words > 4; words -= 4, buf += 4) {
+			sum += le16_to_cpu(buf[0]);
+			sum += le16_to_cpu(buf[1]);
+			sum += le16_to_cpu(buf[2]);
+			sum += le16_to_cpu(buf[3]);
+		}
+
+		// Remaining words.
+		for (; words != 0; words--, buf++) {
+			sum += le16_to_cpu(*buf);
+		}
+	}
+
+	return sum;
+}
+
+/**
+ * Add all bytes together in a uint32_t.
+ * @param buf Data buffer.
+ * @param siz Length of data buffer.
+ * @return Sum of all bytes.
+ */
+uint32_t SumBytes32_c(const uint8_t *buf, uint32_t siz)
 {
 	uint32_t checksum = 0;
 
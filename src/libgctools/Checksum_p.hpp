@@ -0,0 +1,45 @@
+/***************************************************************************
+ * GameCube Tools Library.                                                 *
+ * Checksum_p.hpp: Checksum algorithm class. (PRIVATE)                     *
+ *                                                                         *
+ * Copyright (c) 2012-2018 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#ifndef __LIBGCTOOLS_CHECKSUM_P_HPP__
+#define __LIBGCTOOLS_CHECKSUM_P_HPP__
+
+#include "Checksum.hpp"
+
+// CPU flags.
+#include "util/cpuflags_x86.h"
+
+namespace Checksum {
+
+/** Internal reduction functions. **/
+
+/**
+ * Add 16-bit words together in a uint16_t.
+ * @param buf Data buffer.
+ * @param words Number of words.
+ * @param endian Endianness of the data.
+ * @return Sum of all words.
+ */
+uint16_t SumWords16_c(const uint16_t *buf, uint32_t words, ChkEndian endian);
+
+/**
+ * Add all bytes together in a uint32_t.
+ * @param buf Data buffer.
+ * @param siz Length of data buffer.
+ * @return Sum of all bytes.
+ */
+uint32_t SumBytes32_c(const uint8_t *buf, uint32_t siz);
+
+#ifdef GCTOOLS_HAS_SSE2
+uint16_t SumWords16_sse2(const uint16_t *buf, uint32_t words, ChkEndian endian);
+uint32_t SumBytes32_sse2(const uint8_t *buf, uint32_t siz);
+#endif /* GCTOOLS_HAS_SSE2 */
+
+}
+
+#endif /* __LIBGCTOOLS_CHECKSUM_P_HPP__ */
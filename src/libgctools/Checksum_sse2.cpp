@@ -0,0 +1,92 @@
+/***************************************************************************
+ * GameCube Tools Library.                                                 *
+ * Checksum_sse2.cpp: Checksum algorithm class. (SSE2-optimized)           *
+ *                                                                         *
+ * Copyright (c) 2012-2018 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "Checksum_p.hpp"
+
+#ifdef GCTOOLS_HAS_SSE2
+
+// SSE2 intrinsics.
+#include <emmintrin.h>
+
+namespace Checksum {
+
+/**
+ * Add the two 64-bit lanes of a vector.
+ * @param v Vector.
+ * @return Sum of both lanes, truncated to 32 bits.
+ */
+static inline uint32_t HorizSum64(__m128i v)
+{
+	v = _mm_add_epi64(v, _mm_unpackhi_epi64(v, v));
+	return (uint32_t)_mm_cvtsi128_si32(v);
+}
+
+/**
+ * Add 16-bit words together in a uint16_t.
+ *
+ * The even and odd bytes are summed separately using PSADBW,
+ * which accumulates into 64-bit lanes and never overflows.
+ * The sum of the words is then (sum(high bytes) << 8) + sum(low bytes),
+ * so no byteswapping is needed for either endianness.
+ *
+ * @param buf Data buffer.
+ * @param words Number of words.
+ * @param endian Endianness of the data.
+ * @return Sum of all words.
+ */
+uint16_t SumWords16_sse2(const uint16_t *buf, uint32_t words, ChkEndian endian)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i mask00FF = _mm_set1_epi16(0x00FF);
+	__m128i sumEven = zero;	// Bytes at even addresses.
+	__m128i sumOdd = zero;	// Bytes at odd addresses.
+
+	for (; words >= 8; words -= 8, buf += 8) {
+		const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf));
+		sumEven = _mm_add_epi64(sumEven, _mm_sad_epu8(_mm_and_si128(v, mask00FF), zero));
+		sumOdd  = _mm_add_epi64(sumOdd,  _mm_sad_epu8(_mm_srli_epi16(v, 8), zero));
+	}
+
+	const uint32_t even = HorizSum64(sumEven);
+	const uint32_t odd = HorizSum64(sumOdd);
+	uint16_t sum;
+	if (endian != CHKENDIAN_LITTLE) {
+		// Big-endian: Even bytes are the high bytes.
+		sum = (uint16_t)((even << 8) + odd);
+	} else {
+		// Little-endian: Odd bytes are the high bytes.
+		sum = (uint16_t)((odd << 8) + even);
+	}
+
+	// Remaining words.
+	return sum + SumWords16_c(buf, words, endian);
+}
+
+/**
+ * Add all bytes together in a uint32_t.
+ * @param buf Data buffer.
+ * @param siz Length of data buffer.
+ * @return Sum of all bytes.
+ */
+uint32_t SumBytes32_sse2(const uint8_t *buf, uint32_t siz)
+{
+	const __m128i zero = _mm_setzero_si128();
+	__m128i sum = zero;
+
+	for (; siz >= 16; siz -= 16, buf += 16) {
+		const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf));
+		sum = _mm_add_epi64(sum, _mm_sad_epu8(v, zero));
+	}
+
+	// Remaining bytes.
+	return HorizSum64(sum) + SumBytes32_c(buf, siz);
+}
+
+}
+
+#endif /* GCTOOLS_HAS_SSE2 */
@@ -54,7 +54,7 @@ void GcImagePrivate::init(int w, int h, GcImage::PxFmt pxFmt)
 	free(imageData);
 	imageData = nullptr;
 	imageData_len = 0;
-	palette.clear();
+	palette.reset();
 	width = 0;
 	height = 0;
 	this->pxFmt = GcImage::PXFMT_NONE;
@@ -113,22 +113,25 @@ GcImage *GcImage::toRGB5A3(void) const
 
 		case PXFMT_CI8: {
 			// CI8. Convert to ARGB32.
+			if (!d->palette)
+				return nullptr;
 			GcImage *gcImage = new GcImage();
 			GcImagePrivate *const d_new = gcImage->d;
 			d_new->init(d->width, d->height, PXFMT_ARGB32);
 
+			const uint32_t *const palette = d->palette->data();
 			const uint8_t *ci8 = static_cast<const uint8_t*>(d->imageData);
 			uint32_t *rgb5A3 = static_cast<uint32_t*>(d_new->imageData);
 			size_t len = d->imageData_len;
 			for (; len >= 4; len -= 4, ci8 += 4, rgb5A3 += 4) {
-				*(rgb5A3 + 0) = d->palette[*(ci8 + 0)];
-				*(rgb5A3 + 1) = d->palette[*(ci8 + 1)];
-				*(rgb5A3 + 2) = d->palette[*(ci8 + 2)];
-				*(rgb5A3 + 3) = d->palette[*(ci8 + 3)];
+				*(rgb5A3 + 0) = palette[*(ci8 + 0)];
+				*(rgb5A3 + 1) = palette[*(ci8 + 1)];
+				*(rgb5A3 + 2) = palette[*(ci8 + 2)];
+				*(rgb5A3 + 3) = palette[*(ci8 + 3)];
 			}
 			// Just in case the image size isn't divisible by 4...
 			for (; len > 0; len--, ci8++, rgb5A3++) {
-				*rgb5A3 = d->palette[*ci8];
+				*rgb5A3 = palette[*ci8];
 			}
 
 			// Image is converted.
@@ -162,7 +165,7 @@ int GcImage::height(void) const
  */
 const uint32_t *GcImage::palette(void) const
 {
-	if (d->pxFmt != PXFMT_CI8 || d->palette.size() != 256)
+	if (d->pxFmt != PXFMT_CI8 || !d->palette || d->palette->size() != 256)
 		return nullptr;
-	return d->palette.data();
+	return d->palette->data();
 }
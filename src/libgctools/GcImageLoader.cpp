@@ -10,47 +10,20 @@
 #include "GcImageLoader.hpp"
 #include "GcImage_p.hpp"
 
-// Byteswapping macros.
-#include "util/byteswap.h"
+// Pixel conversion functions.
+#include "PixelConv.hpp"
 
 // C includes. (C++ namespace)
 #include <cstring>
 
-/**
- * Convert an RGB5A3 pixel to ARGB32.
- * @param px16 RGB5A3 pixel.
- * @return ARGB32 pixel.
- */
-static inline uint32_t RGB5A3_to_ARGB32(uint16_t px16)
-{
-	uint32_t px32 = 0;
-
-	// NOTE: Pixels are byteswapped.
-	if (px16 & 0x8000) {
-		// RGB555: xRRRRRGG GGGBBBBB
-		// ARGB32: AAAAAAAA RRRRRRRR GGGGGGGG BBBBBBBB
-		px32 |= (((px16 << 3) & 0x0000F8) | ((px16 >> 2) & 0x000007));	// B
-		px32 |= (((px16 << 6) & 0x00F800) | ((px16 << 1) & 0x000700));	// G
-		px32 |= (((px16 << 9) & 0xF80000) | ((px16 << 4) & 0x070000));	// R
-		px32 |= 0xFF000000U; // no alpha channel
-	} else {
-		// RGB4A3
-		px32  =  (px16 & 0x000F);	// B
-		px32 |= ((px16 & 0x00F0) << 4);	// G
-		px32 |= ((px16 & 0x0F00) << 8);	// R
-		px32 |= (px32 << 4);		// Copy to the top nybble.
-
-		// Calculate the alpha channel.
-		uint8_t a = ((px16 >> 7) & 0xE0);
-		a |= (a >> 3);
-		a |= (a >> 3);
-
-		// Apply the alpha channel.
-		px32 |= (a << 24);
-	}
-
-	return px32;
-}
+// C++ includes.
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+using std::shared_ptr;
+using std::vector;
+using std::weak_ptr;
 
 /**
  * Blit an ARGB32 tile to an ARGB32 linear image buffer.
@@ -77,6 +50,104 @@ static inline void BlitTile(pixel *imgBuf, int pitch,
 	}
 }
 
+/**
+ * Cache of converted RGB5A3 palettes.
+ *
+ * CI_SHARED icons use the same palette for every frame,
+ * and the banner often uses the same palette, too.
+ * Palettes are looked up by a hash of the RGB5A3 data,
+ * so each unique palette is only converted once and is
+ * shared by all of the GcImages that use it.
+ *
+ * Entries hold weak references, so palettes are freed
+ * once the last GcImage using them is deleted.
+ */
+class PaletteCache
+{
+	public:
+		/**
+		 * Get a converted RGB5A3 palette.
+		 * @param pal_buf RGB5A3 palette. (256 entries, big-endian)
+		 * @return ARGB32 palette. (256 entries)
+		 */
+		static shared_ptr<const vector<uint32_t> > get(const uint16_t *pal_buf);
+
+	private:
+		struct Entry {
+			uint16_t rgb5a3[256];
+			weak_ptr<const vector<uint32_t> > palette;
+		};
+
+		// Cached palettes, indexed by hash.
+		static std::unordered_multimap<uint32_t, Entry> cache;
+		static std::mutex mutex;
+
+		// Remove expired entries once the cache reaches this size.
+		static size_t pruneSize;
+};
+
+std::unordered_multimap<uint32_t, PaletteCache::Entry> PaletteCache::cache;
+std::mutex PaletteCache::mutex;
+size_t PaletteCache::pruneSize = 64;
+
+/**
+ * Get a converted RGB5A3 palette.
+ * @param pal_buf RGB5A3 palette. (256 entries, big-endian)
+ * @return ARGB32 palette. (256 entries)
+ */
+shared_ptr<const vector<uint32_t> > PaletteCache::get(const uint16_t *pal_buf)
+{
+	// FNV-1a hash of the palette data.
+	uint32_t hash = 2166136261U;
+	const uint8_t *p = reinterpret_cast<const uint8_t*>(pal_buf);
+	for (int i = 256*2; i > 0; i--, p++) {
+		hash = (hash ^ *p) * 16777619U;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	// Check if this palette has already been converted.
+	Entry *expiredEntry = nullptr;
+	auto range = cache.equal_range(hash);
+	for (auto iter = range.first; iter != range.second; ++iter) {
+		if (!memcmp(iter->second.rgb5a3, pal_buf, sizeof(iter->second.rgb5a3))) {
+			shared_ptr<const vector<uint32_t> > palette = iter->second.palette.lock();
+			if (palette)
+				return palette;
+			// Palette was freed. Reuse this entry.
+			expiredEntry = &iter->second;
+			break;
+		}
+	}
+
+	// Convert the palette.
+	shared_ptr<vector<uint32_t> > palette = std::make_shared<vector<uint32_t> >(256);
+	PixelConv::RGB5A3_to_ARGB32_line(palette->data(), pal_buf, 256);
+	if (expiredEntry) {
+		expiredEntry->palette = palette;
+		return palette;
+	}
+
+	if (cache.size() >= pruneSize) {
+		// Remove expired entries.
+		for (auto iter = cache.begin(); iter != cache.end(); ) {
+			if (iter->second.palette.expired()) {
+				iter = cache.erase(iter);
+			} else {
+				++iter;
+			}
+		}
+		// Don't prune again until the cache doubles in size.
+		pruneSize = (cache.size() < 32 ? 64 : cache.size() * 2);
+	}
+
+	// Add the palette to the cache.
+	auto iter = cache.insert(std::make_pair(hash, Entry()));
+	memcpy(iter->second.rgb5a3, pal_buf, sizeof(iter->second.rgb5a3));
+	iter->second.palette = palette;
+	return palette;
+}
+
 /**
  * Convert a GameCube CI8 image to GcImage.
  * @param w Image width.
@@ -110,12 +181,9 @@ GcImage *GcImageLoader::fromCI8(int w, int h,
 	GcImagePrivate *const d = gcImage->d;
 	d->init(w, h, GcImage::PXFMT_CI8);
 
-	// Convert the palette.
-	// TODO: Optimize using pointers instead of indexes?
-	d->palette.resize(256);
-	for (int i = 0; i < 256; i++) {
-		d->palette[i] = RGB5A3_to_ARGB32(be16_to_cpu(pal_buf[i]));
-	}
+	// Get the palette.
+	// Identical palettes are shared between GcImages.
+	d->palette = PaletteCache::get(pal_buf);
 
 	// Tile pointer.
 	const uint8_t *tileBuf = img_buf;
@@ -162,21 +230,8 @@ GcImage *GcImageLoader::fromRGB5A3(int w, int h, const uint16_t *img_buf, int im
 	GcImagePrivate *const d = gcImage->d;
 	d->init(w, h, GcImage::PXFMT_ARGB32);
 
-	// Temporary tile buffer.
-	uint32_t tileBuf[4*4];
-
-	for (int y = 0; y < tilesY; y++) {
-		for (int x = 0; x < tilesX; x++) {
-			// Convert each tile to ARGB32 manually.
-			// TODO: Optimize using pointers instead of indexes?
-			for (int i = 0; i < 4*4; i++, img_buf++) {
-				tileBuf[i] = RGB5A3_to_ARGB32(be16_to_cpu(*img_buf));
-			}
-
-			// Blit the tile to the main image buffer.
-			BlitTile<uint32_t, 4, 4>((uint32_t*)d->imageData, w, tileBuf, x, y);
-		}
-	}
+	// Convert the tiles directly into the main image buffer.
+	PixelConv::RGB5A3_tiled_to_ARGB32((uint32_t*)d->imageData, img_buf, tilesX, tilesY);
 
 	// Image has been converted.
 	return gcImage;
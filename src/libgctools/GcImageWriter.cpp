@@ -33,6 +33,8 @@ using std::vector;
 
 GcImageWriterPrivate::GcImageWriterPrivate(GcImageWriter *const q)
 	: q(q)
+	, pngCompression(GcImageWriter::PNGC_DEFAULT)
+	, threadCount(1)
 { }
 
 GcImageWriterPrivate::~GcImageWriterPrivate()
@@ -65,7 +67,11 @@ bool GcImageWriterPrivate::is_gcImages_CI8_UNIQUE(const vector<const GcImage*> *
 		const uint32_t *const palette0 = gcImage0->palette();
 		for (auto iter = gcImages->cbegin() + 1; iter != gcImages->cend(); ++iter) {
 			const uint32_t *const paletteN = (*iter)->palette();
-			if (memcmp(palette0, paletteN, (256*sizeof(*paletteN))) != 0) {
+			// NOTE: Identical palettes are usually shared by
+			// GcImageLoader, so check the pointers first.
+			if (paletteN != palette0 &&
+			    memcmp(palette0, paletteN, (256*sizeof(*paletteN))) != 0)
+			{
 				// CI8_UNIQUE.
 				is_CI8_UNIQUE = true;
 				break;
@@ -312,6 +318,54 @@ GcImageWriter::AnimImageFormat GcImageWriter::animImageFormatFromName(const char
 	return ANIMGF_UNKNOWN;
 }
 
+/**
+ * Get the PNG compression mode.
+ * @return PNG compression mode.
+ */
+GcImageWriter::PngCompression GcImageWriter::pngCompression(void) const
+{
+	return d->pngCompression;
+}
+
+/**
+ * Set the PNG compression mode.
+ * This affects all PNG and APNG images written afterwards.
+ * @param pngc PNG compression mode.
+ */
+void GcImageWriter::setPngCompression(PngCompression pngc)
+{
+	assert(pngc >= PNGC_DEFAULT && pngc < PNGC_MAX);
+	if (pngc < PNGC_DEFAULT || pngc >= PNGC_MAX)
+		return;
+	d->pngCompression = pngc;
+}
+
+/**
+ * Get the maximum number of threads used to encode animated images.
+ * @return Maximum number of threads, including the calling thread.
+ */
+int GcImageWriter::threadCount(void) const
+{
+	return d->threadCount;
+}
+
+/**
+ * Set the maximum number of threads used to encode animated images.
+ *
+ * This is currently only used to quantize ARGB32 frames
+ * for animated GIFs. The default is 1, which encodes
+ * everything on the calling thread. Callers that are
+ * already running on a thread pool should leave this at 1
+ * unless the pool has idle threads.
+ *
+ * @param threadCount Maximum number of threads, including the calling thread.
+ */
+void GcImageWriter::setThreadCount(int threadCount)
+{
+	assert(threadCount >= 1);
+	d->threadCount = (threadCount >= 1 ? threadCount : 1);
+}
+
 /**
  * Get the internal memory buffer. (first file only)
  * @return Internal memory buffer, or nullptr if no files are in memory.
@@ -130,6 +130,48 @@ class GcImageWriter
 		 */
 		static AnimImageFormat animImageFormatFromName(const char *animImgf_str);
 
+		/**
+		 * PNG compression modes.
+		 */
+		enum PngCompression {
+			PNGC_DEFAULT	= 0,	// Balanced (zlib level 5, no filtering)
+			PNGC_FAST,		// Fastest (zlib level 1, no filtering)
+			PNGC_BEST,		// Smallest (zlib level 9, adaptive filtering)
+			PNGC_MAX
+		};
+
+		/**
+		 * Get the PNG compression mode.
+		 * @return PNG compression mode.
+		 */
+		PngCompression pngCompression(void) const;
+
+		/**
+		 * Set the PNG compression mode.
+		 * This affects all PNG and APNG images written afterwards.
+		 * @param pngc PNG compression mode.
+		 */
+		void setPngCompression(PngCompression pngc);
+
+		/**
+		 * Get the maximum number of threads used to encode animated images.
+		 * @return Maximum number of threads, including the calling thread.
+		 */
+		int threadCount(void) const;
+
+		/**
+		 * Set the maximum number of threads used to encode animated images.
+		 *
+		 * This is currently only used to quantize ARGB32 frames
+		 * for animated GIFs. The default is 1, which encodes
+		 * everything on the calling thread. Callers that are
+		 * already running on a thread pool should leave this at 1
+		 * unless the pool has idle threads.
+		 *
+		 * @param threadCount Maximum number of threads, including the calling thread.
+		 */
+		void setThreadCount(int threadCount);
+
 		/**
 		 * Get the internal memory buffer. (first file only)
 		 * @return Internal memory buffer, or nullptr if no files are in memory.
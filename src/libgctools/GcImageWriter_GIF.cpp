@@ -18,28 +18,25 @@
 #include <stdlib.h>
 
 // C++ includes.
+#include <atomic>
 #include <memory>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 using std::unique_ptr;
 using std::vector;
 
-#ifdef USE_INTERNAL_GIF
-// giflib-5.2.1 declares GifQuantizeBuffer in getarg.h.
-#include "getarg.h"
-#else /* !USE_INTERNAL_GIF */
-// giflib-4.2 doesn't have QuantizeBuffer().
-// To prevent issues, we're including our own copy of
-// giflib-5.2.1's GifQuantizeBuffer() if we're not
-// using an internal copy of giflib.
+// giflib-4.2 doesn't have QuantizeBuffer(), and the
+// versions in giflib-5.x use global variables.
+// We're using our own reentrant copy of giflib-5.2.1's
+// GifQuantizeBuffer() so frames can be quantized in parallel.
 extern "C"
 int gcn_GifQuantizeBuffer(unsigned int Width, unsigned int Height,
                    int *ColorMapSize, GifByteType * RedInput,
                    GifByteType * GreenInput, GifByteType * BlueInput,
                    GifByteType * OutputBuffer,
                    GifColorType * OutputColorMap);
-#define GifQuantizeBuffer(Width, Height, ColorMapSize, RedInput, GreenInput, BlueInput, OutputBuffer, OutputColorMap) \
-	gcn_GifQuantizeBuffer((Width), (Height), (ColorMapSize), (RedInput), (GreenInput), (BlueInput), (OutputBuffer), (OutputColorMap))
-#endif /* !USE_INTERNAL_GIF */
 
 /**
  * GIF write function.
@@ -181,25 +178,86 @@ int GcImageWriterPrivate::gif_addGraphicsControlBlock(GifFileType *gif, int tran
 }
 
 /**
- * Write an ARGB32 image to a GIF.
- * This will reduce the image to 256 colors first.
- * @param gif		[in] GIF image.
- * @param gcImage	[in] GcImage to write.
- * @param colorMap	[in] Color map object to use.
+ * Map ARGB32 images to a single palette without quantizing.
+ * This is only possible if all of the images combined
+ * use 256 colors or less.
+ * @param gcImages	[in] Vector of GcImage.
+ * @param colorMap	[out] Color map object for the shared palette.
+ * @param frames	[out] Color indexes for each frame. (colors[] isn't used)
+ * @return True if the images were mapped; false if there are too many colors.
+ */
+bool GcImageWriterPrivate::gif_mapARGB32ImagesToColorMap(const vector<const GcImage*> *gcImages,
+							 ColorMapObject *colorMap,
+							 vector<GifQuantizedFrame> *frames)
+{
+	// Color indexes, indexed by RGB value.
+	// NOTE: GIF doesn't support alpha-transparency,
+	// so the alpha channel is ignored.
+	std::unordered_map<uint32_t, uint8_t> colorIdx;
+	colorIdx.reserve(512);
+	uint32_t colors[256];
+	int colorCount = 0;
+
+	frames->resize(gcImages->size());
+	for (int i = 0; i < (int)gcImages->size(); i++) {
+		const GcImage *gcImage = gcImages->at(i);
+		const size_t bufSz = gcImage->width() * gcImage->height();
+		GifQuantizedFrame &frame = (*frames)[i];
+		frame.pixels.resize(bufSz);
+
+		const uint32_t *src = (const uint32_t*)gcImage->imageData();
+		uint8_t *dest = frame.pixels.data();
+		for (size_t px = bufSz; px > 0; px--, src++, dest++) {
+			const uint32_t rgb = (*src & 0xFFFFFF);
+			auto iter = colorIdx.find(rgb);
+			if (iter != colorIdx.end()) {
+				*dest = iter->second;
+				continue;
+			}
+
+			// New color.
+			if (colorCount >= 256) {
+				// Too many colors.
+				return false;
+			}
+			colors[colorCount] = rgb;
+			colorIdx.insert(std::make_pair(rgb, (uint8_t)colorCount));
+			*dest = (uint8_t)colorCount;
+			colorCount++;
+		}
+	}
+
+	// Convert the palette.
+	// NOTE: giflib requires a power-of-two color count,
+	// so unused entries are set to black.
+	GifColorType *color = GifDlGetColorMapArray(colorMap);
+	for (int i = 0; i < 256; i++, color++) {
+		const uint32_t rgb = (i < colorCount ? colors[i] : 0);
+		color->Red   = ((rgb >> 16) & 0xFF);
+		color->Green = ((rgb >>  8) & 0xFF);
+		color->Blue  = ( rgb        & 0xFF);
+	}
+	GifDlSetColorMapCount(colorMap, 256);
+	return true;
+}
+
+/**
+ * Reduce an ARGB32 image to 256 colors.
+ * This function is reentrant.
+ * @param gcImage	[in] GcImage to quantize.
+ * @param frame		[out] Quantized frame.
  * @return GIF_OK on success; GIF_ERROR on error.
  */
-int GcImageWriterPrivate::gif_writeARGB32Image(GifFileType *gif,
-		const GcImage *gcImage, ColorMapObject *colorMap)
+int GcImageWriterPrivate::gif_quantizeARGB32Image(const GcImage *gcImage, GifQuantizedFrame *frame)
 {
 	// Split the image into separate Red/Green/Blue buffers.
 	// TODO: Transparency?
 	const size_t bufSz = gcImage->width() * gcImage->height();
-	const size_t fullBufSz = bufSz * 4;
+	const size_t fullBufSz = bufSz * 3;
 	unique_ptr<GifByteType[]> full(new GifByteType[fullBufSz]);
 	GifByteType *red = full.get();
 	GifByteType *green = red + bufSz;
 	GifByteType *blue = green + bufSz;
-	GifByteType *out = blue + bufSz;
 
 	const uint32_t *src = (const uint32_t*)gcImage->imageData();
 	for (size_t i = bufSz; i > 0; i--, src++) {
@@ -214,33 +272,70 @@ int GcImageWriterPrivate::gif_writeARGB32Image(GifFileType *gif,
 	blue = green + bufSz;
 
 	// Quantize the image buffer.
-	int colorCount = 256;
-	GifDlSetColorMapCount(colorMap, colorCount);
-	int ret = GifQuantizeBuffer(gcImage->width(), gcImage->height(),
-			&colorCount, red, green, blue, out,
-			GifDlGetColorMapArray(colorMap));
-	GifDlSetColorMapCount(colorMap, colorCount);
-	if (ret != GIF_OK) {
-		// Error!
-		return ret;
-	}
+	// NOTE: Unused palette entries are set to black.
+	frame->pixels.resize(bufSz);
+	frame->colorCount = 256;
+	return gcn_GifQuantizeBuffer(gcImage->width(), gcImage->height(),
+			&frame->colorCount, red, green, blue,
+			frame->pixels.data(), frame->colors);
+}
 
-	// Start the frame.
-	ret = EGifDlPutImageDesc(gif, 0, 0, gcImage->width(), gcImage->height(), false, colorMap);
-	if (ret != GIF_OK) {
-		// Error!
-		return ret;
+/**
+ * Reduce multiple ARGB32 images to 256 colors.
+ * If threadCount > 1, frames are quantized in parallel.
+ * @param gcImages	[in] Vector of GcImage.
+ * @param frames	[out] Quantized frames.
+ * @param threadCount	[in] Maximum number of threads, including the calling thread.
+ * @return GIF_OK on success; GIF_ERROR on error.
+ */
+int GcImageWriterPrivate::gif_quantizeARGB32Images(const vector<const GcImage*> *gcImages,
+						   vector<GifQuantizedFrame> *frames,
+						   int threadCount)
+{
+	const int count = (int)gcImages->size();
+	frames->resize(count);
+
+	if (threadCount > count)
+		threadCount = count;
+	if (threadCount <= 1) {
+		// Quantize the frames on this thread.
+		for (int i = 0; i < count; i++) {
+			if (gif_quantizeARGB32Image(gcImages->at(i), &(*frames)[i]) != GIF_OK)
+				return GIF_ERROR;
+		}
+		return GIF_OK;
 	}
 
-	// Write the entire image.
-	ret = EGifDlPutLine(gif, out, bufSz);
-	if (ret != GIF_OK) {
-		// Error!
-		return ret;
+	// Each thread quantizes the next available frame.
+	std::atomic<int> nextFrame(0);
+	std::atomic<int> ret(GIF_OK);
+	auto quantizeFrames = [&]() {
+		int i;
+		while ((i = nextFrame.fetch_add(1)) < count) {
+			if (gif_quantizeARGB32Image(gcImages->at(i), &(*frames)[i]) != GIF_OK) {
+				ret = GIF_ERROR;
+			}
+		}
+	};
+
+	vector<std::thread> threads;
+	threads.reserve(threadCount - 1);
+	for (int i = 1; i < threadCount; i++) {
+		try {
+			threads.emplace_back(quantizeFrames);
+		} catch (const std::system_error&) {
+			// Unable to start a thread.
+			// The remaining frames will be handled
+			// by the threads that did start.
+			break;
+		}
+	}
+	quantizeFrames();
+	for (auto iter = threads.begin(); iter != threads.end(); ++iter) {
+		iter->join();
 	}
 
-	// Image written.
-	return GIF_OK;
+	return ret;
 }
 
 /**
@@ -270,14 +365,46 @@ int GcImageWriterPrivate::writeGif_anim(const vector<const GcImage*> *gcImages,
 		return -1;
 	}
 
-	bool is_CI8_UNIQUE = false;
-	if (gcImage0->pxFmt() == GcImage::PXFMT_CI8) {
-		// May be CI8 or CI8_UNIQUE.
-		is_CI8_UNIQUE = is_gcImages_CI8_UNIQUE(gcImages);
-		if (!is_CI8_UNIQUE) {
-			// Convert the palette from the first frame.
-			paletteToGifColorMap(colorMap, gcImage0->palette());
-		}
+	// If true, each frame has its own local color map.
+	// Otherwise, colorMap is the global color map.
+	bool useLocalColorMaps = false;
+
+	// Color indexes for ARGB32 frames.
+	vector<GifQuantizedFrame> quantizedFrames;
+
+	switch (gcImage0->pxFmt()) {
+		case GcImage::PXFMT_CI8:
+			// May be CI8 or CI8_UNIQUE.
+			useLocalColorMaps = is_gcImages_CI8_UNIQUE(gcImages);
+			if (!useLocalColorMaps) {
+				// CI8 SHARED. Use the palette as-is for
+				// the global color map.
+				paletteToGifColorMap(colorMap, gcImage0->palette());
+			}
+			break;
+
+		case GcImage::PXFMT_ARGB32:
+			// If all of the frames use 256 colors or less,
+			// use them as-is for the global color map.
+			if (gif_mapARGB32ImagesToColorMap(gcImages, colorMap, &quantizedFrames))
+				break;
+
+			// Reduce each frame to 256 colors.
+			// This is done for all frames before writing, since
+			// quantization can be done in parallel, but the
+			// LZW-compressed frames must be written in order.
+			// TODO: Use a similar palette for all images?
+			// Otherwise it might look weird...
+			useLocalColorMaps = true;
+			if (gif_quantizeARGB32Images(gcImages, &quantizedFrames, threadCount) != GIF_OK) {
+				// Error!
+				GifDlFreeMapObject(colorMap);
+				return -8;
+			}
+			break;
+
+		default:
+			break;
 	}
 
 	// Initialize the internal buffer.
@@ -303,9 +430,9 @@ int GcImageWriterPrivate::writeGif_anim(const vector<const GcImage*> *gcImages,
 
 	// Put the screen description for the first frame.
 	// NOTE: colorMap is only specified if the image
-	// uses a global palette. For CI8_UNIQUE, each
-	// frame will have its own local palette.
-	if (EGifDlPutScreenDesc(gif, w, h, 8, 0, (is_CI8_UNIQUE ? nullptr : colorMap)) != GIF_OK) {
+	// uses a global palette. For CI8_UNIQUE and quantized
+	// ARGB32, each frame will have its own local palette.
+	if (EGifDlPutScreenDesc(gif, w, h, 8, 0, (useLocalColorMaps ? nullptr : colorMap)) != GIF_OK) {
 		// Error!
 		EGifDlCloseFile(gif, &err);
 		delete gifBuffer;
@@ -342,7 +469,7 @@ int GcImageWriterPrivate::writeGif_anim(const vector<const GcImage*> *gcImages,
 			return -5;
 		}
 
-		if (is_CI8_UNIQUE) {
+		if (useLocalColorMaps && gcImage->pxFmt() == GcImage::PXFMT_CI8) {
 			// Update the ColorMap for this frame.
 			paletteToGifColorMap(colorMap, gcImage->palette());
 		}
@@ -351,7 +478,7 @@ int GcImageWriterPrivate::writeGif_anim(const vector<const GcImage*> *gcImages,
 			case GcImage::PXFMT_CI8:
 				// Start the frame.
 				if (EGifDlPutImageDesc(gif, 0, 0, w, h, false,
-				    (is_CI8_UNIQUE ? colorMap : nullptr)) != GIF_OK)
+				    (useLocalColorMaps ? colorMap : nullptr)) != GIF_OK)
 				{
 					// Error!
 					EGifDlCloseFile(gif, &err);
@@ -372,11 +499,31 @@ int GcImageWriterPrivate::writeGif_anim(const vector<const GcImage*> *gcImages,
 				}
 				break;
 
-			case GcImage::PXFMT_ARGB32:
-				// Reduce the image to 256 colors.
-				// TODO: Use a similar palette for all images?
-				// Otherwise it might look weird...
-				if (gif_writeARGB32Image(gif, gcImage, colorMap) != GIF_OK) {
+			case GcImage::PXFMT_ARGB32: {
+				const GifQuantizedFrame &frame = quantizedFrames[i];
+				if (useLocalColorMaps) {
+					// Copy the quantized palette into the ColorMap.
+					// NOTE: giflib requires a power-of-two color count.
+					// Unused entries were set to black by the quantizer.
+					memcpy(GifDlGetColorMapArray(colorMap), frame.colors, sizeof(frame.colors));
+					GifDlSetColorMapCount(colorMap, 256);
+				}
+
+				// Start the frame.
+				if (EGifDlPutImageDesc(gif, 0, 0, w, h, false,
+				    (useLocalColorMaps ? colorMap : nullptr)) != GIF_OK)
+				{
+					// Error!
+					EGifDlCloseFile(gif, &err);
+					delete gifBuffer;
+					GifDlFreeMapObject(colorMap);
+					return -8;
+				}
+
+				// Write the entire image.
+				if (EGifDlPutLine(gif, const_cast<uint8_t*>(frame.pixels.data()),
+				    (int)frame.pixels.size()) != GIF_OK)
+				{
 					// Error!
 					EGifDlCloseFile(gif, &err);
 					delete gifBuffer;
@@ -384,6 +531,7 @@ int GcImageWriterPrivate::writeGif_anim(const vector<const GcImage*> *gcImages,
 					return -8;
 				}
 				break;
+			}
 
 			default:
 				// Unsupported pixel format.
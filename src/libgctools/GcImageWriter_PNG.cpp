@@ -38,10 +38,10 @@ void GcImageWriterPrivate::png_io_write(png_structp png_ptr, png_bytep buf, png_
 		return;
 
 	// Assuming the io_ptr is a vector<uint8_t>*.
+	// NOTE: The buffer is preallocated using pngBufferSize(),
+	// so this shouldn't need to reallocate.
 	vector<uint8_t> *pngBuffer = static_cast<vector<uint8_t>*>(io_ptr);
-	size_t pos = pngBuffer->size();
-	pngBuffer->resize(pos + len);
-	memcpy(&pngBuffer->data()[pos], buf, len);
+	pngBuffer->insert(pngBuffer->end(), buf, buf + len);
 }
 
 /**
@@ -56,6 +56,65 @@ void GcImageWriterPrivate::png_io_flush(png_structp png_ptr)
 	((void)png_ptr);
 }
 
+/**
+ * Set the compression parameters for a PNG image
+ * using the current PNG compression mode.
+ * @param png_ptr	[in] PNG pointer.
+ */
+void GcImageWriterPrivate::setPngCompressionParams(png_structp png_ptr) const
+{
+	switch (pngCompression) {
+		case GcImageWriter::PNGC_FAST:
+			// Icons and banners are small, so filtering
+			// and higher compression levels don't gain much.
+			png_set_filter(png_ptr, 0, PNG_FILTER_NONE);
+			png_set_compression_level(png_ptr, 1);
+			break;
+
+		case GcImageWriter::PNGC_BEST:
+			png_set_filter(png_ptr, 0, PNG_ALL_FILTERS);
+			png_set_compression_level(png_ptr, 9);
+			break;
+
+		case GcImageWriter::PNGC_DEFAULT:
+		default:
+			png_set_filter(png_ptr, 0, PNG_FILTER_NONE);
+			png_set_compression_level(png_ptr, 5);
+			break;
+	}
+}
+
+/**
+ * Get the maximum size of an encoded PNG image.
+ * This is used to preallocate the internal memory buffer.
+ * @param w		[in] Width.
+ * @param h		[in] Height.
+ * @param pxFmt		[in] Pixel format.
+ * @param frames	[in] Number of frames. (APNG only; otherwise, 1)
+ * @return Maximum size of the PNG image, in bytes.
+ */
+size_t GcImageWriterPrivate::pngBufferSize(int w, int h, GcImage::PxFmt pxFmt, int frames)
+{
+	const size_t bytespp = (pxFmt == GcImage::PXFMT_CI8 ? 1 : 4);
+
+	// Uncompressed frame size, including the filter byte on each row.
+	const size_t rawSize = (size_t)h * (((size_t)w * bytespp) + 1);
+	// zlib's worst case is storing the data uncompressed.
+	const size_t zSize = rawSize + (rawSize >> 10) + 64;
+	// IDAT/fdAT chunk headers, using libpng's default
+	// 8 KB zlib buffer size, plus the APNG fcTL chunk.
+	const size_t frameSize = zSize + (((zSize / 8192) + 1) * 16) + 38;
+
+	// PNG signature, IHDR, acTL, and IEND.
+	size_t fixedSize = 8 + 25 + 20 + 12;
+	if (pxFmt == GcImage::PXFMT_CI8) {
+		// PLTE and tRNS.
+		fixedSize += (12 + (256 * 3)) + (12 + 256);
+	}
+
+	return fixedSize + (frameSize * frames);
+}
+
 /**
  * Write a PLTE chunk to a PNG image.
  * @param png_ptr	[in] PNG pointer.
@@ -117,7 +176,7 @@ int GcImageWriterPrivate::writePng(const GcImage *gcImage)
 
 	// Initialize the internal buffer.
 	vector<uint8_t> *pngBuffer = new vector<uint8_t>();
-	pngBuffer->reserve(32768);	// 32 KB should cover most of the use cases.
+	pngBuffer->reserve(pngBufferSize(gcImage->width(), gcImage->height(), gcImage->pxFmt()));
 	vector<const uint8_t*> row_pointers;
 
 	// WARNING: Do NOT initialize any C++ objects past this point!
@@ -134,8 +193,7 @@ int GcImageWriterPrivate::writePng(const GcImage *gcImage)
 	png_set_write_fn(png_ptr, pngBuffer, png_io_write, png_io_flush);
 
 	// Initialize compression parameters.
-	png_set_filter(png_ptr, 0, PNG_FILTER_NONE);
-	png_set_compression_level(png_ptr, 5);	// TODO: Customizable?
+	setPngCompressionParams(png_ptr);
 
 	const int w = gcImage->width();
 	const int h = gcImage->height();
@@ -227,7 +285,8 @@ int GcImageWriterPrivate::writeAPng(const vector<const GcImage*> *gcImages, cons
 
 	// Initialize the internal buffer.
 	vector<uint8_t> *pngBuffer = new vector<uint8_t>();
-	pngBuffer->reserve(32768);	// 32 KB should cover most of the use cases.
+	pngBuffer->reserve(pngBufferSize(gcImages->at(0)->width(), gcImages->at(0)->height(),
+					 gcImages->at(0)->pxFmt(), (int)gcImages->size()));
 	vector<const uint8_t*> row_pointers;
 
 	// WARNING: Do NOT initialize any C++ objects past this point!
@@ -244,8 +303,7 @@ int GcImageWriterPrivate::writeAPng(const vector<const GcImage*> *gcImages, cons
 	png_set_write_fn(png_ptr, pngBuffer, png_io_write, png_io_flush);
 
 	// Initialize compression parameters.
-	png_set_filter(png_ptr, 0, PNG_FILTER_NONE);
-	png_set_compression_level(png_ptr, 5);	// TODO: Customizable?
+	setPngCompressionParams(png_ptr);
 
 	const GcImage *gcImage0 = gcImages->at(0);
 	const int w = gcImage0->width();
@@ -378,7 +436,9 @@ int GcImageWriterPrivate::writePng_VS(const vector<const GcImage*> *gcImages)
 
 	// Initialize the internal buffer.
 	vector<uint8_t> *pngBuffer = new vector<uint8_t>();
-	pngBuffer->reserve(32768);	// 32 KB should cover most of the use cases.
+	pngBuffer->reserve(pngBufferSize(gcImages->at(0)->width(),
+					 gcImages->at(0)->height() * (int)gcImages->size(),
+					 gcImages->at(0)->pxFmt()));
 	vector<const uint8_t*> row_pointers;
 
 	// WARNING: Do NOT initialize any C++ objects past this point!
@@ -395,8 +455,7 @@ int GcImageWriterPrivate::writePng_VS(const vector<const GcImage*> *gcImages)
 	png_set_write_fn(png_ptr, pngBuffer, png_io_write, png_io_flush);
 
 	// Initialize compression parameters.
-	png_set_filter(png_ptr, 0, PNG_FILTER_NONE);
-	png_set_compression_level(png_ptr, 5);	// TODO: Customizable?
+	setPngCompressionParams(png_ptr);
 
 	const GcImage *gcImage0 = gcImages->at(0);
 	const int w = gcImage0->width();
@@ -498,7 +557,9 @@ int GcImageWriterPrivate::writePng_HS(const vector<const GcImage*> *gcImages)
 
 	// Initialize the internal buffer.
 	vector<uint8_t> *pngBuffer = new vector<uint8_t>();
-	pngBuffer->reserve(32768);	// 32 KB should cover most of the use cases.
+	pngBuffer->reserve(pngBufferSize(gcImages->at(0)->width() * (int)gcImages->size(),
+					 gcImages->at(0)->height(),
+					 gcImages->at(0)->pxFmt()));
 	vector<uint8_t> imgBuf;		// Temporary image buffer.
 	vector<const uint8_t*> row_pointers;
 
@@ -516,8 +577,7 @@ int GcImageWriterPrivate::writePng_HS(const vector<const GcImage*> *gcImages)
 	png_set_write_fn(png_ptr, pngBuffer, png_io_write, png_io_flush);
 
 	// Initialize compression parameters.
-	png_set_filter(png_ptr, 0, PNG_FILTER_NONE);
-	png_set_compression_level(png_ptr, 5);	// TODO: Customizable?
+	setPngCompressionParams(png_ptr);
 
 	const GcImage *gcImage0 = gcImages->at(0);
 	const int w = gcImage0->width();
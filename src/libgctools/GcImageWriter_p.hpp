@@ -11,7 +11,7 @@
 
 #include <config.libgctools.h>
 #include "GcImageWriter.hpp"
-class GcImage;
+#include "GcImage.hpp"
 
 // C includes.
 #include <stdint.h>
@@ -48,6 +48,12 @@ class GcImageWriterPrivate
 		// Each call to write() creates a new buffer.
 		std::vector<std::vector<uint8_t>* > memBuffer;
 
+		// PNG compression mode.
+		GcImageWriter::PngCompression pngCompression;
+
+		// Maximum number of threads for animated images.
+		int threadCount;
+
 	private:
 		/**
 		 * Check if a vector of gcImages is CI8_UNIQUE.
@@ -83,6 +89,24 @@ class GcImageWriterPrivate
 		 */
 		static void png_io_flush(png_structp png_ptr);
 
+		/**
+		 * Set the compression parameters for a PNG image
+		 * using the current PNG compression mode.
+		 * @param png_ptr	[in] PNG pointer.
+		 */
+		void setPngCompressionParams(png_structp png_ptr) const;
+
+		/**
+		 * Get the maximum size of an encoded PNG image.
+		 * This is used to preallocate the internal memory buffer.
+		 * @param w		[in] Width.
+		 * @param h		[in] Height.
+		 * @param pxFmt		[in] Pixel format.
+		 * @param frames	[in] Number of frames. (APNG only; otherwise, 1)
+		 * @return Maximum size of the PNG image, in bytes.
+		 */
+		static size_t pngBufferSize(int w, int h, GcImage::PxFmt pxFmt, int frames = 1);
+
 		/**
 		 * Write a PLTE chunk to a PNG image.
 		 * @param png_ptr	[in] PNG pointer.
@@ -159,15 +183,47 @@ class GcImageWriterPrivate
 		static int gif_addGraphicsControlBlock(GifFileType *gif, int trans_idx, uint16_t iconDelay);
 
 		/**
-		 * Write an ARGB32 image to a GIF.
-		 * This will reduce the image to 256 colors first.
-		 * @param gif		[in] GIF image.
-		 * @param gcImage	[in] GcImage to write.
-		 * @param colorMap	[in] Color map object to use.
+		 * ARGB32 image reduced to 256 colors.
+		 */
+		struct GifQuantizedFrame {
+			std::vector<uint8_t> pixels;	// Color indexes.
+			GifColorType colors[256];	// Palette.
+			int colorCount;			// Number of palette entries used.
+		};
+
+		/**
+		 * Map ARGB32 images to a single palette without quantizing.
+		 * This is only possible if all of the images combined
+		 * use 256 colors or less.
+		 * @param gcImages	[in] Vector of GcImage.
+		 * @param colorMap	[out] Color map object for the shared palette.
+		 * @param frames	[out] Color indexes for each frame. (colors[] isn't used)
+		 * @return True if the images were mapped; false if there are too many colors.
+		 */
+		static bool gif_mapARGB32ImagesToColorMap(const std::vector<const GcImage*> *gcImages,
+							  ColorMapObject *colorMap,
+							  std::vector<GifQuantizedFrame> *frames);
+
+		/**
+		 * Reduce an ARGB32 image to 256 colors.
+		 * This function is reentrant.
+		 * @param gcImage	[in] GcImage to quantize.
+		 * @param frame		[out] Quantized frame.
+		 * @return GIF_OK on success; GIF_ERROR on error.
+		 */
+		static int gif_quantizeARGB32Image(const GcImage *gcImage, GifQuantizedFrame *frame);
+
+		/**
+		 * Reduce multiple ARGB32 images to 256 colors.
+		 * If threadCount > 1, frames are quantized in parallel.
+		 * @param gcImages	[in] Vector of GcImage.
+		 * @param frames	[out] Quantized frames.
+		 * @param threadCount	[in] Maximum number of threads, including the calling thread.
 		 * @return GIF_OK on success; GIF_ERROR on error.
 		 */
-		static int gif_writeARGB32Image(GifFileType *gif,
-				const GcImage *gcImage, ColorMapObject *colorMap);
+		static int gif_quantizeARGB32Images(const std::vector<const GcImage*> *gcImages,
+						    std::vector<GifQuantizedFrame> *frames,
+						    int threadCount);
 #endif /* USE_GIF */
 
 	public:
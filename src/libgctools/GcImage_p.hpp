@@ -14,6 +14,7 @@
 // C includes. (C++ namespace)
 #include <cstdlib>
 // C++ includes.
+#include <memory>
 #include <vector>
 
 class GcImagePrivate
@@ -38,7 +39,13 @@ class GcImagePrivate
 
 		void *imageData;
 		size_t imageData_len;
-		std::vector<uint32_t> palette;
+
+		// Palette. (256 entries, ARGB32)
+		// Palettes aren't modified once they're assigned,
+		// so identical palettes can be shared by multiple
+		// GcImages. (See GcImageLoader::fromCI8().)
+		std::shared_ptr<const std::vector<uint32_t> > palette;
+
 		GcImage::PxFmt pxFmt;
 		int width;
 		int height;
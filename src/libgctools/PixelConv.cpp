@@ -0,0 +1,104 @@
+/***************************************************************************
+ * GameCube Tools Library.                                                 *
+ * PixelConv.cpp: Pixel conversion functions.                              *
+ *                                                                         *
+ * Copyright (c) 2012-2018 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "PixelConv.hpp"
+
+// Byteswapping macros.
+#include "util/byteswap.h"
+
+namespace PixelConv {
+
+/** Dispatch functions. **/
+
+/**
+ * Convert a linear array of big-endian RGB5A3 pixels to ARGB32.
+ * @param dest	[out] ARGB32 buffer.
+ * @param src	[in] RGB5A3 buffer. (big-endian)
+ * @param count	[in] Number of pixels.
+ */
+void RGB5A3_to_ARGB32_line(uint32_t *dest, const uint16_t *src, int count)
+{
+#ifdef GCTOOLS_HAS_SSE2
+	if (cpuflags_has_sse2()) {
+		RGB5A3_to_ARGB32_line_sse2(dest, src, count);
+		return;
+	}
+#endif /* GCTOOLS_HAS_SSE2 */
+	RGB5A3_to_ARGB32_line_c(dest, src, count);
+}
+
+/**
+ * Convert a tiled big-endian RGB5A3 image to a linear ARGB32 image.
+ * RGB5A3 images use 4x4 tiles.
+ * @param dest		[out] ARGB32 image buffer. [must be (tilesX*4)*(tilesY*4) pixels]
+ * @param src		[in] RGB5A3 image buffer. (big-endian)
+ * @param tilesX	[in] Number of horizontal tiles.
+ * @param tilesY	[in] Number of vertical tiles.
+ */
+void RGB5A3_tiled_to_ARGB32(uint32_t *dest, const uint16_t *src, int tilesX, int tilesY)
+{
+#ifdef GCTOOLS_HAS_SSE2
+	if (cpuflags_has_sse2()) {
+		RGB5A3_tiled_to_ARGB32_sse2(dest, src, tilesX, tilesY);
+		return;
+	}
+#endif /* GCTOOLS_HAS_SSE2 */
+	RGB5A3_tiled_to_ARGB32_c(dest, src, tilesX, tilesY);
+}
+
+/**
+ * Convert a linear array of little-endian ARGB4444 pixels to ARGB32.
+ * @param dest	[out] ARGB32 buffer.
+ * @param src	[in] ARGB4444 buffer. (little-endian)
+ * @param count	[in] Number of pixels.
+ */
+void ARGB4444_to_ARGB32_line(uint32_t *dest, const uint16_t *src, int count)
+{
+#ifdef GCTOOLS_HAS_SSE2
+	if (cpuflags_has_sse2()) {
+		ARGB4444_to_ARGB32_line_sse2(dest, src, count);
+		return;
+	}
+#endif /* GCTOOLS_HAS_SSE2 */
+	ARGB4444_to_ARGB32_line_c(dest, src, count);
+}
+
+/** Standard implementations. **/
+
+void RGB5A3_to_ARGB32_line_c(uint32_t *dest, const uint16_t *src, int count)
+{
+	for (; count > 0; count--, dest++, src++) {
+		*dest = RGB5A3_to_ARGB32(be16_to_cpu(*src));
+	}
+}
+
+void RGB5A3_tiled_to_ARGB32_c(uint32_t *dest, const uint16_t *src, int tilesX, int tilesY)
+{
+	const int pitch = tilesX * 4;
+	for (int y = 0; y < tilesY; y++) {
+		for (int x = 0; x < tilesX; x++) {
+			// Convert the tile directly into the image buffer.
+			uint32_t *px_dest = dest + ((y * 4 * pitch) + (x * 4));
+			for (int row = 4; row > 0; row--, src += 4, px_dest += pitch) {
+				px_dest[0] = RGB5A3_to_ARGB32(be16_to_cpu(src[0]));
+				px_dest[1] = RGB5A3_to_ARGB32(be16_to_cpu(src[1]));
+				px_dest[2] = RGB5A3_to_ARGB32(be16_to_cpu(src[2]));
+				px_dest[3] = RGB5A3_to_ARGB32(be16_to_cpu(src[3]));
+			}
+		}
+	}
+}
+
+void ARGB4444_to_ARGB32_line_c(uint32_t *dest, const uint16_t *src, int count)
+{
+	for (; count > 0; count--, dest++, src++) {
+		*dest = ARGB4444_to_ARGB32(le16_to_cpu(*src));
+	}
+}
+
+}
@@ -0,0 +1,114 @@
+/***************************************************************************
+ * GameCube Tools Library.                                                 *
+ * PixelConv.hpp: Pixel conversion functions. (PRIVATE)                    *
+ *                                                                         *
+ * Copyright (c) 2012-2018 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#ifndef __LIBGCTOOLS_PIXELCONV_HPP__
+#define __LIBGCTOOLS_PIXELCONV_HPP__
+
+// C includes.
+#include <stdint.h>
+
+// CPU flags.
+#include "util/cpuflags_x86.h"
+
+namespace PixelConv {
+
+/**
+ * Convert an RGB5A3 pixel to ARGB32.
+ * @param px16 RGB5A3 pixel. (host-endian)
+ * @return ARGB32 pixel.
+ */
+static inline uint32_t RGB5A3_to_ARGB32(uint16_t px16)
+{
+	uint32_t px32 = 0;
+
+	// NOTE: Pixels are byteswapped.
+	if (px16 & 0x8000) {
+		// RGB555: xRRRRRGG GGGBBBBB
+		// ARGB32: AAAAAAAA RRRRRRRR GGGGGGGG BBBBBBBB
+		px32 |= (((px16 << 3) & 0x0000F8) | ((px16 >> 2) & 0x000007));	// B
+		px32 |= (((px16 << 6) & 0x00F800) | ((px16 << 1) & 0x000700));	// G
+		px32 |= (((px16 << 9) & 0xF80000) | ((px16 << 4) & 0x070000));	// R
+		px32 |= 0xFF000000U; // no alpha channel
+	} else {
+		// RGB4A3
+		px32  =  (px16 & 0x000F);	// B
+		px32 |= ((px16 & 0x00F0) << 4);	// G
+		px32 |= ((px16 & 0x0F00) << 8);	// R
+		px32 |= (px32 << 4);		// Copy to the top nybble.
+
+		// Calculate the alpha channel.
+		uint8_t a = ((px16 >> 7) & 0xE0);
+		a |= (a >> 3);
+		a |= (a >> 3);
+
+		// Apply the alpha channel.
+		px32 |= (a << 24);
+	}
+
+	return px32;
+}
+
+/**
+ * Convert an ARGB4444 pixel to ARGB32.
+ * @param px16 ARGB4444 pixel. (host-endian)
+ * @return ARGB32 pixel.
+ */
+static inline uint32_t ARGB4444_to_ARGB32(uint16_t px16)
+{
+	uint32_t px32;
+	px32  =  (px16 & 0x000F);		// B
+	px32 |= ((px16 & 0x00F0) << 4);		// G
+	px32 |= ((px16 & 0x0F00) << 8);		// R
+	px32 |= ((px16 & 0xF000) << 12);	// A
+	px32 |=  (px32 << 4);			// Copy to the top nybble.
+	return px32;
+}
+
+/** Bulk conversion functions. **/
+
+/**
+ * Convert a linear array of big-endian RGB5A3 pixels to ARGB32.
+ * @param dest	[out] ARGB32 buffer.
+ * @param src	[in] RGB5A3 buffer. (big-endian)
+ * @param count	[in] Number of pixels.
+ */
+void RGB5A3_to_ARGB32_line(uint32_t *dest, const uint16_t *src, int count);
+
+/**
+ * Convert a tiled big-endian RGB5A3 image to a linear ARGB32 image.
+ * RGB5A3 images use 4x4 tiles.
+ * @param dest		[out] ARGB32 image buffer. [must be (tilesX*4)*(tilesY*4) pixels]
+ * @param src		[in] RGB5A3 image buffer. (big-endian)
+ * @param tilesX	[in] Number of horizontal tiles.
+ * @param tilesY	[in] Number of vertical tiles.
+ */
+void RGB5A3_tiled_to_ARGB32(uint32_t *dest, const uint16_t *src, int tilesX, int tilesY);
+
+/**
+ * Convert a linear array of little-endian ARGB4444 pixels to ARGB32.
+ * @param dest	[out] ARGB32 buffer.
+ * @param src	[in] ARGB4444 buffer. (little-endian)
+ * @param count	[in] Number of pixels.
+ */
+void ARGB4444_to_ARGB32_line(uint32_t *dest, const uint16_t *src, int count);
+
+/** Internal implementations. (Use the dispatch functions above.) **/
+
+void RGB5A3_to_ARGB32_line_c(uint32_t *dest, const uint16_t *src, int count);
+void RGB5A3_tiled_to_ARGB32_c(uint32_t *dest, const uint16_t *src, int tilesX, int tilesY);
+void ARGB4444_to_ARGB32_line_c(uint32_t *dest, const uint16_t *src, int count);
+
+#ifdef GCTOOLS_HAS_SSE2
+void RGB5A3_to_ARGB32_line_sse2(uint32_t *dest, const uint16_t *src, int count);
+void RGB5A3_tiled_to_ARGB32_sse2(uint32_t *dest, const uint16_t *src, int tilesX, int tilesY);
+void ARGB4444_to_ARGB32_line_sse2(uint32_t *dest, const uint16_t *src, int count);
+#endif /* GCTOOLS_HAS_SSE2 */
+
+}
+
+#endif /* __LIBGCTOOLS_PIXELCONV_HPP__ */
@@ -0,0 +1,147 @@
+/***************************************************************************
+ * GameCube Tools Library.                                                 *
+ * PixelConv_sse2.cpp: Pixel conversion functions. (SSE2-optimized)        *
+ *                                                                         *
+ * Copyright (c) 2012-2018 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "PixelConv.hpp"
+
+#ifdef GCTOOLS_HAS_SSE2
+
+// Byteswapping macros.
+#include "util/byteswap.h"
+
+// SSE2 intrinsics.
+#include <emmintrin.h>
+
+namespace PixelConv {
+
+/**
+ * Convert 8 big-endian RGB5A3 pixels to ARGB32.
+ * @param px	[in] RGB5A3 pixels. (big-endian)
+ * @param lo	[out] ARGB32 pixels 0-3.
+ * @param hi	[out] ARGB32 pixels 4-7.
+ */
+static inline void RGB5A3_to_ARGB32_x8(__m128i px, __m128i &lo, __m128i &hi)
+{
+	const __m128i mask1F = _mm_set1_epi16(0x1F);
+	const __m128i mask0F = _mm_set1_epi16(0x0F);
+	const __m128i mask07 = _mm_set1_epi16(0x07);
+	const __m128i maskFF = _mm_set1_epi16(0xFF);
+
+	// Byteswap the pixels.
+	px = _mm_or_si128(_mm_slli_epi16(px, 8), _mm_srli_epi16(px, 8));
+
+	// 0xFFFF for RGB555 pixels; 0x0000 for RGB4A3 pixels.
+	const __m128i isRGB555 = _mm_srai_epi16(px, 15);
+
+	// RGB555: xRRRRRGG GGGBBBBB
+	__m128i b5 = _mm_and_si128(px, mask1F);
+	__m128i g5 = _mm_and_si128(_mm_srli_epi16(px, 5), mask1F);
+	__m128i r5 = _mm_and_si128(_mm_srli_epi16(px, 10), mask1F);
+	b5 = _mm_or_si128(_mm_slli_epi16(b5, 3), _mm_srli_epi16(b5, 2));
+	g5 = _mm_or_si128(_mm_slli_epi16(g5, 3), _mm_srli_epi16(g5, 2));
+	r5 = _mm_or_si128(_mm_slli_epi16(r5, 3), _mm_srli_epi16(r5, 2));
+
+	// RGB4A3: xAAARRRR GGGGBBBB
+	__m128i b4 = _mm_and_si128(px, mask0F);
+	__m128i g4 = _mm_and_si128(_mm_srli_epi16(px, 4), mask0F);
+	__m128i r4 = _mm_and_si128(_mm_srli_epi16(px, 8), mask0F);
+	__m128i a3 = _mm_and_si128(_mm_srli_epi16(px, 12), mask07);
+	b4 = _mm_or_si128(_mm_slli_epi16(b4, 4), b4);
+	g4 = _mm_or_si128(_mm_slli_epi16(g4, 4), g4);
+	r4 = _mm_or_si128(_mm_slli_epi16(r4, 4), r4);
+	a3 = _mm_or_si128(_mm_or_si128(_mm_slli_epi16(a3, 5), _mm_slli_epi16(a3, 2)),
+			  _mm_srli_epi16(a3, 1));
+
+	// Select the channels for each pixel.
+	const __m128i b = _mm_or_si128(_mm_and_si128(isRGB555, b5), _mm_andnot_si128(isRGB555, b4));
+	const __m128i g = _mm_or_si128(_mm_and_si128(isRGB555, g5), _mm_andnot_si128(isRGB555, g4));
+	const __m128i r = _mm_or_si128(_mm_and_si128(isRGB555, r5), _mm_andnot_si128(isRGB555, r4));
+	const __m128i a = _mm_or_si128(_mm_and_si128(isRGB555, maskFF), _mm_andnot_si128(isRGB555, a3));
+
+	// Interleave the channels into ARGB32.
+	// br: [B, R] in each 16-bit lane; ga: [G, A] in each 16-bit lane.
+	const __m128i br = _mm_or_si128(b, _mm_slli_epi16(r, 8));
+	const __m128i ga = _mm_or_si128(g, _mm_slli_epi16(a, 8));
+	lo = _mm_unpacklo_epi8(br, ga);
+	hi = _mm_unpackhi_epi8(br, ga);
+}
+
+/**
+ * Convert 8 little-endian ARGB4444 pixels to ARGB32.
+ * @param px	[in] ARGB4444 pixels. (little-endian)
+ * @param lo	[out] ARGB32 pixels 0-3.
+ * @param hi	[out] ARGB32 pixels 4-7.
+ */
+static inline void ARGB4444_to_ARGB32_x8(__m128i px, __m128i &lo, __m128i &hi)
+{
+	const __m128i mask0F0F = _mm_set1_epi16(0x0F0F);
+
+	// br: [B, R] in each 16-bit lane; ga: [G, A] in each 16-bit lane.
+	__m128i br = _mm_and_si128(px, mask0F0F);
+	__m128i ga = _mm_and_si128(_mm_srli_epi16(px, 4), mask0F0F);
+
+	// Copy to the top nybble.
+	br = _mm_or_si128(br, _mm_slli_epi16(br, 4));
+	ga = _mm_or_si128(ga, _mm_slli_epi16(ga, 4));
+
+	// Interleave the channels into ARGB32.
+	lo = _mm_unpacklo_epi8(br, ga);
+	hi = _mm_unpackhi_epi8(br, ga);
+}
+
+void RGB5A3_to_ARGB32_line_sse2(uint32_t *dest, const uint16_t *src, int count)
+{
+	for (; count >= 8; count -= 8, dest += 8, src += 8) {
+		__m128i lo, hi;
+		RGB5A3_to_ARGB32_x8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src)), lo, hi);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dest), lo);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + 4), hi);
+	}
+
+	// Remaining pixels.
+	for (; count > 0; count--, dest++, src++) {
+		*dest = RGB5A3_to_ARGB32(be16_to_cpu(*src));
+	}
+}
+
+void RGB5A3_tiled_to_ARGB32_sse2(uint32_t *dest, const uint16_t *src, int tilesX, int tilesY)
+{
+	// Each 4x4 tile is two vectors of 8 pixels.
+	// Each half of a converted vector is one tile row.
+	const int pitch = tilesX * 4;
+	for (int y = 0; y < tilesY; y++) {
+		for (int x = 0; x < tilesX; x++, src += 16) {
+			uint32_t *px_dest = dest + ((y * 4 * pitch) + (x * 4));
+			__m128i row0, row1, row2, row3;
+			RGB5A3_to_ARGB32_x8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src)), row0, row1);
+			RGB5A3_to_ARGB32_x8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 8)), row2, row3);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(px_dest), row0);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(px_dest + pitch), row1);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(px_dest + (pitch * 2)), row2);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(px_dest + (pitch * 3)), row3);
+		}
+	}
+}
+
+void ARGB4444_to_ARGB32_line_sse2(uint32_t *dest, const uint16_t *src, int count)
+{
+	for (; count >= 8; count -= 8, dest += 8, src += 8) {
+		__m128i lo, hi;
+		ARGB4444_to_ARGB32_x8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src)), lo, hi);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dest), lo);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + 4), hi);
+	}
+
+	// Remaining pixels.
+	for (; count > 0; count--, dest++, src++) {
+		*dest = ARGB4444_to_ARGB32(le16_to_cpu(*src));
+	}
+}
+
+}
+
+#endif /* GCTOOLS_HAS_SSE2 */
@@ -24,8 +24,6 @@ SPDX-License-Identifier: MIT
 #define BITS_PER_PRIM_COLOR 5
 #define MAX_PRIM_COLOR      0x1f
 
-static int SortRGBAxis;
-
 typedef struct QuantizedColorType {
     GifByteType RGB[3];
     GifByteType NewColorIndex;
@@ -40,6 +38,13 @@ typedef struct NewColorMapType {
     QuantizedColorType *QuantizedColors;
 } NewColorMapType;
 
+/* Sort key for a QuantizedColorType, computed once per subdivision.
+ * [GCN] Replaces the global SortRGBAxis so this file is reentrant. */
+typedef struct SortEntryType {
+    int Key;
+    QuantizedColorType *QuantizedColor;
+} SortEntryType;
+
 static int SubdivColorMap(NewColorMapType * NewColorSubdiv,
                           unsigned int ColorMapSize,
                           unsigned int *NewColorMapSize);
@@ -201,7 +206,9 @@ SubdivColorMap(NewColorMapType * NewColorSubdiv,
                unsigned int *NewColorMapSize) {
 
     unsigned int i, j, Index = 0;
-    QuantizedColorType *QuantizedColor, **SortArray;
+    int SortRGBAxis = 0;
+    QuantizedColorType *QuantizedColor;
+    SortEntryType *SortArray;
 
     while (ColorMapSize > *NewColorMapSize) {
         /* Find candidate for subdivision: */
@@ -226,15 +233,20 @@ SubdivColorMap(NewColorMapType * NewColorSubdiv,
 
         /* Sort all elements in that entry along the given axis and split at
          * the median.  */
-        SortArray = (QuantizedColorType **)malloc(
-                      sizeof(QuantizedColorType *) * 
+        SortArray = (SortEntryType *)malloc(
+                      sizeof(SortEntryType) *
                       NewColorSubdiv[Index].NumEntries);
         if (SortArray == NULL)
             return GIF_ERROR;
         for (j = 0, QuantizedColor = NewColorSubdiv[Index].QuantizedColors;
              j < NewColorSubdiv[Index].NumEntries && QuantizedColor != NULL;
-             j++, QuantizedColor = QuantizedColor->Pnext)
-            SortArray[j] = QuantizedColor;
+             j++, QuantizedColor = QuantizedColor->Pnext) {
+            /* sort on all axes of the color space! */
+            SortArray[j].Key = QuantizedColor->RGB[SortRGBAxis] * 256 * 256
+                             + QuantizedColor->RGB[(SortRGBAxis+1) % 3] * 256
+                             + QuantizedColor->RGB[(SortRGBAxis+2) % 3];
+            SortArray[j].QuantizedColor = QuantizedColor;
+        }
 
 	/*
 	 * Because qsort isn't stable, this can produce differing 
@@ -248,13 +260,13 @@ SubdivColorMap(NewColorMapType * NewColorSubdiv,
 	 * sorted on only the one axis.
 	 */
         qsort(SortArray, NewColorSubdiv[Index].NumEntries,
-              sizeof(QuantizedColorType *), SortCmpRtn);
+              sizeof(SortEntryType), SortCmpRtn);
 
         /* Relink the sorted list into one: */
         for (j = 0; j < NewColorSubdiv[Index].NumEntries - 1; j++)
-            SortArray[j]->Pnext = SortArray[j + 1];
-        SortArray[NewColorSubdiv[Index].NumEntries - 1]->Pnext = NULL;
-        NewColorSubdiv[Index].QuantizedColors = QuantizedColor = SortArray[0];
+            SortArray[j].QuantizedColor->Pnext = SortArray[j + 1].QuantizedColor;
+        SortArray[NewColorSubdiv[Index].NumEntries - 1].QuantizedColor->Pnext = NULL;
+        NewColorSubdiv[Index].QuantizedColors = QuantizedColor = SortArray[0].QuantizedColor;
         free((char *)SortArray);
 
         /* Now simply add the Counts until we have half of the Count: */
@@ -315,18 +327,10 @@ SubdivColorMap(NewColorMapType * NewColorSubdiv,
 static int
 SortCmpRtn(const void *Entry1,
            const void *Entry2) {
-	   QuantizedColorType *entry1 = (*((QuantizedColorType **) Entry1));
-	   QuantizedColorType *entry2 = (*((QuantizedColorType **) Entry2));
-
-	   /* sort on all axes of the color space! */
-	   int hash1 = entry1->RGB[SortRGBAxis] * 256 * 256
-	   			+ entry1->RGB[(SortRGBAxis+1) % 3] * 256
-				+ entry1->RGB[(SortRGBAxis+2) % 3];
-	   int hash2 = entry2->RGB[SortRGBAxis] * 256 * 256
-	   			+ entry2->RGB[(SortRGBAxis+1) % 3] * 256
-				+ entry2->RGB[(SortRGBAxis+2) % 3];
-
-    return hash1 - hash2;
+	   const SortEntryType *entry1 = (const SortEntryType *)Entry1;
+	   const SortEntryType *entry2 = (const SortEntryType *)Entry2;
+
+    return entry1->Key - entry2->Key;
 }
 
 /* end */
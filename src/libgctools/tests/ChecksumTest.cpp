@@ -0,0 +1,185 @@
+/***************************************************************************
+ * GameCube Tools Library. (tests)                                         *
+ * ChecksumTest.cpp: Checksum algorithm tests.                             *
+ *                                                                         *
+ * Copyright (c) 2012-2018 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+// Compares the optimized checksum functions to
+// simple reference implementations.
+
+#include "Checksum.hpp"
+#include "Checksum_p.hpp"
+using namespace Checksum;
+
+// C includes.
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Test buffer size. Large enough for the longest test
+// plus the maximum misalignment.
+static const int TEST_BUF_SIZE = 4096 + 64;
+
+// Number of failed tests.
+static int failCount = 0;
+
+/**
+ * Fill a buffer with pseudo-random data.
+ * A fixed xorshift generator is used so results are reproducible.
+ * @param buf Buffer.
+ * @param siz Size of buffer.
+ */
+static void fillBuffer(uint8_t *buf, int siz)
+{
+	uint32_t x = 0x2545F491;
+	for (int i = 0; i < siz; i++) {
+		x ^= (x << 13);
+		x ^= (x >> 17);
+		x ^= (x << 5);
+		buf[i] = (uint8_t)(x >> 24);
+	}
+}
+
+/**
+ * Reference CRC-16 implementation. (bitwise)
+ * @param buf Data buffer.
+ * @param siz Length of data buffer.
+ * @param poly Polynomial.
+ * @return Checksum.
+ */
+static uint16_t Crc16_ref(const uint8_t *buf, uint32_t siz, uint16_t poly)
+{
+	uint16_t crc = 0xFFFF;
+	for (; siz != 0; siz--, buf++) {
+		crc ^= *buf;
+		for (int i = 8; i > 0; i--) {
+			if (crc & 1)
+				crc = ((crc >> 1) ^ poly);
+			else
+				crc >>= 1;
+		}
+	}
+	return ~crc;
+}
+
+/**
+ * Report a mismatch.
+ * @param func Function name.
+ * @param offset Buffer offset.
+ * @param len Length.
+ * @param expected Expected value.
+ * @param actual Actual value.
+ */
+static void reportMismatch(const char *func, int offset, int len,
+	uint32_t expected, uint32_t actual)
+{
+	fprintf(stderr, "*** %s: offset %d, length %d: expected 0x%08X, got 0x%08X\n",
+		func, offset, len, expected, actual);
+	failCount++;
+}
+
+/**
+ * Test Crc16() against the reference implementation.
+ * @param buf Test buffer.
+ * @param poly Polynomial.
+ */
+static void testCrc16(const uint8_t *buf, uint16_t poly)
+{
+	static const int lengths[] = {0, 1, 7, 8, 9, 15, 16, 17, 63, 64, 65, 1023, 1024, 1025, 4096};
+	for (int offset = 0; offset < 8; offset++) {
+		for (size_t i = 0; i < sizeof(lengths)/sizeof(lengths[0]); i++) {
+			const int len = lengths[i];
+			const uint16_t expected = Crc16_ref(&buf[offset], len, poly);
+			const uint16_t actual = Crc16(&buf[offset], len, poly);
+			if (expected != actual) {
+				char func[32];
+				snprintf(func, sizeof(func), "Crc16(0x%04X)", poly);
+				reportMismatch(func, offset, len, expected, actual);
+			}
+		}
+	}
+}
+
+#ifdef GCTOOLS_HAS_SSE2
+/**
+ * Test SumWords16_sse2() against SumWords16_c().
+ * @param buf Test buffer.
+ */
+static void testSumWords16(const uint8_t *buf)
+{
+	static const ChkEndian endians[] = {CHKENDIAN_BIG, CHKENDIAN_LITTLE};
+	for (int e = 0; e < 2; e++) {
+		// Offsets are in words, so the buffer is
+		// 2-byte aligned but not 16-byte aligned.
+		for (int offset = 0; offset < 8; offset++) {
+			const uint16_t *const buf16 = reinterpret_cast<const uint16_t*>(buf) + offset;
+			for (int words = 0; words <= 300; words++) {
+				const uint16_t expected = SumWords16_c(buf16, words, endians[e]);
+				const uint16_t actual = SumWords16_sse2(buf16, words, endians[e]);
+				if (expected != actual) {
+					reportMismatch(endians[e] == CHKENDIAN_BIG
+							? "SumWords16_sse2(BE)" : "SumWords16_sse2(LE)",
+						offset * 2, words, expected, actual);
+				}
+			}
+		}
+	}
+}
+
+/**
+ * Test SumBytes32_sse2() against SumBytes32_c().
+ * @param buf Test buffer.
+ */
+static void testSumBytes32(const uint8_t *buf)
+{
+	for (int offset = 0; offset < 16; offset++) {
+		for (int len = 0; len <= 300; len++) {
+			const uint32_t expected = SumBytes32_c(&buf[offset], len);
+			const uint32_t actual = SumBytes32_sse2(&buf[offset], len);
+			if (expected != actual) {
+				reportMismatch("SumBytes32_sse2", offset, len, expected, actual);
+			}
+		}
+	}
+
+	// Large buffer. This checks that the
+	// byte accumulators don't overflow.
+	const uint32_t expected = SumBytes32_c(buf, 4096);
+	const uint32_t actual = SumBytes32_sse2(buf, 4096);
+	if (expected != actual) {
+		reportMismatch("SumBytes32_sse2", 0, 4096, expected, actual);
+	}
+}
+#endif /* GCTOOLS_HAS_SSE2 */
+
+int main(void)
+{
+	// 16-byte aligned test buffer.
+	alignas(16) uint8_t testBuf[TEST_BUF_SIZE];
+	fillBuffer(testBuf, sizeof(testBuf));
+
+	testCrc16(testBuf, CRC16_POLY_CCITT);
+	// Non-CCITT polynomial. (CRC-16/ARC, reflected)
+	testCrc16(testBuf, 0xA001);
+
+#ifdef GCTOOLS_HAS_SSE2
+	if (cpuflags_has_sse2()) {
+		testSumWords16(testBuf);
+		testSumBytes32(testBuf);
+	} else {
+		printf("SSE2 is not supported on this CPU; skipping SSE2 tests.\n");
+	}
+#else /* !GCTOOLS_HAS_SSE2 */
+	printf("SSE2 is not available on this platform; skipping SSE2 tests.\n");
+#endif /* GCTOOLS_HAS_SSE2 */
+
+	if (failCount > 0) {
+		fprintf(stderr, "*** %d test(s) failed.\n", failCount);
+		return EXIT_FAILURE;
+	}
+
+	printf("All checksum tests passed.\n");
+	return EXIT_SUCCESS;
+}
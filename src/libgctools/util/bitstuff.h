@@ -9,6 +9,8 @@
 #ifndef __LIBGCTOOLS_BITSTUFF_H__
 #define __LIBGCTOOLS_BITSTUFF_H__
 
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -64,6 +66,20 @@ static inline unsigned int popcount(unsigned int x)
 #endif
 }
 
+/**
+ * Population count function. (64-bit)
+ * @param x Value.
+ * @return Population count.
+ */
+static inline unsigned int popcount64(uint64_t x)
+{
+#if defined(__GNUC__)
+	return __builtin_popcountll(x);
+#else
+	return popcount((unsigned int)x) + popcount((unsigned int)(x >> 32));
+#endif
+}
+
 /**
  * Check if a value is a power of 2. (also must be non-zero)
  * @param x Value.
@@ -0,0 +1,78 @@
+/***************************************************************************
+ * GameCube Tools Library.                                                 *
+ * cpuflags_x86.h: x86 CPU feature detection.                              *
+ *                                                                         *
+ * Copyright (c) 2018 by David Korth.                                      *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#ifndef __LIBGCTOOLS_UTIL_CPUFLAGS_X86_H__
+#define __LIBGCTOOLS_UTIL_CPUFLAGS_X86_H__
+
+/* Get the system byte order. */
+#include "byteorder.h"
+
+/**
+ * GCTOOLS_HAS_SSE2 is defined if SSE2-optimized
+ * functions should be compiled in.
+ * SSE2 is only used on little-endian x86 and amd64.
+ */
+#if (defined(__i386__) || defined(_M_IX86) || \
+     defined(__x86_64__) || defined(_M_X64)) && \
+    SYS_BYTEORDER == SYS_LIL_ENDIAN
+# define GCTOOLS_HAS_SSE2 1
+#endif
+
+#ifdef GCTOOLS_HAS_SSE2
+
+#if !(defined(__x86_64__) || defined(_M_X64))
+/* i386: SSE2 must be checked at runtime. */
+# if defined(_MSC_VER)
+#  include <intrin.h>
+# elif defined(__GNUC__)
+#  include <cpuid.h>
+# endif
+#endif
+
+#ifdef _MSC_VER
+# ifndef inline
+#  define inline __inline
+# endif /* !inline */
+#endif /* _MSC_VER */
+
+/**
+ * Check if the CPU supports SSE2.
+ * @return Non-zero if SSE2 is supported.
+ */
+static inline int cpuflags_has_sse2(void)
+{
+#if defined(__x86_64__) || defined(_M_X64)
+	/* SSE2 is always supported on amd64. */
+	return 1;
+#else
+	/* Check CPUID. The result is cached, since
+	 * it won't change while the program is running. */
+	static int sse2 = -1;
+	if (sse2 < 0) {
+		/* CPUID function 1: EDX bit 26 == SSE2 */
+#if defined(_MSC_VER)
+		int regs[4];
+		__cpuid(regs, 1);
+		sse2 = !!(regs[3] & (1 << 26));
+#elif defined(__GNUC__)
+		unsigned int eax, ebx, ecx, edx;
+		if (__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+			sse2 = !!(edx & (1 << 26));
+		else
+			sse2 = 0;
+#else
+		sse2 = 0;
+#endif
+	}
+	return sse2;
+#endif
+}
+
+#endif /* GCTOOLS_HAS_SSE2 */
+
+#endif /* __LIBGCTOOLS_UTIL_CPUFLAGS_X86_H__ */
@@ -34,6 +34,9 @@ CardPrivate::CardPrivate(Card *q, uint32_t blockSize,
 	, errors(QFlags<Card::Error>())
 	, file(nullptr)
 	, filesize(0)
+	, mapFileRO(nullptr)
+	, mapData(nullptr)
+	, mapSize(0)
 	, readOnly(true)
 	, canMakeWritable(false)
 	, encoding(Card::Encoding::Unknown)
@@ -72,6 +75,7 @@ CardPrivate::~CardPrivate()
 	lstFiles.clear();
 
 	if (file) {
+		unmapFile();
 		file->close();
 		delete file;
 	}
@@ -143,6 +147,9 @@ int CardPrivate::open(const QString &filename, QIODevice::OpenModeFlag openMode)
 		this->errors |= Card::MCE_SZ_NON_POW2;
 	}
 
+	// Map the card image.
+	mapFile();
+
 	// Card is open.
 	return 0;
 }
@@ -158,6 +165,7 @@ void CardPrivate::close(void)
 		return;
 	}
 
+	unmapFile();
 	file->close();
 	delete file;
 	file = nullptr;
@@ -170,6 +178,75 @@ void CardPrivate::close(void)
 	freeBlocks = 0;
 }
 
+/**
+ * Memory-map the card image.
+ * This must be called again if the file is resized.
+ * If mapping fails, QFile will be used for reads.
+ */
+void CardPrivate::mapFile(void)
+{
+	unmapFile();
+	if (!file)
+		return;
+
+	const qint64 size = file->size();
+	if (size <= 0)
+		return;
+
+	// Map the image using a read-only QFile.
+	// QFile::map() uses the open mode for the page protection,
+	// so mapping the read/write QFile would allow writes.
+	// NOTE: The mapping is shared, so writes done through
+	// the read/write QFile are visible once it's flushed.
+	mapFileRO = new QFile(file->fileName());
+	if (!mapFileRO->open(QIODevice::ReadOnly)) {
+		// Unable to open the file. QFile will be used for reads.
+		delete mapFileRO;
+		mapFileRO = nullptr;
+		return;
+	}
+
+	mapData = mapFileRO->map(0, size);
+	mapSize = (mapData ? size : 0);
+	if (!mapData) {
+		delete mapFileRO;
+		mapFileRO = nullptr;
+	}
+}
+
+/**
+ * Unmap the card image.
+ */
+void CardPrivate::unmapFile(void)
+{
+	if (mapData) {
+		mapFileRO->unmap(mapData);
+		mapData = nullptr;
+		mapSize = 0;
+	}
+	if (mapFileRO) {
+		mapFileRO->close();
+		delete mapFileRO;
+		mapFileRO = nullptr;
+	}
+}
+
+/**
+ * Can a range of the card image be read from the mapping?
+ *
+ * NOTE: Only the mapped size is checked. This function is
+ * called for every block, so the file size isn't rechecked.
+ * If another program truncates the card image, reading
+ * past the new end of the file will raise SIGBUS.
+ *
+ * @param end End of the range, in bytes.
+ * @return True if the range is mapped.
+ */
+bool CardPrivate::isMappedRange(qint64 end) const
+{
+	return (mapData && end <= mapSize);
+}
+
 /**
  * Find the most common byte in a block of data.
  * This is useful for determining header garbage.
@@ -318,10 +395,12 @@ int Card::setReadOnly(bool readOnly)
 
 	// TODO: Validate that this file is the same as the one we had before.
 	// TODO: Atomic swap of d->file and tmp_file.
+	d->unmapFile();
 	std::swap(d->file, tmp_file);
 	d->readOnly = readOnly;
 	tmp_file->close();
 	delete tmp_file;
+	d->mapFile();
 	return 0;
 }
 
@@ -622,6 +701,12 @@ int Card::readBlock(void *buf, int siz, uint16_t blockIdx)
 
 	// Read the specified block.
 	const qint64 pos = ((qint64)blockIdx * d->blockSize) + d->headerSize;
+	if (d->isMappedRange(pos + d->blockSize)) {
+		// Card image is mapped.
+		memcpy(buf, &d->mapData[pos], d->blockSize);
+		return d->blockSize;
+	}
+
 	if (!d->file->seek(pos))
 		return -EIO;	// TODO: Proper error code?
 	int ret = (int)d->file->read((char*)buf, d->blockSize);
@@ -655,10 +740,168 @@ int Card::writeBlock(const void *buf, int siz, uint16_t blockIdx)
 		return -EIO;    // TODO: Proper error code?
 	// TODO: Check for errors?
 	int ret = (int)d->file->write((char*)buf, d->blockSize);
+	if (d->mapData) {
+		// Make sure the data is visible in the mapping.
+		d->file->flush();
+	}
 	return (ret >= 0 ? ret : -EIO);
 }
 
-// TODO: Add readBlocks() and writeBlocks() functions?
+/**
+ * Is the card image memory-mapped?
+ * If it is, blockPtr() can be used to access blocks directly.
+ * @return True if mapped; false if not.
+ */
+bool Card::isMapped(void) const
+{
+	Q_D(const Card);
+	return (d->mapData != nullptr);
+}
+
+/**
+ * Get a pointer to a block in the memory-mapped card image.
+ *
+ * The pointer is valid until the card is closed or its
+ * read-only status is changed. The block data must not
+ * be modified; use writeBlock() instead.
+ *
+ * NOTE: The card image isn't locked. If another program
+ * truncates the image, accessing the pointer will crash.
+ *
+ * @param blockIdx Block index.
+ * @return Pointer to the block data, or nullptr if the card isn't mapped or blockIdx is out of range.
+ */
+const uint8_t *Card::blockPtr(uint16_t blockIdx) const
+{
+	Q_D(const Card);
+	if (!d->mapData)
+		return nullptr;
+
+	const qint64 pos = ((qint64)blockIdx * d->blockSize) + d->headerSize;
+	if (!d->isMappedRange(pos + d->blockSize))
+		return nullptr;
+	return &d->mapData[pos];
+}
+
+/**
+ * Get the length of a run of physically contiguous blocks.
+ * @param blockIdxs Block indexes.
+ * @param start Index of the first block in the run.
+ * @return Number of contiguous blocks starting at blockIdxs[start].
+ */
+static inline int contiguousRunLength(const QVector<uint16_t> &blockIdxs, int start)
+{
+	const uint16_t first = blockIdxs.at(start);
+	const int count = blockIdxs.size();
+	int runLen = 1;
+	while (start + runLen < count &&
+	       blockIdxs.at(start + runLen) == (uint16_t)(first + runLen))
+	{
+		runLen++;
+	}
+	return runLen;
+}
+
+/**
+ * Read multiple blocks.
+ * Runs of physically contiguous blocks are read
+ * using a single read() call.
+ * @param buf Buffer to read the block data into.
+ * @param siz Size of buffer. (Must be >= blockSize * blockIdxs.size().)
+ * @param blockIdxs Block indexes, in buffer order.
+ * @return Bytes read on success; negative POSIX error code on error.
+ */
+int Card::readBlocks(void *buf, int siz, const QVector<uint16_t> &blockIdxs)
+{
+	Q_D(Card);
+	if (!isOpen())
+		return -EBADF;
+
+	const int count = blockIdxs.size();
+	if (siz < count * (int)d->blockSize)
+		return -EINVAL;
+	else if (count == 0)
+		return 0;
+
+	uint8_t *bufPtr = static_cast<uint8_t*>(buf);
+	int total = 0;
+	for (int i = 0; i < count; ) {
+		const int runLen = contiguousRunLength(blockIdxs, i);
+		const qint64 pos = ((qint64)blockIdxs.at(i) * d->blockSize) + d->headerSize;
+		const int runSize = runLen * d->blockSize;
+
+		if (d->isMappedRange(pos + runSize)) {
+			// Card image is mapped.
+			memcpy(bufPtr, &d->mapData[pos], runSize);
+		} else {
+			if (!d->file->seek(pos))
+				return -EIO;	// TODO: Proper error code?
+			const int ret = (int)d->file->read((char*)bufPtr, runSize);
+			if (ret < 0)
+				return -EIO;
+			else if (ret != runSize)
+				return total + ret;	// Short read.
+		}
+
+		bufPtr += runSize;
+		total += runSize;
+		i += runLen;
+	}
+
+	return total;
+}
+
+/**
+ * Write multiple blocks.
+ * Runs of physically contiguous blocks are written
+ * using a single write() call.
+ * @param buf Buffer containing the data to write.
+ * @param siz Size of buffer. (Must be >= blockSize * blockIdxs.size().)
+ * @param blockIdxs Block indexes, in buffer order.
+ * @return Bytes written on success; negative POSIX error code on error.
+ */
+int Card::writeBlocks(const void *buf, int siz, const QVector<uint16_t> &blockIdxs)
+{
+	Q_D(Card);
+	if (!isOpen())
+		return -EBADF;
+
+	const int count = blockIdxs.size();
+	if (siz < count * (int)d->blockSize)
+		return -EINVAL;
+	else if (count == 0)
+		return 0;
+
+	// Make sure the card isn't read-only.
+	if (d->readOnly)
+		return -EROFS;
+
+	const uint8_t *bufPtr = static_cast<const uint8_t*>(buf);
+	int total = 0;
+	for (int i = 0; i < count; ) {
+		const int runLen = contiguousRunLength(blockIdxs, i);
+		const qint64 pos = ((qint64)blockIdxs.at(i) * d->blockSize) + d->headerSize;
+		const int runSize = runLen * d->blockSize;
+
+		if (!d->file->seek(pos))
+			return -EIO;	// TODO: Proper error code?
+		const int ret = (int)d->file->write((const char*)bufPtr, runSize);
+		if (ret < 0)
+			return -EIO;
+		else if (ret != runSize)
+			return total + ret;	// Short write.
+
+		bufPtr += runSize;
+		total += runSize;
+		i += runLen;
+	}
+
+	if (d->mapData) {
+		// Make sure the data is visible in the mapping.
+		d->file->flush();
+	}
+	return total;
+}
 
 /** File management **/
 
@@ -17,6 +17,7 @@
 #include <QtCore/QObject>
 #include <QtCore/QString>
 #include <QtCore/QTextCodec>
+#include <QtCore/QVector>
 #include <QtGui/QColor>
 
 class File;
@@ -316,6 +317,50 @@ class Card : public QObject
 		 */
 		int writeBlock(const void *buf, int siz, uint16_t blockIdx);
 
+		/**
+		 * Read multiple blocks.
+		 * Runs of physically contiguous blocks are read
+		 * using a single read() call.
+		 * @param buf Buffer to read the block data into.
+		 * @param siz Size of buffer. (Must be >= blockSize * blockIdxs.size().)
+		 * @param blockIdxs Block indexes, in buffer order.
+		 * @return Bytes read on success; negative POSIX error code on error.
+		 */
+		int readBlocks(void *buf, int siz, const QVector<uint16_t> &blockIdxs);
+
+		/**
+		 * Write multiple blocks.
+		 * Runs of physically contiguous blocks are written
+		 * using a single write() call.
+		 * @param buf Buffer containing the data to write.
+		 * @param siz Size of buffer. (Must be >= blockSize * blockIdxs.size().)
+		 * @param blockIdxs Block indexes, in buffer order.
+		 * @return Bytes written on success; negative POSIX error code on error.
+		 */
+		int writeBlocks(const void *buf, int siz, const QVector<uint16_t> &blockIdxs);
+
+		/**
+		 * Is the card image memory-mapped?
+		 * If it is, blockPtr() can be used to access blocks directly.
+		 * @return True if mapped; false if not.
+		 */
+		bool isMapped(void) const;
+
+		/**
+		 * Get a pointer to a block in the memory-mapped card image.
+		 *
+		 * The pointer is valid until the card is closed or its
+		 * read-only status is changed. The block data must not
+		 * be modified; use writeBlock() instead.
+		 *
+		 * NOTE: The card image isn't locked. If another program
+		 * truncates the image, accessing the pointer will crash.
+		 *
+		 * @param blockIdx Block index.
+		 * @return Pointer to the block data, or nullptr if the card isn't mapped or blockIdx is out of range.
+		 */
+		const uint8_t *blockPtr(uint16_t blockIdx) const;
+
 		/** File management **/
 	signals:
 		/**
@@ -57,6 +57,15 @@ class CardPrivate
 		QString filename;
 		QFile *file;
 		quint64 filesize;
+
+		// Memory-mapped card image.
+		// nullptr if the image couldn't be mapped,
+		// in which case QFile is used for all reads.
+		// The image is mapped read-only using a separate
+		// QFile, so the mapping can never be written to.
+		QFile *mapFileRO;
+		uchar *mapData;
+		qint64 mapSize;
 		bool readOnly;
 		bool canMakeWritable;	// subclass should set this
 
@@ -136,6 +145,31 @@ class CardPrivate
 		 */
 		void close(void);
 
+		/**
+		 * Memory-map the card image.
+		 * This must be called again if the file is resized.
+		 * If mapping fails, QFile will be used for reads.
+		 */
+		void mapFile(void);
+
+		/**
+		 * Unmap the card image.
+		 */
+		void unmapFile(void);
+
+		/**
+		 * Can a range of the card image be read from the mapping?
+		 *
+		 * NOTE: Only the mapped size is checked. This function is
+		 * called for every block, so the file size isn't rechecked.
+		 * If another program truncates the card image, reading
+		 * past the new end of the file will raise SIGBUS.
+		 *
+		 * @param end End of the range, in bytes.
+		 * @return True if the range is mapped.
+		 */
+		bool isMappedRange(qint64 end) const;
+
 		/**
 		 * Find the most common byte in a block of data.
 		 * This is useful for determining header garbage.
@@ -14,12 +14,14 @@
 #include "GcImage.hpp"
 #include "GcToolsQt.hpp"
 #include "GcImageWriter.hpp"
+#include "FileImages.hpp"
 
 // C includes. (C++ namespace)
 #include <cerrno>
 #include <cassert>
 
 // C++ includes.
+#include <algorithm>
 #include <string>
 #include <vector>
 using std::string;
@@ -45,8 +47,12 @@ FilePrivate::FilePrivate(File *q, Card *card)
 	, card(card)
 	, mode(0)
 	, gcBanner(nullptr)
+	, imagesLoaded(false)
 	, iconAnimMode(0)
+	, iconInfoCount(0)
+	, iconInfoLoaded(false)
 	, lostFile(false)
+	, checksumValid(false)
 { }
 
 FilePrivate::~FilePrivate()
@@ -101,14 +107,228 @@ QByteArray FilePrivate::loadFileData(void)
 	// FIXME: Optimize blockSize multiplication by using shifts.
 	fileData.resize(this->size() * blockSize);
 
-	uint8_t *fileDataPtr = (uint8_t*)fileData.data();
-	for (int i = 0; i < this->size(); i++, fileDataPtr += blockSize) {
-		const uint16_t physBlockAddr = fileBlockAddrToPhysBlockAddr(i);
-		card->readBlock(fileDataPtr, blockSize, physBlockAddr);
-	}
+	// Read all of the blocks at once.
+	card->readBlocks(fileData.data(), fileData.size(), fatEntries);
 	return fileData;
 }
 
+/**
+ * Write ranges of data to the file.
+ * Only blocks that have changed are written.
+ * @param data Data to write.
+ * @param dataAddress File address corresponding to data[0].
+ * @param ranges Ranges to write. Must not start before dataAddress.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int FilePrivate::writeRanges(const uint8_t *data, uint32_t dataAddress,
+			     const QVector<File::WriteRange> &ranges)
+{
+	const uint32_t blockSize = card->blockSize();
+	const uint32_t fileSize = (uint32_t)this->size() * blockSize;
+
+	// Find the file blocks covered by the ranges.
+	vector<int> fileBlocks;
+	foreach (const File::WriteRange &range, ranges) {
+		// Make sure address + length <= file size.
+		// NOTE: Written this way to prevent overflow.
+		if (range.address < dataAddress ||
+		    range.address > fileSize ||
+		    range.length > fileSize - range.address)
+		{
+			return -ERANGE;
+		} else if (range.length == 0) {
+			continue;
+		}
+
+		const int firstBlock = (int)(range.address / blockSize);
+		const int lastBlock = (int)((range.address + range.length - 1) / blockSize);
+		for (int i = firstBlock; i <= lastBlock; i++) {
+			fileBlocks.push_back(i);
+		}
+	}
+	if (fileBlocks.empty()) {
+		// Nothing to write.
+		return 0;
+	}
+	std::sort(fileBlocks.begin(), fileBlocks.end());
+	fileBlocks.erase(std::unique(fileBlocks.begin(), fileBlocks.end()), fileBlocks.end());
+
+	const int blockCount = (int)fileBlocks.size();
+	QVector<uint16_t> physBlockIdxs;
+	physBlockIdxs.reserve(blockCount);
+	for (int i = 0; i < blockCount; i++) {
+		if (fileBlocks[i] >= fatEntries.size())
+			return -EIO;
+		physBlockIdxs.append(fatEntries.at(fileBlocks[i]));
+	}
+
+	// Get the current block contents.
+	// Mapped blocks are compared in place.
+	// Blocks that aren't mapped are read from the card.
+	vector<const uint8_t*> curBlocks(blockCount);
+	vector<int> unmappedBlocks;
+	QVector<uint16_t> unmappedBlockIdxs;
+	for (int i = 0; i < blockCount; i++) {
+		curBlocks[i] = card->blockPtr(physBlockIdxs.at(i));
+		if (!curBlocks[i]) {
+			unmappedBlocks.push_back(i);
+			unmappedBlockIdxs.append(physBlockIdxs.at(i));
+		}
+	}
+	vector<uint8_t> curData;
+	if (!unmappedBlocks.empty()) {
+		curData.resize(unmappedBlocks.size() * blockSize);
+		int ret = card->readBlocks(curData.data(), (int)curData.size(), unmappedBlockIdxs);
+		if (ret < 0)
+			return ret;
+		else if (ret != (int)curData.size())
+			return -EIO;
+		for (size_t j = 0; j < unmappedBlocks.size(); j++) {
+			curBlocks[unmappedBlocks[j]] = &curData[j * blockSize];
+		}
+	}
+
+	// Build the new contents of the blocks.
+	vector<uint8_t> newData(blockCount * blockSize);
+	for (int i = 0; i < blockCount; i++) {
+		memcpy(&newData[i * blockSize], curBlocks[i], blockSize);
+	}
+	foreach (const File::WriteRange &range, ranges) {
+		uint32_t address = range.address;
+		const uint32_t rangeEnd = range.address + range.length;
+		while (address < rangeEnd) {
+			// Part of this block covered by the range.
+			const int fileBlock = (int)(address / blockSize);
+			const uint32_t blockAddr = (uint32_t)fileBlock * blockSize;
+			const uint32_t end = (rangeEnd < (blockAddr + blockSize)
+				? rangeEnd
+				: (blockAddr + blockSize));
+			const int i = (int)(std::lower_bound(fileBlocks.begin(), fileBlocks.end(), fileBlock)
+					- fileBlocks.begin());
+			memcpy(&newData[i * blockSize + (address - blockAddr)],
+				data + (address - dataAddress), end - address);
+			address = end;
+		}
+	}
+
+	// Keep only the blocks that have changed.
+	QVector<uint16_t> dirtyBlockIdxs;
+	size_t pos = 0;
+	for (int i = 0; i < blockCount; i++) {
+		if (!memcmp(curBlocks[i], &newData[i * blockSize], blockSize)) {
+			// Block hasn't changed.
+			continue;
+		}
+
+		// Block has changed.
+		if (pos != i * blockSize) {
+			memmove(&newData[pos], &newData[i * blockSize], blockSize);
+		}
+		pos += blockSize;
+		dirtyBlockIdxs.append(physBlockIdxs.at(i));
+	}
+
+	if (dirtyBlockIdxs.isEmpty()) {
+		// Nothing has changed.
+		return 0;
+	}
+	newData.resize(pos);
+
+	// The checksums will need to be recalculated.
+	checksumValid = false;
+
+	// Write the blocks that have changed.
+	// Physically contiguous blocks are written in a single write() call.
+	int ret = card->writeBlocks(newData.data(), (int)newData.size(), dirtyBlockIdxs);
+	if (ret < 0)
+		return ret;
+	else if (ret != (int)newData.size())
+		return -EIO;
+
+	// FIXME: Trigger card metadata update.
+	// Data written successfully.
+	return 0;
+}
+
+/**
+ * Get a pointer to the file data in the memory-mapped card image.
+ * This is only possible if the card is mapped and the
+ * file's blocks are physically contiguous.
+ * @return Pointer to the file data, or nullptr if not available.
+ */
+const uint8_t *FilePrivate::mappedFileData(void) const
+{
+	if (fatEntries.isEmpty() || this->size() > card->totalUserBlocks())
+		return nullptr;
+
+	const int count = fatEntries.size();
+	const uint16_t firstBlock = fatEntries.at(0);
+	for (int i = 1; i < count; i++) {
+		if (fatEntries.at(i) != (uint16_t)(firstBlock + i)) {
+			// Not contiguous.
+			return nullptr;
+		}
+	}
+
+	// Make sure the last block is mapped, too.
+	if (!card->blockPtr(firstBlock + count - 1))
+		return nullptr;
+	return card->blockPtr(firstBlock);
+}
+
+/**
+ * Write the file data to a QIODevice.
+ * Contiguous runs of blocks in the memory-mapped card
+ * image are written directly from the mapping, so the
+ * file data isn't copied into a temporary buffer.
+ * @param qioDevice QIODevice to write the data to.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int FilePrivate::writeFileData(QIODevice *qioDevice)
+{
+	const int blockSize = card->blockSize();
+	const int count = fatEntries.size();
+	if (this->size() > card->totalUserBlocks()) {
+		// File is larger than the card.
+		// This shouldn't happen...
+		return -EIO;
+	}
+
+	for (int i = 0; i < count; ) {
+		// Find the next run of physically contiguous blocks.
+		const uint16_t firstBlock = fatEntries.at(i);
+		int runLen = 1;
+		while (i + runLen < count &&
+		       fatEntries.at(i + runLen) == (uint16_t)(firstBlock + runLen))
+		{
+			runLen++;
+		}
+		const qint64 runSize = (qint64)runLen * blockSize;
+
+		qint64 ret;
+		const uint8_t *runData = card->blockPtr(firstBlock);
+		if (runData && card->blockPtr(firstBlock + runLen - 1)) {
+			// Run is mapped. Write it directly.
+			ret = qioDevice->write(reinterpret_cast<const char*>(runData), runSize);
+		} else {
+			// Run isn't mapped. Read it from the card.
+			QByteArray runBuf;
+			runBuf.resize((int)runSize);
+			if (card->readBlocks(runBuf.data(), runBuf.size(), fatEntries.mid(i, runLen)) != runBuf.size())
+				return -EIO;
+			ret = qioDevice->write(runBuf);
+		}
+
+		if (ret != runSize) {
+			// Error writing the file data.
+			return -EIO;
+		}
+		i += runLen;
+	}
+
+	return 0;
+}
+
 /**
  * Read the specified range from the file.
  * @param blockStart First block.
@@ -137,11 +357,8 @@ QByteArray FilePrivate::readBlocks(uint16_t blockStart, int len)
 	QByteArray blockData;
 	blockData.resize(len * blockSize);
 
-	uint8_t *blockDataPtr = (uint8_t*)blockData.data();
-	for (int i = 0; i < len; i++, blockDataPtr += blockSize) {
-		const uint16_t physBlockAddr = fileBlockAddrToPhysBlockAddr(i);
-		card->readBlock(blockDataPtr, blockSize, physBlockAddr);
-	}
+	// Read all of the blocks at once.
+	card->readBlocks(blockData.data(), blockData.size(), fatEntries.mid(blockStart, len));
 	return blockData;
 }
 
@@ -240,43 +457,157 @@ QString FilePrivate::decodeText_SJISorCP1252(const char *str, int len)
 /** Images **/
 
 /**
- * Load the banner and icon images.
+ * Reset the banner and icon images.
+ * They will be loaded on first use.
+ */
+void FilePrivate::resetImages(void)
+{
+	delete gcBanner;
+	gcBanner = nullptr;
+	qDeleteAll(gcIcons);
+	gcIcons.clear();
+
+	banner = QPixmap();
+	icons.clear();
+	imagesLoaded = false;
+
+	iconSpeed.clear();
+	iconAnimMode = 0;
+	iconInfoCount = 0;
+	iconInfoLoaded = false;
+}
+
+/**
+ * Load the banner and icon images if they haven't been loaded yet.
+ * Called by the image accessors; subclasses don't need to call this.
  * TODO: Move to File?
  */
 void FilePrivate::loadImages(void)
 {
-	// Load the banner.
+	if (imagesLoaded)
+		return;
+	imagesLoaded = true;
+
+	// Load the banner and icons.
+	// QPixmaps are converted on first use.
 	this->gcBanner = loadBannerImage();
-	if (gcBanner) {
-		// Set the new banner image.
+	this->gcIcons = loadIconImages();
+	banner = QPixmap();
+	icons.clear();
+	icons.resize(gcIcons.size());
+}
+
+/**
+ * Get the banner image as a QPixmap.
+ * The QPixmap is converted on first use.
+ * @return Banner image, or null QPixmap on error.
+ */
+QPixmap FilePrivate::bannerPixmap(void)
+{
+	loadImages();
+	if (banner.isNull() && gcBanner) {
 		QImage qBanner = gcImageToQImage(gcBanner);
 		if (!qBanner.isNull())
 			banner = QPixmap::fromImage(qBanner);
-		else
-			banner = QPixmap();
-	} else {
-		// No banner image.
-		banner = QPixmap();
 	}
+	return banner;
+}
 
-	// Load the icons.
-	this->gcIcons = loadIconImages();
-	icons.clear();
-	icons.reserve(gcIcons.size());
-	foreach (GcImage *gcIcon, gcIcons) {
-		if (gcIcon) {
-			QImage qIcon = gcImageToQImage(gcIcon);
-			if (!qIcon.isNull())
-				icons.append(QPixmap::fromImage(qIcon));
-			else
-				icons.append(QPixmap());
-		} else {
-			// No icon image.
-			icons.append(QPixmap());
+/**
+ * Get an icon image as a QPixmap.
+ * The QPixmap is converted on first use.
+ * @param idx Icon number.
+ * @return Icon image, or null QPixmap on error.
+ */
+QPixmap FilePrivate::iconPixmap(int idx)
+{
+	loadImages();
+	if (idx < 0 || idx >= gcIcons.size())
+		return QPixmap();
+
+	QPixmap &icon = icons[idx];
+	if (icon.isNull() && gcIcons.at(idx)) {
+		QImage qIcon = gcImageToQImage(gcIcons.at(idx));
+		if (!qIcon.isNull())
+			icon = QPixmap::fromImage(qIcon);
+	}
+	return icon;
+}
+
+/**
+ * Load the icon animation metadata if it hasn't been loaded yet.
+ * This uses loadIconInfo() if possible, so the icons
+ * don't have to be decoded to set up the animation.
+ */
+void FilePrivate::initIconInfo(void)
+{
+	if (iconInfoLoaded)
+		return;
+	iconInfoLoaded = true;
+
+	if (!loadIconInfo()) {
+		// The icons must be loaded to get the metadata.
+		// NOTE: loadIconImages() sets iconSpeed and iconAnimMode.
+		loadImages();
+		iconInfoCount = gcIcons.size();
+	}
+}
+
+/**
+ * Load the icon animation metadata without decoding the icons.
+ * This must set iconSpeed, iconAnimMode, and iconInfoCount.
+ * iconInfoCount must match the number of icons
+ * that loadIconImages() would return.
+ * @return True on success; false if the icons must be loaded.
+ */
+bool FilePrivate::loadIconInfo(void)
+{
+	// Default implementation: The icons must be loaded.
+	return false;
+}
+
+/**
+ * Get the banner and icon images.
+ * The images are loaded if necessary.
+ * NOTE: The GcImages in images are owned by this FilePrivate.
+ * @param images	[out] FileImages. (should be non-owning)
+ * @param banner	[in] If true, get the banner image.
+ * @param icons		[in] If true, get the icon images.
+ */
+void FilePrivate::getImages(FileImages *images, bool banner, bool icons) const
+{
+	loadImages();
+	initIconInfo();
+	if (banner) {
+		images->gcBanner = gcBanner;
+	}
+	if (icons) {
+		images->gcIcons.resize(gcIcons.size());
+		images->iconDelays.resize(gcIcons.size());
+		for (int i = 0; i < gcIcons.size(); i++) {
+			images->gcIcons[i] = gcIcons.at(i);
+			images->iconDelays[i] = (i < iconSpeed.size() ? iconSpeed.at(i) : 0);
 		}
+		images->iconAnimMode = (iconAnimMode & 0x4);
 	}
 }
 
+/**
+ * Copy the raw banner and icon data without decoding the images.
+ * The returned FileImages decodes the images in decode(),
+ * so they can be decoded on a worker thread.
+ * @param banner	[in] If true, copy the banner data.
+ * @param icons		[in] If true, copy the icon data.
+ * @return FileImages (caller must delete it), or nullptr if not supported.
+ */
+FileImages *FilePrivate::copyRawImages(bool banner, bool icons)
+{
+	// Default implementation: Not supported.
+	Q_UNUSED(banner)
+	Q_UNUSED(icons)
+	return nullptr;
+}
+
 /** Checksums **/
 
 /**
@@ -285,21 +616,48 @@ void FilePrivate::loadImages(void)
 void FilePrivate::calculateChecksum(void)
 {
 	checksumValues.clear();
+	checksumValid = true;
 
 	if (checksumDefs.empty()) {
 		// No checksum definitions were set.
 		return;
 	}
 
-	// Load the file data.
-	QByteArray fileData = loadFileData();
-	if (fileData.isEmpty()) {
-		// File is empty.
-		return;
+	// The Sonic Chao Garden checksum temporarily modifies
+	// the file data, so it needs a writable copy.
+	bool needsCopy = false;
+	foreach (const Checksum::ChecksumDef &checksumDef, checksumDefs) {
+		if (checksumDef.algorithm == Checksum::CHKALG_SONICCHAOGARDEN) {
+			needsCopy = true;
+			break;
+		}
 	}
 
-	// Pointer to fileData's internal data array.
-	uint8_t *data = reinterpret_cast<uint8_t*>(fileData.data());
+	// If possible, use the file data directly from the card image.
+	QByteArray fileData;
+	const uint8_t *data = (needsCopy ? nullptr : mappedFileData());
+	int dataSize = this->size() * card->blockSize();
+	if (!data) {
+		// Load the file data.
+		fileData = loadFileData();
+		if (fileData.isEmpty()) {
+			// File is empty.
+			return;
+		}
+		data = reinterpret_cast<const uint8_t*>(fileData.constData());
+		dataSize = fileData.size();
+	}
+
+	// Checksums calculated by Checksum::Exec() in this pass.
+	// Definitions with the same algorithm, range, endianness,
+	// and parameter reuse the previous result instead of
+	// rescanning the data. (This is common with <instances>.)
+	struct ExecResult {
+		const Checksum::ChecksumDef *def;
+		uint32_t actual;
+	};
+	QVector<ExecResult> execResults;
+	execResults.reserve(checksumDefs.size());
 
 	// Process all of the checksum definitions.
 	for (int i = 0; i < (int)checksumDefs.size(); i++) {
@@ -315,8 +673,8 @@ void FilePrivate::calculateChecksum(void)
 		}
 
 		// Make sure the checksum definition is in range.
-		if (fileData.size() < (int)checksumDef.address ||
-		    fileData.size() < (int)(checksumDef.start + checksumDef.length))
+		if (dataSize < (int)checksumDef.address ||
+		    dataSize < (int)(checksumDef.start + checksumDef.length))
 		{
 			// File is too small...
 			// TODO: Also check the size of the checksum itself.
@@ -332,7 +690,7 @@ void FilePrivate::calculateChecksum(void)
 		// Some unusual ones need to be run manually.
 		bool useExec = true;
 
-		const char *const start = (fileData.constData() + checksumDef.start);
+		const char *const start = reinterpret_cast<const char*>(data + checksumDef.start);
 		uint32_t actual = 0;
 
 		switch (checksumDef.algorithm) {
@@ -393,7 +751,8 @@ void FilePrivate::calculateChecksum(void)
 				chaoChk.checksum_1 = 0;
 				chaoChk.checksum_0 = 0;
 				chaoChk.random_3 = 0;
-				memcpy(&data[checksumDef.address], &chaoChk, sizeof(chaoChk));
+				// NOTE: needsCopy is set, so fileData is a writable copy.
+				memcpy(fileData.data() + checksumDef.address, &chaoChk, sizeof(chaoChk));
 				break;
 			}
 
@@ -412,14 +771,42 @@ void FilePrivate::calculateChecksum(void)
 		}
 
 		if (useExec) {
-			// Use Checksum::Exec().
-			actual = Checksum::Exec(checksumDef.algorithm,
-				start, checksumDef.length, checksumDef.endian, checksumDef.param);
+			// Check if this checksum was already calculated.
+			// NOTE: The Sonic Chao Garden checksum includes
+			// its own address, so it can't be reused.
+			bool found = false;
+			if (checksumDef.algorithm != Checksum::CHKALG_SONICCHAOGARDEN) {
+				foreach (const ExecResult &result, execResults) {
+					const Checksum::ChecksumDef *const prev = result.def;
+					if (prev->algorithm == checksumDef.algorithm &&
+					    prev->start == checksumDef.start &&
+					    prev->length == checksumDef.length &&
+					    prev->endian == checksumDef.endian &&
+					    prev->param == checksumDef.param)
+					{
+						actual = result.actual;
+						found = true;
+						break;
+					}
+				}
+			}
+
+			if (!found) {
+				// Use Checksum::Exec().
+				actual = Checksum::Exec(checksumDef.algorithm,
+					start, checksumDef.length, checksumDef.endian, checksumDef.param);
+				if (checksumDef.algorithm != Checksum::CHKALG_SONICCHAOGARDEN) {
+					ExecResult result;
+					result.def = &checksumDef;
+					result.actual = actual;
+					execResults.append(result);
+				}
+			}
 		}
 
 		if (checksumDef.algorithm == Checksum::CHKALG_SONICCHAOGARDEN) {
 			// Restore the Chao Garden checksum data.
-			memcpy(&data[checksumDef.address], &chaoChk_orig, sizeof(chaoChk_orig));
+			memcpy(fileData.data() + checksumDef.address, &chaoChk_orig, sizeof(chaoChk_orig));
 		}
 
 		// Save the checksums.
@@ -490,10 +877,14 @@ QByteArray File::loadFileData(void)
  * Write data to the file.
  * NOTE: This function cannot expand files at the moment.
  * Length+size must be <= total file size.
+ *
+ * The data is compared to the current file contents,
+ * and only blocks that have changed are written.
+ *
  * @param address Address to write to.
  * @param data Data to write.
  * @param length Amount of data to write, in bytes.
- * @return Bytes written on success; negative POSIX error code on error.
+ * @return 0 on success; negative POSIX error code on error.
  */
 int File::write(uint32_t address, const void *const data, uint32_t length)
 {
@@ -501,67 +892,33 @@ int File::write(uint32_t address, const void *const data, uint32_t length)
 		return -EROFS;
 
 	Q_D(File);
-	const uint8_t *data_u8 = static_cast<const uint8_t*>(data);
-	const int blockSize = d->card->blockSize();
-
-	// Make sure address + length <= file size.
-	if (address + length > d->size() * blockSize)
-		return -ERANGE;
-
-	// Temporary block buffer.
-	// NOTE: Only resized (allocated) if necessary.
-	std::vector<uint8_t> block;
-
-	// Check if we're not starting on a block boundary.
-	const uint32_t blockStartOffset = (address % blockSize);
-	if (blockStartOffset != 0) {
-		// Not a block boundary.
-		// Read the block first.
-		block.resize(blockSize);
-		const uint16_t physBlockStartIdx = d->fileBlockAddrToPhysBlockAddr(address / blockSize);
-		d->card->readBlock(block.data(), blockSize, physBlockStartIdx);
-
-		// Bytes remaining in the block.
-		const uint32_t remaining = blockSize - (blockStartOffset);
-		if (length <= remaining) {
-			// This is the only block being written.
-			memcpy(block.data() + blockStartOffset, data_u8, length);
-			d->card->writeBlock(block.data(), blockSize, physBlockStartIdx);
-			// FIXME: Trigger card metadata update.
-			return 0;
-		}
-
-		// Write 'remaining' bytes worth of data.
-		memcpy(block.data() + blockStartOffset, data_u8, remaining);
-		d->card->writeBlock(block.data(), blockSize, physBlockStartIdx);
-
-		// Adjust for the remaining blocks.
-		address += remaining;
-		data_u8 += remaining;
-		length -= remaining;
-	}
-
-	// Write entire blocks.
-	for (; length >= (uint32_t)blockSize; length -= blockSize, data_u8 += blockSize, address += blockSize) {
-		const uint16_t physBlockIdx = d->fileBlockAddrToPhysBlockAddr(address / blockSize);
-		d->card->writeBlock(data, blockSize, physBlockIdx);
-	}
-
-	// Check if we still have data left (not a full block).
-	if (length != 0) {
-		// Not a full block.
-		// Read the block first.
-		block.resize(blockSize);
-		const uint16_t physBlockEndIdx = d->fileBlockAddrToPhysBlockAddr(address / blockSize);
-		d->card->readBlock(block.data(), blockSize, physBlockEndIdx);
+	QVector<WriteRange> ranges;
+	WriteRange range;
+	range.address = address;
+	range.length = length;
+	ranges.append(range);
+	return d->writeRanges(static_cast<const uint8_t*>(data), address, ranges);
+}
 
-		// Copy data into the block and write it back.
-		memcpy(block.data(), data_u8, length);
-		d->card->writeBlock(block.data(), blockSize, physBlockEndIdx);
-	}
+/**
+ * Write multiple ranges of data to the file.
+ * NOTE: This function cannot expand files at the moment.
+ *
+ * Each block covered by the ranges is read once,
+ * all ranges are applied, and only blocks that have
+ * changed are written, using a single writeBlocks() call.
+ *
+ * @param data File data, starting at address 0. Must cover all ranges.
+ * @param ranges Ranges to write.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int File::write(const void *data, const QVector<WriteRange> &ranges)
+{
+	if (isReadOnly())
+		return -EROFS;
 
-	// Data written successfully.
-	return 0;
+	Q_D(File);
+	return d->writeRanges(static_cast<const uint8_t*>(data), 0, ranges);
 }
 
 /**
@@ -628,7 +985,7 @@ int File::size(void) const
 QPixmap File::banner(void) const
 {
 	Q_D(const File);
-	return d->banner;
+	return const_cast<FilePrivate*>(d)->bannerPixmap();
 }
 
 /**
@@ -638,7 +995,10 @@ QPixmap File::banner(void) const
 int File::iconCount(void) const
 {
 	Q_D(const File);
-	return d->icons.size();
+	// NOTE: This doesn't decode the icons if the
+	// count is available from the file metadata.
+	d->initIconInfo();
+	return d->iconInfoCount;
 }
 
 /**
@@ -649,9 +1009,7 @@ int File::iconCount(void) const
 QPixmap File::icon(int idx) const
 {
 	Q_D(const File);
-	if (idx < 0 || idx >= d->icons.size())
-		return QPixmap();
-	return d->icons.at(idx);
+	return const_cast<FilePrivate*>(d)->iconPixmap(idx);
 }
 
 /**
@@ -663,6 +1021,7 @@ QPixmap File::icon(int idx) const
 int File::iconDelay(int idx) const
 {
 	Q_D(const File);
+	d->initIconInfo();
 	if (idx < 0 || idx >= d->iconSpeed.size())
 		return 0x0;
 	return d->iconSpeed.at(idx);
@@ -677,6 +1036,7 @@ int File::iconDelay(int idx) const
 int File::iconAnimMode(void) const
 {
 	Q_D(const File);
+	d->initIconInfo();
 	return (d->iconAnimMode & 0x4);
 }
 
@@ -731,34 +1091,9 @@ int File::exportToFile(const QString &filename)
 int File::saveBanner(const QString &filenameNoExt) const
 {
 	Q_D(const File);
-	// TODO: Make GcImageWriter more generic and move the
-	// internal image data here.
-	if (d->banner.isNull())
-		return -EINVAL;
-
-	// Append the correct extension.
-	QString filename = filenameNoExt;
-	const char *ext = GcImageWriter::extForImageFormat(GcImageWriter::IMGF_PNG);
-	if (ext)
-		filename += QChar(L'.') + QLatin1String(ext);
-
-	QFile file(filename);
-	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
-		// Error opening the file.
-		// TODO: Convert QFileError to a POSIX error code.
-		return -EIO;
-	}
-
-	// Write the banner image.
-	int ret = saveBanner(&file);
-	file.close();
-
-	if (ret != 0) {
-		// Error saving the banner image.
-		file.remove();
-	}
-
-	return ret;
+	FileImages images(false);
+	d->getImages(&images, true, false);
+	return images.saveBanner(filenameNoExt);
 }
 
 /**
@@ -770,21 +1105,9 @@ int File::saveBanner(const QString &filenameNoExt) const
 int File::saveBanner(QIODevice *qioDevice) const
 {
 	Q_D(const File);
-	if (!d->gcBanner)
-		return -EINVAL;
-
-	GcImageWriter gcImageWriter;
-	int ret = gcImageWriter.write(d->gcBanner, GcImageWriter::IMGF_PNG);
-	if (!ret) {
-		const vector<uint8_t> *pngData = gcImageWriter.memBuffer();
-		ret = qioDevice->write(reinterpret_cast<const char*>(pngData->data()), pngData->size());
-		if (ret != (qint64)pngData->size())
-			return -EIO;
-		ret = 0;
-	}
-
-	// Saved the banner image.
-	return ret;
+	FileImages images(false);
+	d->getImages(&images, true, false);
+	return images.saveBanner(qioDevice);
 }
 
 /**
@@ -798,102 +1121,49 @@ int File::saveIcon(const QString &filenameNoExt,
 	GcImageWriter::AnimImageFormat animImgf) const
 {
 	Q_D(const File);
-	if (d->gcIcons.isEmpty())
-		return -EINVAL;
-
-	// Append the correct extension.
-	const char *ext;
-	if (d->gcIcons.size() > 1) {
-		// Animated icon.
-		ext = GcImageWriter::extForAnimImageFormat(animImgf);
-	} else {
-		// Static icon.
-		ext = GcImageWriter::extForImageFormat(GcImageWriter::IMGF_PNG);
-	}
-
-	// NOTE: Due to PNG_FPF saving multiple files, we can't simply
-	// call a version of saveIcon() that takes a QIODevice.
-	GcImageWriter gcImageWriter;
-	int ret;
-	if (d->gcIcons.size() > 1) {
-		// Animated icon.
-		vector<const GcImage*> gcImages;
-		const int maxIcons = (d->gcIcons.size() * 2 - 2);
-		gcImages.reserve(maxIcons);
-		gcImages.resize(d->gcIcons.size());
-		for (int i = 0; i < d->gcIcons.size(); i++) {
-			gcImages[i] = d->gcIcons[i];
-		}
-
-		// Icon speed.
-		vector<int> gcIconDelays;
-		gcIconDelays.reserve(maxIcons);
-		gcIconDelays.resize(d->gcIcons.size());
-		for (int i = 0; i < d->gcIcons.size(); i++) {
-			gcIconDelays[i] = iconDelay(i);
-		}
-
-		if (gcImages.size() > 1 && iconAnimMode() == CARD_ANIM_BOUNCE) {
-			// BOUNCE animation.
-			int src = (gcImages.size() - 2);
-			int dest = gcImages.size();
-			gcImages.resize(maxIcons);
-			gcIconDelays.resize(maxIcons);
-			for (; src >= 1; src--, dest++) {
-				gcImages[dest] = gcImages[src];
-				gcIconDelays[dest] = gcIconDelays[src];
-			}
-		}
-
-		ret = gcImageWriter.write(&gcImages, &gcIconDelays, animImgf);
-	} else {
-		// Static icon.
-		ret = gcImageWriter.write(d->gcIcons.at(0), GcImageWriter::IMGF_PNG);
-	}
+	FileImages images(false);
+	d->getImages(&images, false, true);
+	return images.saveIcon(filenameNoExt, animImgf);
+}
 
-	if (ret != 0) {
-		// Error writing the icon.
-		return ret;
+/**
+ * Copy the banner and icon images.
+ * The copy doesn't reference this File or its Card,
+ * so it can be used to save the images on another thread.
+ *
+ * If the images haven't been decoded yet, only the raw
+ * image data may be copied. FileImages::decode() must
+ * be called before using the images.
+ *
+ * @param banner If true, copy the banner image.
+ * @param icons If true, copy the icon images.
+ * @return FileImages. (Caller must delete it.)
+ */
+FileImages *File::copyImages(bool banner, bool icons) const
+{
+	Q_D(const File);
+	if (!d->imagesLoaded) {
+		// Copy the raw image data so the images
+		// can be decoded by the caller.
+		FileImages *const images =
+			const_cast<FilePrivate*>(d)->copyRawImages(banner, icons);
+		if (images)
+			return images;
 	}
 
-	// Icon written successfully.
-	// Save it to a file.
-	for (int i = 0; i < gcImageWriter.numFiles(); i++) {
-		QString filename = filenameNoExt;
-		if (gcImageWriter.numFiles() > 1) {
-			// Multiple files.
-			// Append the file number.
-			char tmp[8];
-			snprintf(tmp, sizeof(tmp), "%02d", i+1);
-			filename += QChar(L'.') + QLatin1String(tmp);
-		}
-
-		// Append the file extension.
-		if (ext)
-			filename += QChar(L'.') + QLatin1String(ext);
-
-		QFile file(filename);
-		if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
-			// Error opening the file.
-			// TODO: Convert QFileError to a POSIX error code.
-			// TODO: Delete previous files?
-			return -EIO;
-		}
-
-		const vector<uint8_t> *pngData = gcImageWriter.memBuffer(i);
-		ret = file.write(reinterpret_cast<const char*>(pngData->data()), pngData->size());
-		file.close();
+	FileImages *const images = new FileImages(true);
+	d->getImages(images, banner, icons);
 
-		if (ret != (qint64)pngData->size()) {
-			// Error saving the icon.
-			file.remove();
-			return -EIO;
+	// Replace the internal GcImages with copies.
+	if (images->gcBanner) {
+		images->gcBanner = new GcImage(*images->gcBanner);
+	}
+	for (int i = 0; i < images->gcIcons.size(); i++) {
+		if (images->gcIcons.at(i)) {
+			images->gcIcons[i] = new GcImage(*images->gcIcons.at(i));
 		}
-
-		ret = 0;
 	}
-
-	return ret;
+	return images;
 }
 
 /** Checksum **/
@@ -916,7 +1186,8 @@ void File::setChecksumDefs(const QVector<Checksum::ChecksumDef> &checksumDefs)
 {
 	Q_D(File);
 	d->checksumDefs = checksumDefs;
-	d->calculateChecksum();
+	// Checksums will be calculated on first use.
+	d->checksumValid = false;
 }
 
 /**
@@ -926,6 +1197,7 @@ void File::setChecksumDefs(const QVector<Checksum::ChecksumDef> &checksumDefs)
 QVector<Checksum::ChecksumValue> File::checksumValues(void) const
 {
 	Q_D(const File);
+	d->updateChecksum();
 	return d->checksumValues;
 }
 
@@ -949,6 +1221,7 @@ Checksum::ChkAlgorithm File::checksumAlgorithm(void) const
 Checksum::ChkStatus File::checksumStatus(void) const
 {
 	Q_D(const File);
+	d->updateChecksum();
 	return Checksum::ChecksumStatus(d->checksumValues.toStdVector());
 }
 
@@ -961,6 +1234,7 @@ Checksum::ChkStatus File::checksumStatus(void) const
 QVector<QString> File::checksumValuesFormatted(void) const
 {
 	Q_D(const File);
+	d->updateChecksum();
 	vector<string> vs = Checksum::ChecksumValuesFormatted(d->checksumValues.toStdVector());
 	QVector<QString> ret;
 	ret.reserve((int)vs.size());
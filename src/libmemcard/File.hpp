@@ -25,6 +25,8 @@
 #include <QtCore/QIODevice>
 #include <QtGui/QPixmap>
 
+class FileImages;
+
 class FilePrivate;
 class File : public QObject
 {
@@ -114,13 +116,37 @@ class File : public QObject
 		 * Write data to the file.
 		 * NOTE: This function cannot expand files at the moment.
 		 * Length+size must be <= total file size.
+		 *
+		 * The data is compared to the current file contents,
+		 * and only blocks that have changed are written.
+		 *
 		 * @param address Address to write to.
 		 * @param data Data to write.
 		 * @param length Amount of data to write, in bytes.
-		 * @return Bytes written on success; negative POSIX error code on error.
+		 * @return 0 on success; negative POSIX error code on error.
 		 */
 		int write(uint32_t address, const void *data, uint32_t length);
 
+		// Byte range for write().
+		struct WriteRange {
+			uint32_t address;
+			uint32_t length;
+		};
+
+		/**
+		 * Write multiple ranges of data to the file.
+		 * NOTE: This function cannot expand files at the moment.
+		 *
+		 * Each block covered by the ranges is read once,
+		 * all ranges are applied, and only blocks that have
+		 * changed are written, using a single writeBlocks() call.
+		 *
+		 * @param data File data, starting at address 0. Must cover all ranges.
+		 * @param ranges Ranges to write.
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		int write(const void *data, const QVector<WriteRange> &ranges);
+
 		/** TODO: Add a QFlags indicating which fields are valid. **/
 
 		/**
@@ -277,6 +303,21 @@ class File : public QObject
 		int saveIcon(const QString &filenameNoExt,
 			     GcImageWriter::AnimImageFormat animImgf) const;
 
+		/**
+		 * Copy the banner and icon images.
+		 * The copy doesn't reference this File or its Card,
+		 * so it can be used to save the images on another thread.
+		 *
+		 * If the images haven't been decoded yet, only the raw
+		 * image data may be copied. FileImages::decode() must
+		 * be called before using the images.
+		 *
+		 * @param banner If true, copy the banner image.
+		 * @param icons If true, copy the icon images.
+		 * @return FileImages. (Caller must delete it.)
+		 */
+		FileImages *copyImages(bool banner, bool icons) const;
+
 	public:
 		/** Checksums **/
 
@@ -0,0 +1,230 @@
+/***************************************************************************
+ * GameCube Memory Card Recovery Program [libmemcard]                      *
+ * FileImages.cpp: Standalone copy of a file's banner and icon images.     *
+ *                                                                         *
+ * Copyright (c) 2012-2018 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "FileImages.hpp"
+
+// GcImage.
+#include "GcImage.hpp"
+#include "GcImageWriter.hpp"
+#include "card.h"
+
+// C includes. (C++ namespace)
+#include <cerrno>
+#include <cstdio>
+
+// C++ includes.
+#include <vector>
+using std::vector;
+
+// Qt includes.
+#include <QtCore/QFile>
+#include <QtCore/QIODevice>
+
+/**
+ * Create an empty FileImages.
+ * @param ownsImages If true, the GcImages are deleted by the destructor.
+ */
+FileImages::FileImages(bool ownsImages)
+	: gcBanner(nullptr)
+	, iconAnimMode(0)
+	, pngCompression(GcImageWriter::PNGC_DEFAULT)
+	, threadCount(1)
+	, m_ownsImages(ownsImages)
+{ }
+
+FileImages::~FileImages()
+{
+	if (m_ownsImages) {
+		delete gcBanner;
+		qDeleteAll(gcIcons);
+	}
+}
+
+/**
+ * Decode the banner and icon images from the raw image data.
+ * This does nothing if the images have already been decoded.
+ * This function is reentrant, so it can be called on a worker thread.
+ */
+void FileImages::decode(void)
+{
+	// Default implementation: The images are already decoded.
+}
+
+/**
+ * Save the banner image.
+ * @param filenameNoExt Filename for the banner image, sans extension.
+ * @return 0 on success; non-zero on error.
+ * TODO: Error code constants.
+ */
+int FileImages::saveBanner(const QString &filenameNoExt) const
+{
+	// TODO: Make GcImageWriter more generic and move the
+	// internal image data here.
+	if (!gcBanner)
+		return -EINVAL;
+
+	// Append the correct extension.
+	QString filename = filenameNoExt;
+	const char *ext = GcImageWriter::extForImageFormat(GcImageWriter::IMGF_PNG);
+	if (ext)
+		filename += QChar(L'.') + QLatin1String(ext);
+
+	QFile file(filename);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		// Error opening the file.
+		// TODO: Convert QFileError to a POSIX error code.
+		return -EIO;
+	}
+
+	// Write the banner image.
+	int ret = saveBanner(&file);
+	file.close();
+
+	if (ret != 0) {
+		// Error saving the banner image.
+		file.remove();
+	}
+
+	return ret;
+}
+
+/**
+ * Save the banner image.
+ * @param qioDevice QIODevice to write the banner image to.
+ * @return 0 on success; non-zero on error.
+ * TODO: Error code constants.
+ */
+int FileImages::saveBanner(QIODevice *qioDevice) const
+{
+	if (!gcBanner)
+		return -EINVAL;
+
+	GcImageWriter gcImageWriter;
+	gcImageWriter.setPngCompression(pngCompression);
+	int ret = gcImageWriter.write(gcBanner, GcImageWriter::IMGF_PNG);
+	if (!ret) {
+		const vector<uint8_t> *pngData = gcImageWriter.memBuffer();
+		ret = qioDevice->write(reinterpret_cast<const char*>(pngData->data()), pngData->size());
+		if (ret != (qint64)pngData->size())
+			return -EIO;
+		ret = 0;
+	}
+
+	// Saved the banner image.
+	return ret;
+}
+
+/**
+ * Save the icon.
+ * @param filenameNoExt Filename for the icon, sans extension.
+ * @param animImgf Animated image format to use for animated icons.
+ * @return 0 on success; non-zero on error.
+ * TODO: Error code constants.
+ */
+int FileImages::saveIcon(const QString &filenameNoExt,
+	GcImageWriter::AnimImageFormat animImgf) const
+{
+	if (gcIcons.isEmpty())
+		return -EINVAL;
+
+	// Append the correct extension.
+	const char *ext;
+	if (gcIcons.size() > 1) {
+		// Animated icon.
+		ext = GcImageWriter::extForAnimImageFormat(animImgf);
+	} else {
+		// Static icon.
+		ext = GcImageWriter::extForImageFormat(GcImageWriter::IMGF_PNG);
+	}
+
+	// NOTE: Due to PNG_FPF saving multiple files, we can't simply
+	// call a version of saveIcon() that takes a QIODevice.
+	GcImageWriter gcImageWriter;
+	gcImageWriter.setPngCompression(pngCompression);
+	gcImageWriter.setThreadCount(threadCount);
+	int ret;
+	if (gcIcons.size() > 1) {
+		// Animated icon.
+		vector<const GcImage*> gcImages;
+		const int maxIcons = (gcIcons.size() * 2 - 2);
+		gcImages.reserve(maxIcons);
+		gcImages.resize(gcIcons.size());
+		for (int i = 0; i < gcIcons.size(); i++) {
+			gcImages[i] = gcIcons[i];
+		}
+
+		// Icon speed.
+		vector<int> gcIconDelays;
+		gcIconDelays.reserve(maxIcons);
+		gcIconDelays.resize(gcIcons.size());
+		for (int i = 0; i < gcIcons.size(); i++) {
+			gcIconDelays[i] = (i < iconDelays.size() ? iconDelays.at(i) : 0);
+		}
+
+		if (gcImages.size() > 1 && iconAnimMode == CARD_ANIM_BOUNCE) {
+			// BOUNCE animation.
+			int src = (gcImages.size() - 2);
+			int dest = gcImages.size();
+			gcImages.resize(maxIcons);
+			gcIconDelays.resize(maxIcons);
+			for (; src >= 1; src--, dest++) {
+				gcImages[dest] = gcImages[src];
+				gcIconDelays[dest] = gcIconDelays[src];
+			}
+		}
+
+		ret = gcImageWriter.write(&gcImages, &gcIconDelays, animImgf);
+	} else {
+		// Static icon.
+		ret = gcImageWriter.write(gcIcons.at(0), GcImageWriter::IMGF_PNG);
+	}
+
+	if (ret != 0) {
+		// Error writing the icon.
+		return ret;
+	}
+
+	// Icon written successfully.
+	// Save it to a file.
+	for (int i = 0; i < gcImageWriter.numFiles(); i++) {
+		QString filename = filenameNoExt;
+		if (gcImageWriter.numFiles() > 1) {
+			// Multiple files.
+			// Append the file number.
+			char tmp[8];
+			snprintf(tmp, sizeof(tmp), "%02d", i+1);
+			filename += QChar(L'.') + QLatin1String(tmp);
+		}
+
+		// Append the file extension.
+		if (ext)
+			filename += QChar(L'.') + QLatin1String(ext);
+
+		QFile file(filename);
+		if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+			// Error opening the file.
+			// TODO: Convert QFileError to a POSIX error code.
+			// TODO: Delete previous files?
+			return -EIO;
+		}
+
+		const vector<uint8_t> *pngData = gcImageWriter.memBuffer(i);
+		ret = file.write(reinterpret_cast<const char*>(pngData->data()), pngData->size());
+		file.close();
+
+		if (ret != (qint64)pngData->size()) {
+			// Error saving the icon.
+			file.remove();
+			return -EIO;
+		}
+
+		ret = 0;
+	}
+
+	return ret;
+}
@@ -0,0 +1,103 @@
+/***************************************************************************
+ * GameCube Memory Card Recovery Program [libmemcard]                      *
+ * FileImages.hpp: Standalone copy of a file's banner and icon images.     *
+ *                                                                         *
+ * Copyright (c) 2012-2018 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#ifndef __LIBMEMCARD_FILEIMAGES_HPP__
+#define __LIBMEMCARD_FILEIMAGES_HPP__
+
+// GcImageWriter.
+#include "GcImageWriter.hpp"
+
+// Qt includes.
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+class GcImage;
+class QIODevice;
+
+/**
+ * Banner and icon images for a File.
+ *
+ * A copy created by File::copyImages() doesn't reference
+ * the File or its Card, so it can be used to encode the
+ * images on a worker thread. File also uses a non-owning
+ * FileImages internally to save its own images.
+ *
+ * If the File's images haven't been decoded yet, the copy
+ * may only contain the raw image data. decode() must be
+ * called before using the images.
+ */
+class FileImages
+{
+	public:
+		/**
+		 * Create an empty FileImages.
+		 * @param ownsImages If true, the GcImages are deleted by the destructor.
+		 */
+		explicit FileImages(bool ownsImages = true);
+		virtual ~FileImages();
+
+	private:
+		Q_DISABLE_COPY(FileImages)
+
+	public:
+		// Images.
+		const GcImage *gcBanner;
+		QVector<const GcImage*> gcIcons;
+
+		// Icon animation.
+		// FIXME: Use system-independent values.
+		// Currently uses GCN values.
+		QVector<int> iconDelays;
+		int iconAnimMode;
+
+		// PNG compression mode for saved images.
+		GcImageWriter::PngCompression pngCompression;
+
+		// Maximum number of threads for encoding animated icons.
+		// See GcImageWriter::setThreadCount().
+		int threadCount;
+
+	private:
+		bool m_ownsImages;
+
+	public:
+		/**
+		 * Decode the banner and icon images from the raw image data.
+		 * This does nothing if the images have already been decoded.
+		 * This function is reentrant, so it can be called on a worker thread.
+		 */
+		virtual void decode(void);
+
+		/**
+		 * Save the banner image.
+		 * @param filenameNoExt Filename for the banner image, sans extension.
+		 * @return 0 on success; non-zero on error.
+		 * TODO: Error code constants.
+		 */
+		int saveBanner(const QString &filenameNoExt) const;
+
+		/**
+		 * Save the banner image.
+		 * @param qioDevice QIODevice to write the banner image to.
+		 * @return 0 on success; non-zero on error.
+		 * TODO: Error code constants.
+		 */
+		int saveBanner(QIODevice *qioDevice) const;
+
+		/**
+		 * Save the icon.
+		 * @param filenameNoExt Filename for the icon, sans extension.
+		 * @param animImgf Animated image format for animated icons.
+		 * @return 0 on success; non-zero on error.
+		 * TODO: Error code constants.
+		 */
+		int saveIcon(const QString &filenameNoExt,
+			     GcImageWriter::AnimImageFormat animImgf) const;
+};
+
+#endif /* __LIBMEMCARD_FILEIMAGES_HPP__ */
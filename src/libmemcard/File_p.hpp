@@ -12,6 +12,7 @@
 #include "File.hpp"
 class Card;
 class GcImage;
+class FileImages;
 
 #include "Checksum.hpp"
 
@@ -52,14 +53,22 @@ class FilePrivate
 		// Size is calculated using fatEntries.size().
 
 		// GcImages. (internal use only)
+		// These are loaded on first use by loadImages().
 		GcImage *gcBanner;
 		QVector<GcImage*> gcIcons;
+		bool imagesLoaded;
+
+		// Icon animation metadata.
+		// This is loaded on first use by initIconInfo().
 		// FIXME: Use system-independent values.
 		// Currently uses GCN values.
 		QVector<uint8_t> iconSpeed;
 		uint8_t iconAnimMode;
+		int iconInfoCount;
+		bool iconInfoLoaded;
 
 		// QPixmap images.
+		// These are converted from the GcImages on first use.
 		QPixmap banner;
 		QVector<QPixmap> icons;
 
@@ -85,6 +94,35 @@ class FilePrivate
 		 */
 		QByteArray loadFileData(void);
 
+		/**
+		 * Write ranges of data to the file.
+		 * Only blocks that have changed are written.
+		 * @param data Data to write.
+		 * @param dataAddress File address corresponding to data[0].
+		 * @param ranges Ranges to write. Must not start before dataAddress.
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		int writeRanges(const uint8_t *data, uint32_t dataAddress,
+				const QVector<File::WriteRange> &ranges);
+
+		/**
+		 * Get a pointer to the file data in the memory-mapped card image.
+		 * This is only possible if the card is mapped and the
+		 * file's blocks are physically contiguous.
+		 * @return Pointer to the file data, or nullptr if not available.
+		 */
+		const uint8_t *mappedFileData(void) const;
+
+		/**
+		 * Write the file data to a QIODevice.
+		 * Contiguous runs of blocks in the memory-mapped card
+		 * image are written directly from the mapping, so the
+		 * file data isn't copied into a temporary buffer.
+		 * @param qioDevice QIODevice to write the data to.
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		int writeFileData(QIODevice *qioDevice);
+
 		/**
 		 * Read the specified range from the file.
 		 * @param blockStart First block.
@@ -113,10 +151,88 @@ class FilePrivate
 		/** Images **/
 
 		/**
-		 * Load the banner and icon images.
+		 * Reset the banner and icon images.
+		 * They will be loaded on first use.
+		 */
+		void resetImages(void);
+
+		/**
+		 * Load the banner and icon images if they haven't been loaded yet.
+		 * Called by the image accessors; subclasses don't need to call this.
 		 */
 		void loadImages(void);
 
+		/**
+		 * Load the banner and icon images if they haven't been loaded yet.
+		 * const version for the image accessors.
+		 */
+		inline void loadImages(void) const
+		{
+			if (!imagesLoaded)
+				const_cast<FilePrivate*>(this)->loadImages();
+		}
+
+		/**
+		 * Get the banner image as a QPixmap.
+		 * The QPixmap is converted on first use.
+		 * @return Banner image, or null QPixmap on error.
+		 */
+		QPixmap bannerPixmap(void);
+
+		/**
+		 * Get an icon image as a QPixmap.
+		 * The QPixmap is converted on first use.
+		 * @param idx Icon number.
+		 * @return Icon image, or null QPixmap on error.
+		 */
+		QPixmap iconPixmap(int idx);
+
+		/**
+		 * Load the icon animation metadata if it hasn't been loaded yet.
+		 * This uses loadIconInfo() if possible, so the icons
+		 * don't have to be decoded to set up the animation.
+		 */
+		void initIconInfo(void);
+
+		/**
+		 * Load the icon animation metadata if it hasn't been loaded yet.
+		 * const version for the icon accessors.
+		 */
+		inline void initIconInfo(void) const
+		{
+			if (!iconInfoLoaded)
+				const_cast<FilePrivate*>(this)->initIconInfo();
+		}
+
+		/**
+		 * Load the icon animation metadata without decoding the icons.
+		 * This must set iconSpeed, iconAnimMode, and iconInfoCount.
+		 * iconInfoCount must match the number of icons
+		 * that loadIconImages() would return.
+		 * @return True on success; false if the icons must be loaded.
+		 */
+		virtual bool loadIconInfo(void);
+
+		/**
+		 * Get the banner and icon images.
+		 * The images are loaded if necessary.
+		 * NOTE: The GcImages in images are owned by this FilePrivate.
+		 * @param images	[out] FileImages. (should be non-owning)
+		 * @param banner	[in] If true, get the banner image.
+		 * @param icons		[in] If true, get the icon images.
+		 */
+		void getImages(FileImages *images, bool banner, bool icons) const;
+
+		/**
+		 * Copy the raw banner and icon data without decoding the images.
+		 * The returned FileImages decodes the images in decode(),
+		 * so they can be decoded on a worker thread.
+		 * @param banner	[in] If true, copy the banner data.
+		 * @param icons		[in] If true, copy the icon data.
+		 * @return FileImages (caller must delete it), or nullptr if not supported.
+		 */
+		virtual FileImages *copyRawImages(bool banner, bool icons);
+
 		/**
 		 * Load the banner image.
 		 * @return GcImage containing the banner image, or nullptr on error.
@@ -132,13 +248,27 @@ class FilePrivate
 		/** Checksums **/
 
 		// Checksum data.
+		// checksumValues is only valid if checksumValid is set.
+		// It's recalculated on first use after the checksum
+		// definitions are changed or the file is written.
 		QVector<Checksum::ChecksumDef> checksumDefs;
 		QVector<Checksum::ChecksumValue> checksumValues;
+		bool checksumValid;
 
 		/**
 		 * Calculate the file checksum.
 		 */
 		void calculateChecksum(void);
+
+		/**
+		 * Calculate the file checksum if it isn't valid.
+		 * const version for the checksum accessors.
+		 */
+		inline void updateChecksum(void) const
+		{
+			if (!checksumValid)
+				const_cast<FilePrivate*>(this)->calculateChecksum();
+		}
 };
 
 #endif /* __LIBMEMCARD_FILE_P_HPP__ */
@@ -241,6 +241,7 @@ int GcnCardPrivate::format(const QString &filename)
 	// TODO: Separate Card::open()'s block count initialization
 	// so it can be used in this function.
 	totalPhysBlocks = 256;
+	unmapFile();
 	file->resize(totalPhysBlocks * blockSize);
 	filesize = file->size();
 	// TODO: Verify that the filesize matches.
@@ -316,6 +317,7 @@ int GcnCardPrivate::format(const QString &filename)
 	file->write((char*)mc_dat_int, sizeof(mc_dat_int));
 	file->write((char*)mc_bat_int, sizeof(mc_bat_int));
 	file->flush();
+	mapFile();
 
 #if SYS_BYTEORDER != SYS_BIG_ENDIAN
 	// Un-byteswap the tables.
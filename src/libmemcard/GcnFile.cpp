@@ -14,6 +14,7 @@
 #include "GcnCard.hpp"
 #include "GcImage.hpp"
 #include "GcImageLoader.hpp"
+#include "FileImages.hpp"
 #include "TimeFuncs.hpp"
 
 // C includes. (C++ namespace)
@@ -118,6 +119,103 @@ class GcnFilePrivate : public FilePrivate
 		 * @return QVector<GcImage*> containing the icon images, or empty QVector on error.
 		 */
 		QVector<GcImage*> loadIconImages(void) final;
+
+		/**
+		 * Load the icon animation metadata without decoding the icons.
+		 * This is calculated from the directory entry.
+		 * @return True on success.
+		 */
+		bool loadIconInfo(void) final;
+
+		/**
+		 * Copy the raw banner and icon data without decoding the images.
+		 * @param banner	[in] If true, copy the banner data.
+		 * @param icons		[in] If true, copy the icon data.
+		 * @return GcnFileImages (caller must delete it), or nullptr if the file is invalid.
+		 */
+		FileImages *copyRawImages(bool banner, bool icons) final;
+
+		/**
+		 * Decode a banner image.
+		 * This function is reentrant.
+		 * @param bannerfmt	[in] Banner format, from the directory entry.
+		 * @param imgData	[in] Raw banner data.
+		 * @param imgAddr	[in] Address of the banner within imgData.
+		 * @return GcImage containing the banner image, or nullptr on error.
+		 */
+		static GcImage *decodeBannerImage(uint8_t bannerfmt,
+			const QByteArray &imgData, uint32_t imgAddr);
+
+		/**
+		 * Decode the icon images.
+		 * This function is reentrant.
+		 * @param iconfmt	[in] Icon formats, from the directory entry.
+		 * @param iconspeed	[in] Icon speeds, from the directory entry.
+		 * @param imgData	[in] Raw icon data.
+		 * @param imgAddr	[in] Address of the first icon within imgData.
+		 * @return QVector<GcImage*> containing the icon images, or empty QVector on error.
+		 */
+		static QVector<GcImage*> decodeIconImages(uint16_t iconfmt, uint16_t iconspeed,
+			const QByteArray &imgData, uint32_t imgAddr);
+
+	private:
+		/**
+		 * Read the raw banner data.
+		 * @param pImgAddr	[out] Address of the banner within the returned data.
+		 * @return Raw banner data, or empty QByteArray if there's no banner or on error.
+		 */
+		QByteArray readBannerData(uint32_t *pImgAddr);
+
+		/**
+		 * Read the raw icon data.
+		 * @param pImgAddr	[out] Address of the first icon within the returned data.
+		 * @return Raw icon data, or empty QByteArray on error.
+		 */
+		QByteArray readIconData(uint32_t *pImgAddr);
+
+		/**
+		 * Calculate the location of the icon data from the directory entry.
+		 * @param pIconAddr	[out] Address of the first icon.
+		 * @param pIconLenTotal	[out] Total length of the icon data, including palettes.
+		 */
+		void iconDataRange(uint32_t *pIconAddr, int *pIconLenTotal) const;
+};
+
+/**
+ * Raw banner and icon data for a GcnFile.
+ * Created by GcnFilePrivate::copyRawImages().
+ * The images are decoded by decode().
+ */
+class GcnFileImages : public FileImages
+{
+	public:
+		GcnFileImages()
+			: FileImages(true)
+			, bannerfmt(0)
+			, iconfmt(0)
+			, iconspeed(0)
+			, bannerAddr(0)
+			, iconAddr(0)
+		{ }
+
+	private:
+		Q_DISABLE_COPY(GcnFileImages)
+
+	public:
+		void decode(void) final;
+
+	public:
+		// Image formats, from the directory entry.
+		uint8_t bannerfmt;
+		uint16_t iconfmt;
+		uint16_t iconspeed;
+
+		// Raw image data.
+		// Empty if the image isn't being copied.
+		QByteArray bannerData;
+		QByteArray iconData;
+		uint32_t bannerAddr;
+		uint32_t iconAddr;
 };
 
 /**
@@ -376,53 +474,67 @@ void GcnFilePrivate::loadFileInfo(void)
 	// pointing to description.
 	description = gameDesc + QChar(L'\0') + fileDesc;
 
-	// Load the banner and icon images.
-	loadImages();
+	// Reset the banner and icon images.
+	// They will be loaded on first use.
+	resetImages();
 }
 
 /**
- * Load the banner image.
- * @return GcImage* containing the banner image, or nullptr on error.
+ * Read the raw banner data.
+ * @param pImgAddr	[out] Address of the banner within the returned data.
+ * @return Raw banner data, or empty QByteArray if there's no banner or on error.
  */
-GcImage *GcnFilePrivate::loadBannerImage(void)
+QByteArray GcnFilePrivate::readBannerData(uint32_t *pImgAddr)
 {
-	// Determine the banner length.
-	uint32_t imgSize = 0;
 	switch (dirEntry->bannerfmt & CARD_BANNER_MASK) {
 		case CARD_BANNER_CI:
-			imgSize = (CARD_BANNER_W * CARD_BANNER_H * 1);
-			break;
 		case CARD_BANNER_RGB:
-			imgSize = (CARD_BANNER_W * CARD_BANNER_H * 2);
 			break;
 		default:
 			// No banner.
-			return nullptr;
+			return QByteArray();
 	}
 
 	// Load the banner.
-	uint32_t imgAddr = dirEntry->iconaddr;
+	const uint32_t imgAddr = dirEntry->iconaddr;
 	const int blockSize = card->blockSize();
 	const uint16_t blockStart = (imgAddr / blockSize);
 	QByteArray imgData = readBlocks(blockStart, 1);
 	if (imgData.size() != blockSize)
-		return nullptr;
-	imgAddr &= 0x1FFF;
+		return QByteArray();
+	*pImgAddr = (imgAddr & 0x1FFF);
+	return imgData;
+}
 
+/**
+ * Decode a banner image.
+ * This function is reentrant.
+ * @param bannerfmt	[in] Banner format, from the directory entry.
+ * @param imgData	[in] Raw banner data.
+ * @param imgAddr	[in] Address of the banner within imgData.
+ * @return GcImage containing the banner image, or nullptr on error.
+ */
+GcImage *GcnFilePrivate::decodeBannerImage(uint8_t bannerfmt,
+	const QByteArray &imgData, uint32_t imgAddr)
+{
 	GcImage *gcBannerImg = nullptr;
-	switch (dirEntry->bannerfmt & CARD_BANNER_MASK) {
-		case CARD_BANNER_CI:
+	switch (bannerfmt & CARD_BANNER_MASK) {
+		case CARD_BANNER_CI: {
 			// CI8 palette is right after the banner.
 			// (256 entries in RGB5A3 format.)
+			const uint32_t imgSize = (CARD_BANNER_W * CARD_BANNER_H * 1);
 			gcBannerImg = GcImageLoader::fromCI8(CARD_BANNER_W, CARD_BANNER_H,
 					(const uint8_t*)&imgData.constData()[imgAddr], imgSize,
 					(const uint16_t*)&imgData.constData()[imgAddr + imgSize], 0x200);
 			break;
+		}
 
-		case CARD_BANNER_RGB:
+		case CARD_BANNER_RGB: {
+			const uint32_t imgSize = (CARD_BANNER_W * CARD_BANNER_H * 2);
 			gcBannerImg = GcImageLoader::fromRGB5A3(CARD_BANNER_W, CARD_BANNER_H,
 					(const uint16_t*)&imgData.constData()[imgAddr], imgSize);
 			break;
+		}
 
 		default:
 			break;
@@ -432,63 +544,28 @@ GcImage *GcnFilePrivate::loadBannerImage(void)
 }
 
 /**
- * Load the icon images.
- * @return QVector<GcImage*> containing the icon images, or empty QVector on error.
+ * Load the banner image.
+ * @return GcImage* containing the banner image, or nullptr on error.
  */
-QVector<GcImage*> GcnFilePrivate::loadIconImages(void)
+GcImage *GcnFilePrivate::loadBannerImage(void)
 {
-	// TODO: Convert these to system-independent values.
-	// Icon animation metadata.
-	// TODO: Should be part of a struct that's returned...
-	this->iconAnimMode = (dirEntry->bannerfmt & CARD_ANIM_MASK);
-
-	// Calculate the first icon address.
-	uint32_t imgAddr = dirEntry->iconaddr;
-	switch (dirEntry->bannerfmt & CARD_BANNER_MASK) {
-		case CARD_BANNER_CI:
-			imgAddr += (CARD_BANNER_W * CARD_BANNER_H * 1);
-			imgAddr += 0x200; // palette
-			break;
-		case CARD_BANNER_RGB:
-			imgAddr += (CARD_BANNER_W * CARD_BANNER_H * 2);
-			break;
-		default:
-			// No banner.
-			break;
-	}
-
-	// Calculate the icon sizes.
-	int iconSizes[8];
-	int iconLenTotal = 0;
-	bool isShared = false;
-	uint16_t iconfmt = dirEntry->iconfmt;
-	uint16_t iconspeed = dirEntry->iconspeed;
-	for (int i = 0; i < CARD_MAXICONS; i++, iconfmt >>= 2, iconspeed >>= 2) {
-		if ((iconspeed & CARD_SPEED_MASK) == CARD_SPEED_END)
-			break;
-
-		switch (iconfmt & CARD_ICON_MASK) {
-			case CARD_ICON_CI_SHARED:
-				iconSizes[i] = (CARD_ICON_W * CARD_ICON_H * 1);
-				iconLenTotal += iconSizes[i];
-				isShared = true;
-				break;
-			case CARD_ICON_CI_UNIQUE:
-				iconSizes[i] = (CARD_ICON_W * CARD_ICON_H * 1);
-				iconLenTotal += iconSizes[i] + 0x200;
-				break;
-			case CARD_BANNER_RGB:
-				iconSizes[i] = (CARD_ICON_W * CARD_ICON_H * 2);
-				iconLenTotal += iconSizes[i];
-				break;
-		}
-	}
+	uint32_t imgAddr;
+	QByteArray imgData = readBannerData(&imgAddr);
+	if (imgData.isEmpty())
+		return nullptr;
+	return decodeBannerImage(dirEntry->bannerfmt, imgData, imgAddr);
+}
 
-	if (isShared) {
-		// CARD_ICON_CI_SHARED has a palette stored
-		// after all of the icons.
-		iconLenTotal += 0x200;
-	}
+/**
+ * Read the raw icon data.
+ * @param pImgAddr	[out] Address of the first icon within the returned data.
+ * @return Raw icon data, or empty QByteArray on error.
+ */
+QByteArray GcnFilePrivate::readIconData(uint32_t *pImgAddr)
+{
+	uint32_t imgAddr;
+	int iconLenTotal;
+	iconDataRange(&imgAddr, &iconLenTotal);
 
 	// Load the icon data.
 	const int blockSize = card->blockSize();
@@ -497,9 +574,23 @@ QVector<GcImage*> GcnFilePrivate::loadIconImages(void)
 	const int blockLen = ((blockEnd - blockStart) + 1);
 	QByteArray imgData = readBlocks(blockStart, blockLen);
 	if (imgData.size() != (blockLen * blockSize))
-		return QVector<GcImage*>();
-	imgAddr &= 0x1FFF;
+		return QByteArray();
+	*pImgAddr = (imgAddr & 0x1FFF);
+	return imgData;
+}
 
+/**
+ * Decode the icon images.
+ * This function is reentrant.
+ * @param iconfmt	[in] Icon formats, from the directory entry.
+ * @param iconspeed	[in] Icon speeds, from the directory entry.
+ * @param imgData	[in] Raw icon data.
+ * @param imgAddr	[in] Address of the first icon within imgData.
+ * @return QVector<GcImage*> containing the icon images, or empty QVector on error.
+ */
+QVector<GcImage*> GcnFilePrivate::decodeIconImages(uint16_t iconfmt, uint16_t iconspeed,
+	const QByteArray &imgData, uint32_t imgAddr)
+{
 	// Info for icons using a shared CI8 palette.
 	struct CI8_SHARED_data {
 		int iconIdx;
@@ -509,16 +600,10 @@ QVector<GcImage*> GcnFilePrivate::loadIconImages(void)
 	// Decode the icon(s).
 	QVector<CI8_SHARED_data> lst_CI8_SHARED;
 	QVector<GcImage*> gcImages;
-	// TODO: Should be part of a struct that's returned...
-	this->iconSpeed.clear();
 
-	iconfmt = dirEntry->iconfmt;
-	iconspeed = dirEntry->iconspeed;
 	for (int i = 0; i < CARD_MAXICONS; i++, iconfmt >>= 2, iconspeed >>= 2) {
 		if ((iconspeed & CARD_SPEED_MASK) == CARD_SPEED_END)
 			break;
-		// TODO: Should be part of a struct that's returned...
-		this->iconSpeed.append(iconspeed & CARD_SPEED_MASK);
 
 		switch (iconfmt & CARD_ICON_MASK) {
 			case CARD_ICON_CI_SHARED: {
@@ -569,7 +654,8 @@ QVector<GcImage*> GcnFilePrivate::loadIconImages(void)
 
 	if (!lst_CI8_SHARED.isEmpty()) {
 		// Process CI8 SHARED icons.
-		// TODO: Convert the palette once instead of every time?
+		// NOTE: GcImageLoader converts the palette once,
+		// and all of the icons share the converted palette.
 		const int imageSize = (CARD_ICON_W * CARD_ICON_H * 1);
 		foreach (const CI8_SHARED_data& data, lst_CI8_SHARED) {
 			GcImage *gcIcon = GcImageLoader::fromCI8(CARD_ICON_W, CARD_ICON_H,
@@ -593,6 +679,177 @@ QVector<GcImage*> GcnFilePrivate::loadIconImages(void)
 	return gcImages;
 }
 
+/**
+ * Load the icon images.
+ * @return QVector<GcImage*> containing the icon images, or empty QVector on error.
+ */
+QVector<GcImage*> GcnFilePrivate::loadIconImages(void)
+{
+	// NOTE: Icon animation metadata is set by loadIconInfo().
+	uint32_t imgAddr;
+	QByteArray imgData = readIconData(&imgAddr);
+	if (imgData.isEmpty())
+		return QVector<GcImage*>();
+	return decodeIconImages(dirEntry->iconfmt, dirEntry->iconspeed, imgData, imgAddr);
+}
+
+/**
+ * Calculate the location of the icon data from the directory entry.
+ * @param pIconAddr	[out] Address of the first icon.
+ * @param pIconLenTotal	[out] Total length of the icon data, including palettes.
+ */
+void GcnFilePrivate::iconDataRange(uint32_t *pIconAddr, int *pIconLenTotal) const
+{
+	// Calculate the first icon address.
+	uint32_t imgAddr = dirEntry->iconaddr;
+	switch (dirEntry->bannerfmt & CARD_BANNER_MASK) {
+		case CARD_BANNER_CI:
+			imgAddr += (CARD_BANNER_W * CARD_BANNER_H * 1);
+			imgAddr += 0x200; // palette
+			break;
+		case CARD_BANNER_RGB:
+			imgAddr += (CARD_BANNER_W * CARD_BANNER_H * 2);
+			break;
+		default:
+			// No banner.
+			break;
+	}
+
+	// Calculate the icon sizes.
+	int iconLenTotal = 0;
+	bool isShared = false;
+	uint16_t iconfmt = dirEntry->iconfmt;
+	uint16_t iconspeed = dirEntry->iconspeed;
+	for (int i = 0; i < CARD_MAXICONS; i++, iconfmt >>= 2, iconspeed >>= 2) {
+		if ((iconspeed & CARD_SPEED_MASK) == CARD_SPEED_END)
+			break;
+
+		switch (iconfmt & CARD_ICON_MASK) {
+			case CARD_ICON_CI_SHARED:
+				iconLenTotal += (CARD_ICON_W * CARD_ICON_H * 1);
+				isShared = true;
+				break;
+			case CARD_ICON_CI_UNIQUE:
+				iconLenTotal += (CARD_ICON_W * CARD_ICON_H * 1) + 0x200;
+				break;
+			case CARD_BANNER_RGB:
+				iconLenTotal += (CARD_ICON_W * CARD_ICON_H * 2);
+				break;
+		}
+	}
+
+	if (isShared) {
+		// CARD_ICON_CI_SHARED has a palette stored
+		// after all of the icons.
+		iconLenTotal += 0x200;
+	}
+
+	*pIconAddr = imgAddr;
+	*pIconLenTotal = iconLenTotal;
+}
+
+/**
+ * Load the icon animation metadata without decoding the icons.
+ * This is calculated from the directory entry.
+ * @return True on success.
+ */
+bool GcnFilePrivate::loadIconInfo(void)
+{
+	// TODO: Convert these to system-independent values.
+	this->iconAnimMode = (dirEntry->bannerfmt & CARD_ANIM_MASK);
+	this->iconSpeed.clear();
+	this->iconInfoCount = 0;
+
+	// If the icon data isn't within the file,
+	// loadIconImages() won't load any icons.
+	uint32_t imgAddr;
+	int iconLenTotal;
+	iconDataRange(&imgAddr, &iconLenTotal);
+	const int blockSize = card->blockSize();
+	const uint16_t blockEnd = ((imgAddr + iconLenTotal) / blockSize);
+	if (blockEnd >= this->size()) {
+		// Icon data is past the end of the file.
+		return true;
+	}
+
+	// Trailing icons with no image are dropped
+	// by loadIconImages(), so do the same here.
+	uint16_t iconfmt = dirEntry->iconfmt;
+	uint16_t iconspeed = dirEntry->iconspeed;
+	for (int i = 0; i < CARD_MAXICONS; i++, iconfmt >>= 2, iconspeed >>= 2) {
+		if ((iconspeed & CARD_SPEED_MASK) == CARD_SPEED_END)
+			break;
+		this->iconSpeed.append(iconspeed & CARD_SPEED_MASK);
+		if ((iconfmt & CARD_ICON_MASK) != CARD_ICON_NONE)
+			this->iconInfoCount = i + 1;
+	}
+	return true;
+}
+
+/**
+ * Copy the raw banner and icon data without decoding the images.
+ * @param banner	[in] If true, copy the banner data.
+ * @param icons		[in] If true, copy the icon data.
+ * @return GcnFileImages (caller must delete it), or nullptr if the file is invalid.
+ */
+FileImages *GcnFilePrivate::copyRawImages(bool banner, bool icons)
+{
+	if (!dirEntry) {
+		// Invalid file.
+		return nullptr;
+	}
+
+	GcnFileImages *const images = new GcnFileImages();
+	images->bannerfmt = dirEntry->bannerfmt;
+	images->iconfmt = dirEntry->iconfmt;
+	images->iconspeed = dirEntry->iconspeed;
+
+	if (banner) {
+		images->bannerData = readBannerData(&images->bannerAddr);
+	}
+
+	if (icons) {
+		initIconInfo();
+		if (iconInfoCount > 0) {
+			images->iconData = readIconData(&images->iconAddr);
+		}
+		images->iconDelays.resize(iconSpeed.size());
+		for (int i = 0; i < iconSpeed.size(); i++) {
+			images->iconDelays[i] = iconSpeed.at(i);
+		}
+		images->iconAnimMode = (iconAnimMode & 0x4);
+	}
+
+	return images;
+}
+
+/** GcnFileImages **/
+
+/**
+ * Decode the banner and icon images from the raw image data.
+ * This function is reentrant, so it can be called on a worker thread.
+ */
+void GcnFileImages::decode(void)
+{
+	if (!bannerData.isEmpty()) {
+		gcBanner = GcnFilePrivate::decodeBannerImage(bannerfmt, bannerData, bannerAddr);
+		bannerData.clear();
+	}
+
+	if (!iconData.isEmpty()) {
+		const QVector<GcImage*> icons =
+			GcnFilePrivate::decodeIconImages(iconfmt, iconspeed, iconData, iconAddr);
+		gcIcons.resize(icons.size());
+		for (int i = 0; i < icons.size(); i++) {
+			gcIcons[i] = icons.at(i);
+		}
+		iconData.clear();
+	}
+
+	// One icon delay per decoded icon.
+	iconDelays.resize(gcIcons.size());
+}
+
 /** GcnFile **/
 
 /**
@@ -742,9 +999,8 @@ int GcnFile::exportToFile(QIODevice *qioDevice)
 	}
 
 	// Write the file data.
-	const QByteArray fileData = d->loadFileData();
-	ret = qioDevice->write(fileData);
-	if (ret != (qint64)fileData.size()) {
+	// NOTE: If the card is mapped, this writes directly from the mapping.
+	if (d->writeFileData(qioDevice) != 0) {
 		// Error saving the file data.
 		return -3;
 	}
@@ -0,0 +1,158 @@
+/***************************************************************************
+ * GameCube Memory Card Recovery Program [libmemcard]                      *
+ * IconAnimClock.cpp: Shared icon animation clock.                         *
+ *                                                                         *
+ * Copyright (c) 2012-2018 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "IconAnimClock.hpp"
+
+// Qt includes.
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QMap>
+#include <QtCore/QTimer>
+
+/** IconAnimClockPrivate **/
+
+class IconAnimClockPrivate
+{
+	public:
+		explicit IconAnimClockPrivate(IconAnimClock *q);
+
+	protected:
+		IconAnimClock *const q_ptr;
+		Q_DECLARE_PUBLIC(IconAnimClock)
+	private:
+		Q_DISABLE_COPY(IconAnimClockPrivate)
+
+	public:
+		static IconAnimClock *instance;
+
+		// Time since the clock was created.
+		QElapsedTimer elapsed;
+
+		// Single-shot timer for the earliest requested tick.
+		QTimer timer;
+
+		// Outstanding tick requests.
+		// Key: Animation tick; Value: Number of requests.
+		QMap<quint64, int> pendingTicks;
+
+		/**
+		 * Start the timer for the earliest requested tick.
+		 * If no ticks are requested, the timer is stopped.
+		 */
+		void armTimer(void);
+};
+
+// Singleton instance.
+IconAnimClock *IconAnimClockPrivate::instance = nullptr;
+
+IconAnimClockPrivate::IconAnimClockPrivate(IconAnimClock *q)
+	: q_ptr(q)
+{
+	elapsed.start();
+
+	// Use a precise timer so the animation doesn't drift.
+	timer.setSingleShot(true);
+	timer.setTimerType(Qt::PreciseTimer);
+	QObject::connect(&timer, &QTimer::timeout,
+		q, &IconAnimClock::timer_slot);
+}
+
+/**
+ * Start the timer for the earliest requested tick.
+ * If no ticks are requested, the timer is stopped.
+ */
+void IconAnimClockPrivate::armTimer(void)
+{
+	if (pendingTicks.isEmpty()) {
+		timer.stop();
+		return;
+	}
+
+	qint64 ms = (qint64)(pendingTicks.firstKey() * IconAnimClock::TICK_MS) - elapsed.elapsed();
+	if (ms < 0)
+		ms = 0;
+	timer.start((int)ms);
+}
+
+/** IconAnimClock **/
+
+IconAnimClock::IconAnimClock()
+	: d_ptr(new IconAnimClockPrivate(this))
+{ }
+
+IconAnimClock::~IconAnimClock()
+{
+	Q_D(IconAnimClock);
+	delete d;
+}
+
+IconAnimClock *IconAnimClock::instance(void)
+{
+	if (!IconAnimClockPrivate::instance)
+		IconAnimClockPrivate::instance = new IconAnimClock();
+	return IconAnimClockPrivate::instance;
+}
+
+/**
+ * Get the current animation tick.
+ * @return Current animation tick.
+ */
+quint64 IconAnimClock::currentTick(void) const
+{
+	Q_D(const IconAnimClock);
+	return (quint64)d->elapsed.elapsed() / TICK_MS;
+}
+
+/**
+ * Request a tick() signal at the specified animation tick.
+ * All outstanding requests are kept, so a tick requested
+ * by one client doesn't hide later ticks requested by others.
+ * Each request is satisfied by a single tick() signal.
+ * @param tick Animation tick.
+ */
+void IconAnimClock::requestTick(quint64 tick)
+{
+	Q_D(IconAnimClock);
+	const bool isEarliest = (d->pendingTicks.isEmpty() ||
+				 tick < d->pendingTicks.firstKey());
+	d->pendingTicks[tick]++;
+	if (isEarliest) {
+		// This is now the earliest tick.
+		d->armTimer();
+	}
+}
+
+/** Private slots. **/
+
+/**
+ * Timer slot.
+ */
+void IconAnimClock::timer_slot(void)
+{
+	Q_D(IconAnimClock);
+
+	if (d->pendingTicks.isEmpty())
+		return;
+
+	// The timer may fire slightly early, so make sure
+	// the current tick is at least the requested tick.
+	quint64 now = currentTick();
+	if (now < d->pendingTicks.firstKey())
+		now = d->pendingTicks.firstKey();
+
+	// Remove all requests that are satisfied by this tick.
+	auto iter = d->pendingTicks.begin();
+	while (iter != d->pendingTicks.end() && iter.key() <= now) {
+		iter = d->pendingTicks.erase(iter);
+	}
+
+	// Clients will request their next ticks in response.
+	emit tick(now);
+
+	// Wait for the next outstanding request.
+	d->armTimer();
+}
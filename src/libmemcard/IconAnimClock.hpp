@@ -0,0 +1,81 @@
+/***************************************************************************
+ * GameCube Memory Card Recovery Program [libmemcard]                      *
+ * IconAnimClock.hpp: Shared icon animation clock.                         *
+ *                                                                         *
+ * Copyright (c) 2012-2018 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#ifndef __LIBMEMCARD_ICONANIMCLOCK_HPP__
+#define __LIBMEMCARD_ICONANIMCLOCK_HPP__
+
+// Qt includes.
+#include <QtCore/QObject>
+
+class IconAnimClockPrivate;
+
+/**
+ * Shared icon animation clock.
+ *
+ * Time is measured in animation ticks. (4 frames at 60 Hz)
+ * Instead of running a periodic timer, clients request a
+ * tick for the next time one of their icons changes frames.
+ * The clock keeps all outstanding requests and only wakes up
+ * when the earliest one is due, so it's idle if nothing is
+ * animating.
+ */
+class IconAnimClock : public QObject
+{
+	Q_OBJECT
+	typedef QObject super;
+
+	private:
+		IconAnimClock();
+		virtual ~IconAnimClock();
+
+	protected:
+		IconAnimClockPrivate *const d_ptr;
+		Q_DECLARE_PRIVATE(IconAnimClock)
+	private:
+		Q_DISABLE_COPY(IconAnimClock)
+
+	public:
+		static IconAnimClock *instance(void);
+
+		// Length of one animation tick, in milliseconds.
+		// FIXME: Support PAL; handle extra beginning frame and reduced ending frame.
+		// FIXME: Dreamcast animation timing?
+		static const int TICK_MS = 67;	/*4*1000/60*/
+
+		/**
+		 * Get the current animation tick.
+		 * @return Current animation tick.
+		 */
+		quint64 currentTick(void) const;
+
+		/**
+		 * Request a tick() signal at the specified animation tick.
+		 * All outstanding requests are kept, so a tick requested
+		 * by one client doesn't hide later ticks requested by others.
+		 * Each request is satisfied by a single tick() signal.
+		 * @param tick Animation tick.
+		 */
+		void requestTick(quint64 tick);
+
+	signals:
+		/**
+		 * A requested animation tick has been reached.
+		 * This is sent to all clients; clients should ignore
+		 * it if none of their icons are due.
+		 * @param now Current animation tick.
+		 */
+		void tick(quint64 now);
+
+	private slots:
+		/**
+		 * Timer slot.
+		 */
+		void timer_slot(void);
+};
+
+#endif /* __LIBMEMCARD_ICONANIMCLOCK_HPP__ */
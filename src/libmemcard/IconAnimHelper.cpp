@@ -12,6 +12,156 @@
 #include "card.h"
 #include "File.hpp"
 
+// Qt includes.
+#include <QtCore/QHash>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QVector>
+
+/**
+ * Precomputed icon animation schedule.
+ * This is one full animation cycle, with BOUNCE
+ * animations unrolled, so each tick only needs
+ * to increment the step index.
+ *
+ * The schedule is built from the icon delays and
+ * animation mode, so the icons aren't decoded until
+ * they're displayed for the first time.
+ *
+ * Schedules don't have any per-view state,
+ * so they're shared by all helpers for a File.
+ */
+class IconAnimSchedule
+{
+	public:
+		/**
+		 * Build the animation schedule for a file.
+		 * @param file File. (must have an animated icon)
+		 */
+		explicit IconAnimSchedule(const File *file);
+
+	private:
+		Q_DISABLE_COPY(IconAnimSchedule)
+
+	public:
+		struct Step {
+			const QPixmap *icon;	// Icon to display. (last valid frame)
+			uint8_t frame;		// Frame number.
+			uint8_t delay;		// Delay, in ticks. (minimum 1)
+			bool iconChanged;	// True if the icon differs from the previous step.
+		};
+		QVector<Step> steps;
+
+		/**
+		 * Get the icon for a step.
+		 * The icons are loaded on first use.
+		 * @param step Step.
+		 * @return Icon.
+		 */
+		const QPixmap &icon(int step);
+
+	private:
+		/**
+		 * Set the icon for each step.
+		 * Frames without an icon show the last valid frame.
+		 * @param valid Array of CARD_MAXICONS flags indicating if a frame has an icon.
+		 */
+		void resolveIcons(const bool *valid);
+
+		const File *file;
+		int lastFrame;
+
+		// Icon pixmaps, indexed by frame number.
+		// These are loaded by the first call to icon().
+		QPixmap icons[CARD_MAXICONS];
+		bool iconsLoaded;
+};
+
+/**
+ * Build the animation schedule for a file.
+ * @param file File. (must have an animated icon)
+ */
+IconAnimSchedule::IconAnimSchedule(const File *file)
+	: file(file)
+	, lastFrame(0)
+	, iconsLoaded(false)
+{
+	// Find the last frame.
+	while (lastFrame < (CARD_MAXICONS - 1) &&
+	       file->iconDelay(lastFrame + 1) != CARD_SPEED_END)
+	{
+		lastFrame++;
+	}
+
+	// Frame sequence: 0 to lastFrame.
+	// "Bounce" animations play backwards afterwards,
+	// stopping before frame 0, since that starts the next cycle.
+	const int mode = file->iconAnimMode();
+	const int stepCount = (mode == CARD_ANIM_BOUNCE && lastFrame > 0
+				? (lastFrame * 2)
+				: (lastFrame + 1));
+	steps.resize(stepCount);
+	for (int i = 0; i < stepCount; i++) {
+		Step &step = steps[i];
+		step.frame = (uint8_t)(i <= lastFrame ? i : (lastFrame * 2) - i);
+		const int delay = file->iconDelay(step.frame);
+		step.delay = (uint8_t)(delay > 1 ? delay : 1);
+	}
+
+	// Until the icons are loaded, assume that
+	// all frames within the icon count are valid.
+	// This is corrected when the icons are loaded.
+	bool valid[CARD_MAXICONS];
+	const int iconCount = file->iconCount();
+	for (int i = 0; i < CARD_MAXICONS; i++) {
+		valid[i] = (i < iconCount);
+	}
+	resolveIcons(valid);
+}
+
+/**
+ * Get the icon for a step.
+ * The icons are loaded on first use.
+ * @param step Step.
+ * @return Icon.
+ */
+const QPixmap &IconAnimSchedule::icon(int step)
+{
+	if (!iconsLoaded) {
+		iconsLoaded = true;
+		bool valid[CARD_MAXICONS];
+		for (int i = 0; i < CARD_MAXICONS; i++) {
+			if (i <= lastFrame)
+				icons[i] = file->icon(i);
+			valid[i] = !icons[i].isNull();
+		}
+		resolveIcons(valid);
+	}
+	return *(steps.at(step).icon);
+}
+
+/**
+ * Set the icon for each step.
+ * Frames without an icon show the last valid frame.
+ * @param valid Array of CARD_MAXICONS flags indicating if a frame has an icon.
+ */
+void IconAnimSchedule::resolveIcons(const bool *valid)
+{
+	// The first pass determines the last valid frame at
+	// the end of the cycle; the second pass sets the icons.
+	int lastValidFrame = 0;
+	for (int pass = 0; pass < 2; pass++) {
+		for (int i = 0; i < steps.size(); i++) {
+			Step &step = steps[i];
+			step.iconChanged = false;
+			if (valid[step.frame]) {
+				step.iconChanged = (lastValidFrame != step.frame);
+				lastValidFrame = step.frame;
+			}
+			step.icon = &icons[lastValidFrame];
+		}
+	}
+}
+
 class IconAnimHelperPrivate
 {
 	public:
@@ -27,19 +177,27 @@ class IconAnimHelperPrivate
 		const File *file;
 
 		/**
+		 * Animation schedule.
 		 * If a file is specified and has an animated icon,
-		 * this is set to true.
+		 * this is set; otherwise, it's nullptr.
 		 */
-		bool enabled;
+		QSharedPointer<IconAnimSchedule> schedule;
 
 		// Animation data.
-		uint8_t frame;		// Current frame.
-		uint8_t lastValidFrame;	// Last valid frame.
-		bool frameHasIcon;	// If false, use previous frame.
-		uint8_t delayCnt;	// Delay counter.
-		uint8_t delayLen;	// Delay length.
-		uint8_t mode;		// Animation mode.
-		bool direction;		// Current direction for CARD_ANIM_BOUNCE.
+		int step;		// Current step in the schedule.
+
+		/**
+		 * Shared animation schedules.
+		 * Entries are removed when the File is destroyed.
+		 */
+		static QHash<const File*, QWeakPointer<IconAnimSchedule> > scheduleCache;
+
+		/**
+		 * Get the shared animation schedule for a file.
+		 * @param file File. (must have an animated icon)
+		 * @return Animation schedule.
+		 */
+		static QSharedPointer<IconAnimSchedule> getSchedule(const File *file);
 
 		/**
 		 * Reset the animation state.
@@ -47,12 +205,13 @@ class IconAnimHelperPrivate
 		void reset(void);
 
 		/**
-		 * Timer tick for the animation counter.
+		 * Go to the next frame.
 		 * @return True if the current icon has been changed; false if not.
 		 */
-		bool tick(void);
+		bool nextFrame(void);
 };
 
+QHash<const File*, QWeakPointer<IconAnimSchedule> > IconAnimHelperPrivate::scheduleCache;
 
 IconAnimHelperPrivate::IconAnimHelperPrivate(IconAnimHelper *q)
 	: q_ptr(q)
@@ -62,102 +221,59 @@ IconAnimHelperPrivate::IconAnimHelperPrivate(IconAnimHelper *q)
 }
 
 
+/**
+ * Get the shared animation schedule for a file.
+ * @param file File. (must have an animated icon)
+ * @return Animation schedule.
+ */
+QSharedPointer<IconAnimSchedule> IconAnimHelperPrivate::getSchedule(const File *file)
+{
+	QSharedPointer<IconAnimSchedule> schedule = scheduleCache.value(file).toStrongRef();
+	if (!schedule) {
+		// Remove expired schedules.
+		for (auto iter = scheduleCache.begin(); iter != scheduleCache.end(); ) {
+			if (iter.value().isNull()) {
+				iter = scheduleCache.erase(iter);
+			} else {
+				++iter;
+			}
+		}
+
+		schedule = QSharedPointer<IconAnimSchedule>(new IconAnimSchedule(file));
+		scheduleCache.insert(file, schedule);
+	}
+	return schedule;
+}
+
+
 /**
  * Reset the animation state.
  */
 void IconAnimHelperPrivate::reset(void)
 {
-	frame = 0;
-	lastValidFrame = 0;
-	delayCnt = 0;
-	direction = false;
+	step = 0;
 
 	if (!file || file->iconCount() <= 1) {
 		// No file specified, or icon is not animated.
-		enabled = false;
-		frameHasIcon = 0;
-		delayLen = 0;
-		mode = 0;
+		schedule.clear();
 	} else {
 		// File is specified.
-		// Determine the initial state.
-		enabled = true;
-		frameHasIcon = !(file->icon(frame).isNull());
-		delayLen = file->iconDelay(frame);
-		mode = file->iconAnimMode();
+		schedule = getSchedule(file);
 	}
 }
 
-
 /**
- * Timer tick for the animation counter.
+ * Go to the next frame.
  * @return True if the current icon has been changed; false if not.
  */
-bool IconAnimHelperPrivate::tick(void)
+bool IconAnimHelperPrivate::nextFrame(void)
 {
-	if (!enabled)
-		return false;
-
-	// Check the delay counter.
-	delayCnt++;
-	if (delayCnt < delayLen) {
-		// Animation delay hasn't expired yet.
-		return false;
-	}
-
-	// Animation delay has expired.
-	// Go to the next frame.
-	if (!direction) {
-		// Animation is moving forwards.
-		// Check if we're at the last frame.
-		if (frame == (CARD_MAXICONS - 1) ||
-		    (file->iconDelay(frame + 1) == CARD_SPEED_END))
-		{
-			// Last frame.
-			if (mode == CARD_ANIM_BOUNCE) {
-				// "Bounce" animation. Start playing backwards.
-				direction = true;
-				frame--;	// Go to the previous frame.
-			} else {
-				// "Looping" animation.
-				// Reset to frame 0.
-				frame = 0;
-			}
-		} else {
-			// Not the last frame.
-			// Go to the next frame.
-			frame++;
-		}
-	} else {
-		// Animation is moving backwards. ("Bounce" animation only.)
-		// Check if we're at the first frame.
-		if (frame == 0) {
-			// First frame. Start playing forwards.
-			direction = false;
-			frame++;	// Go to the next frame.
-		} else {
-			// Not the first frame.
-			// Go to the previous frame.
-			frame--;
-		}
-	}
-
-	// Update the frame delay data.
-	delayCnt = 0;
-	delayLen = file->iconDelay(frame);
-
-	// Check if this frame has an icon.
-	frameHasIcon = !file->icon(frame).isNull();
-	if (frameHasIcon && lastValidFrame != frame) {
-		// Frame has an icon. Save this frame as the last valid frame.
-		lastValidFrame = frame;
-
-		// Current icon has been updated.
-		return true;
+	step++;
+	if (step >= schedule->steps.size()) {
+		// End of the cycle.
+		step = 0;
 	}
-
-	// Current icon has not been updated.
-	return false;
+	return schedule->steps.at(step).iconChanged;
 }
 
 
@@ -233,7 +349,7 @@ void IconAnimHelper::reset(void)
 bool IconAnimHelper::isAnimated(void) const
 {
 	Q_D(const IconAnimHelper);
-	return d->enabled;
+	return !d->schedule.isNull();
 }
 
 /**
@@ -246,20 +362,34 @@ QPixmap IconAnimHelper::icon(void) const
 	if (!d->file)
 		return QPixmap();
 
-	// Get the current icon from this file.
 	// If the icon is not animated, this will always be icon 0.
-	return d->file->icon(d->lastValidFrame);
+	if (!d->schedule)
+		return d->file->icon(0);
+	return d->schedule->icon(d->step);
 }
 
 /**
- * Timer tick for the animation counter.
- * WRAPPER FUNCTION for d->tick().
+ * Get the number of timer ticks until the next frame.
+ * @return Number of ticks until the next frame, or 0 if not animated.
+ */
+int IconAnimHelper::ticksUntilNextFrame(void) const
+{
+	Q_D(const IconAnimHelper);
+	if (!d->schedule)
+		return 0;
+	return d->schedule->steps.at(d->step).delay;
+}
+
+/**
+ * Skip the remaining delay and go to the next frame.
  * @return True if the current icon has been changed; false if not.
  */
-bool IconAnimHelper::tick(void)
+bool IconAnimHelper::advanceFrame(void)
 {
 	Q_D(IconAnimHelper);
-	return d->tick();
+	if (!d->schedule)
+		return false;
+	return d->nextFrame();
 }
 
 /** Slots. **/
@@ -274,6 +404,8 @@ void IconAnimHelper::file_destroyed_slot(QObject *obj)
 
 	if (obj == d->file) {
 		// Our File was destroyed.
+		// NOTE: Don't dereference obj; the File is mostly destroyed.
+		IconAnimHelperPrivate::scheduleCache.remove(d->file);
 		d->file = nullptr;
 		d->reset();
 	}
@@ -68,10 +68,16 @@ class IconAnimHelper : public QObject
 		QPixmap icon(void) const;
 
 		/**
-		 * Timer tick for the animation counter.
+		 * Get the number of timer ticks until the next frame.
+		 * @return Number of ticks until the next frame, or 0 if not animated.
+		 */
+		int ticksUntilNextFrame(void) const;
+
+		/**
+		 * Skip the remaining delay and go to the next frame.
 		 * @return True if the current icon has been changed; false if not.
 		 */
-		bool tick(void);
+		bool advanceFrame(void);
 
 	protected slots:
 		/**
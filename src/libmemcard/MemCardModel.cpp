@@ -17,6 +17,7 @@
 #include "util/array_size.h"
 
 // Icon animation helper.
+#include "IconAnimClock.hpp"
 #include "IconAnimHelper.hpp"
 
 // C includes. (C++ namespace)
@@ -25,7 +26,7 @@
 
 // Qt includes.
 #include <QtCore/QHash>
-#include <QtCore/QTimer>
+#include <QtCore/QMultiMap>
 #include <QApplication>
 #include <QtGui/QColor>
 #include <QtGui/QFont>
@@ -52,6 +53,20 @@ class MemCardModelPrivate
 
 		QHash<const File*, IconAnimHelper*> animState;
 
+		// Animation schedule entry.
+		struct AnimEntry {
+			IconAnimHelper *helper;
+			int row;
+		};
+
+		/**
+		 * Animation schedule.
+		 * Key is the animation tick where the icon's next frame is due.
+		 * Row numbers are only valid until files are inserted or removed,
+		 * so the schedule is rebuilt when that happens.
+		 */
+		QMultiMap<quint64, AnimEntry> animQueue;
+
 		/**
 		 * Initialize the animation state for all files.
 		 */
@@ -65,12 +80,16 @@ class MemCardModelPrivate
 
 		/**
 		 * Update the animation timer state.
-		 * Starts the timer if animated icons are present; stops the timer if not.
+		 * Rebuilds the animation schedule and requests a tick
+		 * from the animation clock if animated icons are present.
 		 */
 		void updateAnimTimerState(void);
 
-		// Animation timer.
-		QTimer *animTimer;
+		/**
+		 * Request a tick for the next scheduled frame.
+		 */
+		void requestAnimTick(void);
+
 		// Pause count. If >0, animation is paused.
 		int pauseCounter;
 
@@ -130,14 +149,13 @@ class MemCardModelPrivate
 MemCardModelPrivate::MemCardModelPrivate(MemCardModel *q)
 	: q_ptr(q)
 	, card(nullptr)
-	, animTimer(new QTimer(q))
 	, pauseCounter(0)
 	, fileCount(0)
 	, insertStart(-1)
 	, insertEnd(-1)
 {
-	// Connect animTimer's timeout() signal.
-	QObject::connect(animTimer, &QTimer::timeout,
+	// Connect the shared animation clock.
+	QObject::connect(IconAnimClock::instance(), &IconAnimClock::tick,
 			 q, &MemCardModel::animTimerSlot);
 
 	// Initialize the style variables.
@@ -232,10 +250,8 @@ QIcon MemCardModelPrivate::style_t::loadIcon(const QString &dir, const QString &
 
 MemCardModelPrivate::~MemCardModelPrivate()
 {
-	animTimer->stop();
-	delete animTimer;
-
 	// TODO: Check for race conditions.
+	animQueue.clear();
 	qDeleteAll(animState);
 	animState.clear();
 }
@@ -245,9 +261,8 @@ MemCardModelPrivate::~MemCardModelPrivate()
  */
 void MemCardModelPrivate::initAnimState(void)
 {
-	animTimer->stop();
-
 	// TODO: Check for race conditions.
+	animQueue.clear();
 	qDeleteAll(animState);
 	animState.clear();
 
@@ -270,10 +285,13 @@ void MemCardModelPrivate::initAnimState(void)
  */
 void MemCardModelPrivate::initAnimState(const File *file)
 {
+	// Remove the existing animation state, if any.
+	// The animation schedule must be rebuilt afterwards.
+	delete animState.take(file);
+
 	int numIcons = file->iconCount();
 	if (numIcons <= 1) {
 		// Not an animated icon.
-		animState.remove(file);
 		return;
 	}
 
@@ -283,20 +301,43 @@ void MemCardModelPrivate::initAnimState(const File *file)
 
 /**
  * Update the animation timer state.
- * Starts the timer if animated icons are present; stops the timer if not.
+ * Rebuilds the animation schedule and requests a tick
+ * from the animation clock if animated icons are present.
  */
 void MemCardModelPrivate::updateAnimTimerState(void)
 {
-	if (pauseCounter <= 0 && !animState.isEmpty()) {
-		// Animation is not paused, and we have animated icons.
-		// Start the timer.
-		// FIXME: Support PAL; handle extra beginning frame and reduced ending frame.
-		// FIXME: Dreamcast animation timing?
-		animTimer->start(67 /*4*1000/60*/);
-	} else {
+	animQueue.clear();
+	if (pauseCounter > 0 || animState.isEmpty() || !card) {
 		// Either animation is paused, or we don't have animated icons.
-		// Stop the timer.
-		animTimer->stop();
+		// Nothing is scheduled, so the clock won't wake us up.
+		return;
+	}
+
+	// Schedule the next frame for each animated icon,
+	// starting from the current tick.
+	const quint64 now = IconAnimClock::instance()->currentTick();
+	const int count = card->fileCount();
+	for (int i = 0; i < count; i++) {
+		IconAnimHelper *const helper = animState.value(card->getFile(i));
+		if (!helper)
+			continue;
+
+		AnimEntry entry;
+		entry.helper = helper;
+		entry.row = i;
+		animQueue.insert(now + helper->ticksUntilNextFrame(), entry);
+	}
+
+	requestAnimTick();
+}
+
+/**
+ * Request a tick for the next scheduled frame.
+ */
+void MemCardModelPrivate::requestAnimTick(void)
+{
+	if (!animQueue.isEmpty()) {
+		IconAnimClock::instance()->requestTick(animQueue.firstKey());
 	}
 }
 
@@ -632,33 +673,52 @@ void MemCardModel::resumeAnimation(void)
 /** Private slots. **/
 
 /**
- * Animation timer slot.
+ * Animation clock tick.
+ * @param now Current animation tick.
  */
-void MemCardModel::animTimerSlot(void)
+void MemCardModel::animTimerSlot(quint64 now)
 {
 	Q_D(MemCardModel);
-	if (!d->card) {
-		d->animTimer->stop();
+	if (!d->card || d->pauseCounter > 0) {
+		d->animQueue.clear();
+		return;
+	}
+	if (d->animQueue.isEmpty() || d->animQueue.firstKey() > now) {
+		// None of our icons are due yet.
+		// (The tick was requested by another client.)
+		// Our own request is still pending in the clock.
 		return;
 	}
 
-	// Check for icon animations.
-	for (int i = 0; i < d->fileCount; i++) {
-		const File *file = d->card->getFile(i);
-		IconAnimHelper *helper = d->animState.value(file);
-		if (!helper)
-			continue;
+	// Take all of the icons that are due.
+	QVector<MemCardModelPrivate::AnimEntry> due;
+	auto iter = d->animQueue.begin();
+	while (iter != d->animQueue.end() && iter.key() <= now) {
+		due.append(iter.value());
+		iter = d->animQueue.erase(iter);
+	}
 
-		// Tell the IconAnimHelper that a timer tick has occurred.
-		// TODO: Connect the timer to the IconAnimHelper directly?
-		bool iconUpdated = helper->tick();
-		if (iconUpdated) {
+	// Go to the next frame for each icon and reschedule it.
+	int firstRow = INT_MAX, lastRow = -1;
+	foreach (const MemCardModelPrivate::AnimEntry &entry, due) {
+		if (entry.helper->advanceFrame()) {
 			// Icon has been updated.
-			// Notify the UI that the icon has changed.
-			QModelIndex iconIndex = createIndex(i, MemCardModel::COL_ICON);
-			emit dataChanged(iconIndex, iconIndex);
+			if (entry.row < firstRow)
+				firstRow = entry.row;
+			if (entry.row > lastRow)
+				lastRow = entry.row;
 		}
+		d->animQueue.insert(now + entry.helper->ticksUntilNextFrame(), entry);
 	}
+
+	if (lastRow >= 0) {
+		// Notify the UI that the icons have changed.
+		// This is done once per tick, covering all updated rows.
+		emit dataChanged(createIndex(firstRow, MemCardModel::COL_ICON),
+				 createIndex(lastRow, MemCardModel::COL_ICON));
+	}
+
+	d->requestAnimTick();
 }
 
 /**
@@ -672,6 +732,7 @@ void MemCardModel::card_destroyed_slot(QObject *obj)
 	if (obj == d->card) {
 		// Our Card was destroyed.
 		d->card = nullptr;
+		d->animQueue.clear();
 		int old_fileCount = d->fileCount;
 		if (old_fileCount > 0)
 			beginRemoveRows(QModelIndex(), 0, (old_fileCount - 1));
@@ -738,10 +799,13 @@ void MemCardModel::card_filesAboutToBeRemoved_slot(int start, int end)
 	beginRemoveRows(QModelIndex(), start, end);
 
 	// Remove animation states for these files.
+	// The schedule has stale row numbers, so clear it
+	// until the files have been removed.
 	Q_D(MemCardModel);
+	d->animQueue.clear();
 	for (int i = start; i <= end; i++) {
 		const File *file = d->card->getFile(i);
-		d->animState.remove(file);
+		delete d->animState.take(file);
 	}
 }
 
@@ -755,6 +819,9 @@ void MemCardModel::card_filesRemoved_slot(void)
 	if (d->card)
 		d->fileCount = d->card->fileCount();
 
+	// Rebuild the animation schedule.
+	d->updateAnimTimerState();
+
 	// Done removing rows.
 	endRemoveRows();
 }
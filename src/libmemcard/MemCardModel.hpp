@@ -78,10 +78,10 @@ class MemCardModel : public QAbstractListModel
 
 	private slots:
 		/**
-		 * Animation timer slot.
-		 * Wrapper for MemCardModelPrivate::animTimerSlot().
+		 * Animation clock tick.
+		 * @param now Current animation tick.
 		 */
-		void animTimerSlot(void);
+		void animTimerSlot(quint64 now);
 
 		/**
 		 * Card object was destroyed.
@@ -13,6 +13,7 @@
 
 #include "VmuCard.hpp"
 #include "DcImageLoader.hpp"
+#include "FileImages.hpp"
 #include "TimeFuncs.hpp"
 
 // C includes. (C++ namespace)
@@ -105,6 +106,13 @@ class VmuFilePrivate : public FilePrivate
 		 */
 		QVector<GcImage*> loadIconImages(void) final;
 
+		/**
+		 * Load the icon animation metadata without decoding the icons.
+		 * This is calculated from the file header.
+		 * @return True on success; false for ICONDATA_VMS.
+		 */
+		bool loadIconInfo(void) final;
+
 		/**
 		 * Load the icon images.
 		 * Special version for ICONDATA_VMS.
@@ -114,6 +122,73 @@ class VmuFilePrivate : public FilePrivate
 		 * check those variables afterwards.
 		 */
 		void loadIconImages_ICONDATA_VMS(void);
+
+		/**
+		 * Copy the raw banner and icon data without decoding the images.
+		 * @param banner	[in] If true, copy the banner data.
+		 * @param icons		[in] If true, copy the icon data.
+		 * @return VmuFileImages (caller must delete it), or nullptr for ICONDATA_VMS.
+		 */
+		FileImages *copyRawImages(bool banner, bool icons) final;
+
+		/**
+		 * Decode the eyecatch (banner) image.
+		 * This function is reentrant.
+		 * NOTE: Only VMU_EYECATCH_PALETTE_16 is supported.
+		 * The caller must check the eyecatch type.
+		 * @param fileHeader	[in] VMU file header.
+		 * @param data		[in] File data.
+		 * @param headerAddr	[in] Address of the file header within data.
+		 * @return GcImage containing the banner image, or nullptr on error.
+		 */
+		static GcImage *decodeBannerImage(const vmu_file_header *fileHeader,
+			const QByteArray &data, int headerAddr);
+
+		/**
+		 * Decode the icon images.
+		 * This function is reentrant.
+		 * @param fileHeader	[in] VMU file header.
+		 * @param data		[in] File data.
+		 * @param headerAddr	[in] Address of the file header within data.
+		 * @return QVector<GcImage*> containing the icon images, or empty QVector on error.
+		 */
+		static QVector<GcImage*> decodeIconImages(const vmu_file_header *fileHeader,
+			const QByteArray &data, int headerAddr);
+};
+
+/**
+ * Raw banner and icon data for a VmuFile.
+ * Created by VmuFilePrivate::copyRawImages().
+ * The images are decoded by decode().
+ */
+class VmuFileImages : public FileImages
+{
+	public:
+		VmuFileImages()
+			: FileImages(true)
+			, headerAddr(0)
+			, banner(false)
+			, icons(false)
+		{ }
+
+	private:
+		Q_DISABLE_COPY(VmuFileImages)
+
+	public:
+		void decode(void) final;
+
+	public:
+		// VMU file header.
+		vmu_file_header fileHeader;
+
+		// File data.
+		// Empty once the images have been decoded.
+		QByteArray data;
+		int headerAddr;
+
+		// Images to decode.
+		bool banner;
+		bool icons;
 };
 
 /**
@@ -285,8 +360,9 @@ void VmuFilePrivate::loadFileInfo(void)
 		description = filename + QChar(L'\0') + dc_desc;
 	}
 
-	// Load the banner and icon images.
-	loadImages();
+	// Reset the banner and icon images.
+	// They will be loaded on first use.
+	resetImages();
 }
 
 /**
@@ -318,9 +394,24 @@ GcImage *VmuFilePrivate::loadBannerImage(void)
 	// TODO: Copy over the block code from GcnFile::loadIconImages(),
 	// but move the "read from X to Y" code down to File.
 	QByteArray data = this->loadFileData();
+	return decodeBannerImage(fileHeader, data, dirEntry->header_addr * card->blockSize());
+}
 
+/**
+ * Decode the eyecatch (banner) image.
+ * This function is reentrant.
+ * NOTE: Only VMU_EYECATCH_PALETTE_16 is supported.
+ * The caller must check the eyecatch type.
+ * @param fileHeader	[in] VMU file header.
+ * @param data		[in] File data.
+ * @param headerAddr	[in] Address of the file header within data.
+ * @return GcImage containing the banner image, or nullptr on error.
+ */
+GcImage *VmuFilePrivate::decodeBannerImage(const vmu_file_header *fileHeader,
+	const QByteArray &data, int headerAddr)
+{
 	// Eyecatch start address.
-	int eyecatchStart = (dirEntry->header_addr * card->blockSize());
+	int eyecatchStart = headerAddr;
 	eyecatchStart += sizeof(*fileHeader);
 	if (fileHeader->icon_count > 0) {
 		eyecatchStart += sizeof(vmu_icon_palette);
@@ -335,7 +426,7 @@ GcImage *VmuFilePrivate::loadBannerImage(void)
 		return nullptr;
 	}
 
-	const vmu_eyecatch_palette_16 *eyecatch16 = (const vmu_eyecatch_palette_16*)(data.data() + eyecatchStart);
+	const vmu_eyecatch_palette_16 *eyecatch16 = (const vmu_eyecatch_palette_16*)(data.constData() + eyecatchStart);
 	GcImage *gcImage = DcImageLoader::fromPalette16(
 				VMU_EYECATCH_W, VMU_EYECATCH_H,
 				eyecatch16->eyecatch, sizeof(eyecatch16->eyecatch),
@@ -381,28 +472,38 @@ QVector<GcImage*> VmuFilePrivate::loadIconImages(void)
 		return ret;
 	}
 
-	// DC only supports looping icon animations.
-	// TODO: Use system-independent values?
-	this->iconAnimMode = 0;
-
+	// NOTE: Icon animation metadata is set by loadIconInfo().
 	if (!fileHeader || fileHeader->icon_count == 0) {
 		// No file header or icons.
 		return QVector<GcImage*>();
 	}
 
-	// Sanity check: Clamp to 8 icons maximum.
-	int iconCount = fileHeader->icon_count;
-	if (iconCount > 8)
-		iconCount = 8;
-
 	// Load the file into memory.
 	// TODO: Optimize by only reading in required data.
 	// TODO: Copy over the block code from GcnFile::loadIconImages(),
 	// but move the "read from X to Y" code down to File.
 	QByteArray data = this->loadFileData();
+	return decodeIconImages(fileHeader, data, dirEntry->header_addr * card->blockSize());
+}
+
+/**
+ * Decode the icon images.
+ * This function is reentrant.
+ * @param fileHeader	[in] VMU file header.
+ * @param data		[in] File data.
+ * @param headerAddr	[in] Address of the file header within data.
+ * @return QVector<GcImage*> containing the icon images, or empty QVector on error.
+ */
+QVector<GcImage*> VmuFilePrivate::decodeIconImages(const vmu_file_header *fileHeader,
+	const QByteArray &data, int headerAddr)
+{
+	// Sanity check: Clamp to 8 icons maximum.
+	int iconCount = fileHeader->icon_count;
+	if (iconCount > 8)
+		iconCount = 8;
 
 	// Icon start address.
-	int iconStart = (dirEntry->header_addr * card->blockSize());
+	int iconStart = headerAddr;
 	iconStart += sizeof(*fileHeader);
 
 	// Calculate the total icon length.
@@ -414,16 +515,11 @@ QVector<GcImage*> VmuFilePrivate::loadIconImages(void)
 		return QVector<GcImage*>();
 	}
 
-	const char *pIconStart = (data.data() + iconStart);
+	const char *pIconStart = (data.constData() + iconStart);
 	const vmu_icon_palette *palette = (const vmu_icon_palette*)pIconStart;
 	const vmu_icon_data *iconData = (const vmu_icon_data*)(pIconStart + sizeof(*palette));
 	QVector<GcImage*> gcImages;
-	// TODO: Should be part of a struct that's returned...
-	this->iconSpeed.clear();
 	for (int i = 0; i < iconCount; i++, iconData++) {
-		// TODO: Should be part of a struct that's returned...
-		// TODO: Convert DC icon speed to system-independent value.
-		this->iconSpeed.append(3);
 		GcImage *gcImage = DcImageLoader::fromPalette16(
 					VMU_ICON_W, VMU_ICON_H,
 					iconData->icon, sizeof(iconData->icon),
@@ -434,6 +530,55 @@ QVector<GcImage*> VmuFilePrivate::loadIconImages(void)
 	return gcImages;
 }
 
+/**
+ * Load the icon animation metadata without decoding the icons.
+ * This is calculated from the file header.
+ * @return True on success; false for ICONDATA_VMS.
+ */
+bool VmuFilePrivate::loadIconInfo(void)
+{
+	if (isIconData) {
+		// ICONDATA_VMS icons must be decoded.
+		return false;
+	}
+
+	// DC only supports looping icon animations.
+	// TODO: Use system-independent values?
+	this->iconAnimMode = 0;
+	this->iconSpeed.clear();
+	this->iconInfoCount = 0;
+
+	if (!fileHeader || fileHeader->icon_count == 0) {
+		// No file header or icons.
+		return true;
+	}
+
+	// Sanity check: Clamp to 8 icons maximum.
+	int iconCount = fileHeader->icon_count;
+	if (iconCount > 8)
+		iconCount = 8;
+
+	// If the icons aren't within the file,
+	// loadIconImages() won't load any icons.
+	const int blockSize = card->blockSize();
+	if (this->size() > card->totalUserBlocks()) {
+		// File is larger than the card.
+		return true;
+	}
+	const int iconStart = (dirEntry->header_addr * blockSize) + sizeof(*fileHeader);
+	const int totalIconLen = sizeof(vmu_icon_palette) +
+				(sizeof(vmu_icon_data) * iconCount);
+	if (this->size() * blockSize < iconStart + totalIconLen) {
+		// File is too small.
+		return true;
+	}
+
+	// TODO: Convert DC icon speed to system-independent value.
+	this->iconSpeed.fill(3, iconCount);
+	this->iconInfoCount = iconCount;
+	return true;
+}
+
 /**
  * Load the icon images.
  * Special version for ICONDATA_VMS.
@@ -505,6 +650,74 @@ void VmuFilePrivate::loadIconImages_ICONDATA_VMS(void)
 	}
 }
 
+/**
+ * Copy the raw banner and icon data without decoding the images.
+ * @param banner	[in] If true, copy the banner data.
+ * @param icons		[in] If true, copy the icon data.
+ * @return VmuFileImages (caller must delete it), or nullptr for ICONDATA_VMS.
+ */
+FileImages *VmuFilePrivate::copyRawImages(bool banner, bool icons)
+{
+	if (isIconData) {
+		// ICONDATA_VMS icons are loaded differently.
+		return nullptr;
+	}
+
+	VmuFileImages *const images = new VmuFileImages();
+	if (!fileHeader) {
+		// No file header, so no images.
+		return images;
+	}
+
+	images->fileHeader = *fileHeader;
+	images->headerAddr = dirEntry->header_addr * card->blockSize();
+	images->banner = (banner && fileHeader->eyecatch_type == VMU_EYECATCH_PALETTE_16);
+	images->icons = (icons && fileHeader->icon_count > 0);
+	if (images->banner || images->icons) {
+		// TODO: Optimize by only reading in required data.
+		images->data = this->loadFileData();
+	}
+
+	if (icons) {
+		initIconInfo();
+		images->iconDelays.resize(iconSpeed.size());
+		for (int i = 0; i < iconSpeed.size(); i++) {
+			images->iconDelays[i] = iconSpeed.at(i);
+		}
+		images->iconAnimMode = (iconAnimMode & 0x4);
+	}
+
+	return images;
+}
+
+/** VmuFileImages **/
+
+/**
+ * Decode the banner and icon images from the raw image data.
+ * This function is reentrant, so it can be called on a worker thread.
+ */
+void VmuFileImages::decode(void)
+{
+	if (!data.isEmpty()) {
+		if (banner) {
+			gcBanner = VmuFilePrivate::decodeBannerImage(&fileHeader, data, headerAddr);
+		}
+
+		if (icons) {
+			const QVector<GcImage*> gcImages =
+				VmuFilePrivate::decodeIconImages(&fileHeader, data, headerAddr);
+			gcIcons.resize(gcImages.size());
+			for (int i = 0; i < gcImages.size(); i++) {
+				gcIcons[i] = gcImages.at(i);
+			}
+		}
+		data.clear();
+	}
+
+	// One icon delay per decoded icon.
+	iconDelays.resize(gcIcons.size());
+}
+
 /** VmuFile **/
 
 /**
@@ -611,6 +824,8 @@ int VmuFile::exportToFile(QIODevice *qioDevice)
 const GcImage *VmuFile::vmu_icondata_mono(void) const
 {
 	Q_D(const VmuFile);
+	// ICONDATA_VMS icons are decoded by loadIconImages().
+	d->loadImages();
 	return d->vmu_icon_mono;
 }
 
@@ -622,5 +837,7 @@ const GcImage *VmuFile::vmu_icondata_mono(void) const
 const GcImage *VmuFile::vmu_icondata_color(void) const
 {
 	Q_D(const VmuFile);
+	// ICONDATA_VMS icons are decoded by loadIconImages().
+	d->loadImages();
 	return d->vmu_icon_color;
 }
@@ -0,0 +1,189 @@
+/***************************************************************************
+ * GameCube Memory Card Recovery Program [libsaveedit]                     *
+ * SaveDataBuffer.cpp: Save file data buffer with dirty range tracking.    *
+ *                                                                         *
+ * Copyright (c) 2015-2018 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "SaveDataBuffer.hpp"
+
+// Files.
+#include "libmemcard/File.hpp"
+
+// Byteswapping macros.
+#include "util/byteswap.h"
+
+// C includes. (C++ namespace)
+#include <cassert>
+#include <cerrno>
+
+// Changed bytes separated by fewer unchanged bytes
+// than this are combined into a single dirty range.
+static const int DIRTY_MERGE_GAP = 16;
+
+/**
+ * Load the data from a file.
+ * This clears the dirty ranges.
+ * @param file File.
+ * @return File size in bytes, or 0 on error.
+ */
+int SaveDataBuffer::load(File *file)
+{
+	m_data = file->loadFileData();
+	m_dirty.clear();
+	return m_data.size();
+}
+
+/**
+ * Clear the buffer.
+ */
+void SaveDataBuffer::clear(void)
+{
+	m_data.clear();
+	m_dirty.clear();
+}
+
+/**
+ * Update a range of the buffer.
+ * Only bytes that differ from the current
+ * contents are marked as dirty.
+ * @param offset Offset.
+ * @param src Source data.
+ * @param length Length, in bytes.
+ * @return True if any bytes were changed; false if not.
+ */
+bool SaveDataBuffer::update(int offset, const void *src, int length)
+{
+	assert(offset >= 0 && length >= 0 && offset + length <= m_data.size());
+	if (offset < 0 || length <= 0 || offset + length > m_data.size())
+		return false;
+
+	const uint8_t *const src_u8 = static_cast<const uint8_t*>(src);
+	const uint8_t *const dest_u8 = constData(offset);
+	if (!memcmp(dest_u8, src_u8, length)) {
+		// Nothing has changed.
+		return false;
+	}
+
+	// Find the changed bytes.
+	int start = -1, end = -1;
+	for (int i = 0; i < length; i++) {
+		if (dest_u8[i] == src_u8[i])
+			continue;
+
+		if (start >= 0 && i - end > DIRTY_MERGE_GAP) {
+			// Gap is too big. Mark the previous run as dirty.
+			markDirty(offset + start, end - start);
+			start = -1;
+		}
+		if (start < 0)
+			start = i;
+		end = i + 1;
+	}
+	if (start >= 0) {
+		markDirty(offset + start, end - start);
+	}
+
+	// NOTE: QByteArray::data() detaches if the data is shared.
+	memcpy(m_data.data() + offset, src_u8, length);
+	return true;
+}
+
+/**
+ * Update a 16-bit big-endian value.
+ * @param offset Offset.
+ * @param value Value, in host byte order.
+ * @return True if the value was changed; false if not.
+ */
+bool SaveDataBuffer::updateBE16(int offset, uint16_t value)
+{
+	value = cpu_to_be16(value);
+	return update(offset, &value, sizeof(value));
+}
+
+/**
+ * Update a 16-bit little-endian value.
+ * @param offset Offset.
+ * @param value Value, in host byte order.
+ * @return True if the value was changed; false if not.
+ */
+bool SaveDataBuffer::updateLE16(int offset, uint16_t value)
+{
+	value = cpu_to_le16(value);
+	return update(offset, &value, sizeof(value));
+}
+
+/**
+ * Mark a range as dirty.
+ * @param offset Offset.
+ * @param length Length, in bytes.
+ */
+void SaveDataBuffer::markDirty(int offset, int length)
+{
+	int start = offset;
+	int end = offset + length;
+
+	// Find the first range that ends at or after the new range.
+	int i = 0;
+	while (i < m_dirty.size() && m_dirty[i].offset + m_dirty[i].length < start) {
+		i++;
+	}
+
+	// Merge all ranges that overlap or touch the new range.
+	int j = i;
+	while (j < m_dirty.size() && m_dirty[j].offset <= end) {
+		if (m_dirty[j].offset < start)
+			start = m_dirty[j].offset;
+		if (m_dirty[j].offset + m_dirty[j].length > end)
+			end = m_dirty[j].offset + m_dirty[j].length;
+		j++;
+	}
+
+	Range range;
+	range.offset = start;
+	range.length = end - start;
+	if (j > i) {
+		// Replace the merged ranges.
+		m_dirty[i] = range;
+		m_dirty.remove(i + 1, j - i - 1);
+	} else {
+		m_dirty.insert(i, range);
+	}
+}
+
+/**
+ * Write the dirty ranges to a file.
+ * The dirty ranges are cleared on success.
+ * @param file File.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int SaveDataBuffer::writeDirtyRanges(File *file)
+{
+	if (!file)
+		return -EBADF;
+
+	if (m_dirty.isEmpty())
+		return 0;
+
+	// Write all of the ranges at once so each block
+	// is only read, compared, and written once.
+	QVector<File::WriteRange> ranges;
+	ranges.reserve(m_dirty.size());
+	foreach (const Range &range, m_dirty) {
+		File::WriteRange writeRange;
+		writeRange.address = (uint32_t)range.offset;
+		writeRange.length = (uint32_t)range.length;
+		ranges.append(writeRange);
+	}
+
+	int ret = file->write(constData(), ranges);
+	if (ret < 0) {
+		// Error writing the data.
+		// Leave the dirty ranges as-is so the save can be retried.
+		return ret;
+	}
+
+	m_dirty.clear();
+	return 0;
+}
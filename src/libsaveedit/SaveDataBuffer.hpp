@@ -0,0 +1,232 @@
+/***************************************************************************
+ * GameCube Memory Card Recovery Program [libsaveedit]                     *
+ * SaveDataBuffer.hpp: Save file data buffer with dirty range tracking.    *
+ *                                                                         *
+ * Copyright (c) 2015-2018 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#ifndef __LIBSAVEEDIT_SAVEDATABUFFER_HPP__
+#define __LIBSAVEEDIT_SAVEDATABUFFER_HPP__
+
+// C includes.
+#include <stdint.h>
+
+// C includes. (C++ namespace)
+#include <cstring>
+
+// Qt includes.
+#include <QtCore/QByteArray>
+#include <QtCore/QVector>
+
+class File;
+
+/**
+ * Save file data buffer.
+ *
+ * Editors read the file once, access save slots using
+ * SaveSlotView, and write back only the byte ranges
+ * that have actually changed.
+ *
+ * Data is stored in the file's byte order.
+ */
+class SaveDataBuffer
+{
+	public:
+		SaveDataBuffer() { }
+
+	private:
+		Q_DISABLE_COPY(SaveDataBuffer)
+
+	public:
+		// Byte range.
+		struct Range {
+			int offset;
+			int length;
+		};
+
+		/**
+		 * Load the data from a file.
+		 * This clears the dirty ranges.
+		 * @param file File.
+		 * @return File size in bytes, or 0 on error.
+		 */
+		int load(File *file);
+
+		/**
+		 * Clear the buffer.
+		 */
+		void clear(void);
+
+		/**
+		 * Get the buffer size.
+		 * @return Buffer size, in bytes.
+		 */
+		inline int size(void) const
+		{
+			return m_data.size();
+		}
+
+		/**
+		 * Get a pointer to the data at the specified offset.
+		 * @param offset Offset.
+		 * @return Pointer to the data.
+		 */
+		inline const uint8_t *constData(int offset = 0) const
+		{
+			return reinterpret_cast<const uint8_t*>(m_data.constData()) + offset;
+		}
+
+		/**
+		 * Update a range of the buffer.
+		 * Only bytes that differ from the current
+		 * contents are marked as dirty.
+		 * @param offset Offset.
+		 * @param src Source data.
+		 * @param length Length, in bytes.
+		 * @return True if any bytes were changed; false if not.
+		 */
+		bool update(int offset, const void *src, int length);
+
+		/**
+		 * Update a 16-bit big-endian value.
+		 * @param offset Offset.
+		 * @param value Value, in host byte order.
+		 * @return True if the value was changed; false if not.
+		 */
+		bool updateBE16(int offset, uint16_t value);
+
+		/**
+		 * Update a 16-bit little-endian value.
+		 * @param offset Offset.
+		 * @param value Value, in host byte order.
+		 * @return True if the value was changed; false if not.
+		 */
+		bool updateLE16(int offset, uint16_t value);
+
+		/**
+		 * Have any bytes been changed since the data was loaded or written?
+		 * @return True if dirty; false if not.
+		 */
+		inline bool isDirty(void) const
+		{
+			return !m_dirty.isEmpty();
+		}
+
+		/**
+		 * Get the dirty ranges.
+		 * Ranges are sorted and don't overlap.
+		 * @return Dirty ranges.
+		 */
+		inline const QVector<Range> &dirtyRanges(void) const
+		{
+			return m_dirty;
+		}
+
+		/**
+		 * Write the dirty ranges to a file.
+		 * The dirty ranges are cleared on success.
+		 * @param file File.
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		int writeDirtyRanges(File *file);
+
+	private:
+		/**
+		 * Mark a range as dirty.
+		 * @param offset Offset.
+		 * @param length Length, in bytes.
+		 */
+		void markDirty(int offset, int length);
+
+		QByteArray m_data;
+		QVector<Range> m_dirty;
+};
+
+/**
+ * Typed view of a save slot in a SaveDataBuffer.
+ *
+ * The slot stays in the file's byte order in the buffer.
+ * load() and store() convert to and from host byte order,
+ * so only the slot that's being edited is converted.
+ */
+template<typename T>
+class SaveSlotView
+{
+	public:
+		/**
+		 * Byteswap function for T.
+		 * If nullptr, the file's byte order matches the host.
+		 */
+		typedef void (*ByteswapFn)(T *slot);
+
+		SaveSlotView()
+			: m_buf(nullptr)
+			, m_offset(0)
+			, m_byteswap(nullptr) { }
+
+		/**
+		 * Create a save slot view.
+		 * @param buf SaveDataBuffer.
+		 * @param offset Offset of the save slot in the buffer.
+		 * @param byteswap Byteswap function, or nullptr if the byte order matches the host.
+		 */
+		SaveSlotView(SaveDataBuffer *buf, int offset, ByteswapFn byteswap)
+			: m_buf(buf)
+			, m_offset(offset)
+			, m_byteswap(byteswap) { }
+
+		/**
+		 * Is this view valid?
+		 * @return True if the save slot is within the buffer; false if not.
+		 */
+		inline bool isValid(void) const
+		{
+			return (m_buf && m_offset >= 0 &&
+				m_offset + (int)sizeof(T) <= m_buf->size());
+		}
+
+		/**
+		 * Get the save slot's offset in the buffer.
+		 * @return Offset.
+		 */
+		inline int offset(void) const
+		{
+			return m_offset;
+		}
+
+		/**
+		 * Load the save slot in host byte order.
+		 * @param slot [out] Save slot.
+		 */
+		inline void load(T *slot) const
+		{
+			memcpy(slot, m_buf->constData(m_offset), sizeof(T));
+			if (m_byteswap)
+				m_byteswap(slot);
+		}
+
+		/**
+		 * Store the save slot.
+		 * Only bytes that have changed are marked as dirty.
+		 * @param slot Save slot, in host byte order.
+		 * @return True if the save slot was changed; false if not.
+		 */
+		inline bool store(const T *slot)
+		{
+			if (!m_byteswap)
+				return m_buf->update(m_offset, slot, sizeof(T));
+
+			T tmp;
+			memcpy(&tmp, slot, sizeof(T));
+			m_byteswap(&tmp);
+			return m_buf->update(m_offset, &tmp, sizeof(T));
+		}
+
+	private:
+		SaveDataBuffer *m_buf;
+		int m_offset;
+		ByteswapFn m_byteswap;
+};
+
+#endif /* __LIBSAVEEDIT_SAVEDATABUFFER_HPP__ */
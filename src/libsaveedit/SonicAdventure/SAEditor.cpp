@@ -23,6 +23,9 @@
 #include "util/byteswap.h"
 #include "sa_defs.h"
 
+// Save file data.
+#include "../SaveDataBuffer.hpp"
+
 // BitFlags
 #include "../models/BitFlagsModel.hpp"
 #include "SAEventFlags.hpp"
@@ -56,9 +59,20 @@ class SAEditorPrivate : public EditorWidgetPrivate
 	public:
 		Ui::SAEditor ui;
 
-		// sa_save_slot structs.
-		QVector<sa_save_slot*> data_main;
-		QVector<sadx_extra_save_slot*> data_sadx;
+		// File data. Save slots are stored here in the file's byte order.
+		SaveDataBuffer fileData;
+
+		// Save slot views.
+		// If a slot doesn't have SADX extras, its data_sadx view is invalid.
+		QVector<SaveSlotView<sa_save_slot> > data_main;
+		QVector<SaveSlotView<sadx_extra_save_slot> > data_sadx;
+
+		// Current save slot, in host byte order.
+		// Only the slot that's being edited is converted.
+		sa_save_slot cur_sa_save;
+		sadx_extra_save_slot cur_sadx_extra_save;
+		// Save slot that was loaded into the widgets. (-1 for none)
+		int loadedSlot;
 
 		// Editor widgets. (non-flags)
 		QVector<SAEditWidget*> saEditWidgets;
@@ -86,7 +100,7 @@ class SAEditorPrivate : public EditorWidgetPrivate
 		int load(File *file);
 
 		/**
-		 * Clear the sa_save_slot structs.
+		 * Clear the file data.
 		 */
 		void clear(void);
 
@@ -118,6 +132,7 @@ SAEditorPrivate::SAEditorPrivate(SAEditor* q)
 	, saEventFlagsModel(nullptr)
 	, saNPCFlagsModel(nullptr)
 	, sadxMissionFlagsModel(nullptr)
+	, loadedSlot(-1)
 { }
 
 SAEditorPrivate::~SAEditorPrivate()
@@ -137,7 +152,8 @@ int SAEditorPrivate::load(File *file)
 	clear();
 
 	// Read the new file.
-	QByteArray data = file->loadFileData();
+	// The save slots are accessed directly in this buffer.
+	fileData.load(file);
 
 	// Determine which version of the game this save file is for.
 	// TODO: Test for GCN first, then DC?
@@ -145,55 +161,52 @@ int SAEditorPrivate::load(File *file)
 	int ret = -1;
 	if (qobject_cast<VmuFile*>(file) != nullptr) {
 		// DC version.
+		// Dreamcast's SH-4 is little-endian.
+#if SYS_BYTEORDER == SYS_BIG_ENDIAN
+		SaveSlotView<sa_save_slot>::ByteswapFn byteswap = byteswap_sa_save_slot;
+#else /* SYS_BYTEORDER == SYS_LIL_ENDIAN */
+		SaveSlotView<sa_save_slot>::ByteswapFn byteswap = nullptr;
+#endif
 
 		// Three, count 'em, *three* save slots!
-		const char *src = (data.data() + SA_SAVE_ADDRESS_DC_0);
-		for (int i = 0; i < 3; i++, src += sizeof(sa_save_slot)) {
-			sa_save_slot *const sa_save = new sa_save_slot;
-			memcpy(sa_save, src, sizeof(*sa_save));
-			data_main.append(sa_save);
-			data_sadx.append(nullptr);	// DC version - no SADX extras.
-#if SYS_BYTEORDER == SYS_BIG_ENDIAN
-			// Byteswap the data.
-			// Dreamcast's SH-4 is little-endian.
-			byteswap_sa_save_slot(sa_save);
-#endif /* SYS_BYTEORDER == SYS_BIG_ENDIAN */
+		int offset = SA_SAVE_ADDRESS_DC_0;
+		for (int i = 0; i < 3; i++, offset += sizeof(sa_save_slot)) {
+			SaveSlotView<sa_save_slot> sa_view(&fileData, offset, byteswap);
+			if (!sa_view.isValid()) {
+				// File is too small.
+				break;
+			}
+			data_main.append(sa_view);
+			// DC version - no SADX extras.
+			data_sadx.append(SaveSlotView<sadx_extra_save_slot>());
 
 			// Loaded successfully.
 			ret = 0;
 		}
 	} else if (qobject_cast<GcnFile*>(file) != nullptr) {
 		// GameCube verison.
+		// GameCube's PowerPC 750 is big-endian.
+#if SYS_BYTEORDER == SYS_LIL_ENDIAN
+		SaveSlotView<sa_save_slot>::ByteswapFn byteswap = byteswap_sa_save_slot;
+		SaveSlotView<sadx_extra_save_slot>::ByteswapFn byteswap_dx = byteswap_sadx_extra_save_slot;
+#else /* SYS_BYTEORDER == SYS_BIG_ENDIAN */
+		SaveSlotView<sa_save_slot>::ByteswapFn byteswap = nullptr;
+		SaveSlotView<sadx_extra_save_slot>::ByteswapFn byteswap_dx = nullptr;
+#endif
 
 		// Only one save slot.
-		sa_save_slot *const sa_save = new sa_save_slot;
-		memcpy(sa_save, (data.data() + SA_SAVE_ADDRESS_GCN), sizeof(*sa_save));
-		data_main.append(sa_save);
+		SaveSlotView<sa_save_slot> sa_view(&fileData, SA_SAVE_ADDRESS_GCN, byteswap);
+		if (sa_view.isValid()) {
+			data_main.append(sa_view);
 
-#if SYS_BYTEORDER == SYS_LIL_ENDIAN
-		// Byteswap the data.
-		// GameCube's PowerPC 750 is big-endian.
-		byteswap_sa_save_slot(sa_save);
-#endif /* SYS_BYTEORDER == SYS_LIL_ENDIAN */
-
-		// Check for SADX extras.
-		if (data.size() >= (int)(SA_SAVE_ADDRESS_GCN + sizeof(*sa_save) + sizeof(sadx_extra_save_slot))) {
-			// Found SADX extras.
-			sadx_extra_save_slot *const sadx_extra_save = new sadx_extra_save_slot;
-			memcpy(sadx_extra_save, (data.data() + SA_SAVE_ADDRESS_GCN + sizeof(*sa_save)), sizeof(*sadx_extra_save));
-			data_sadx.append(sadx_extra_save);
-#if SYS_BYTEORDER == SYS_LIL_ENDIAN
-			// Byteswap the data.
-			// GameCube's PowerPC 750 is big-endian.
-			byteswap_sadx_extra_save_slot(sadx_extra_save);
-#endif /* SYS_BYTEORDER == SYS_LIL_ENDIAN */
-		} else {
-			// No SADX extras.
-			data_sadx.append(nullptr);
-		}
+			// Check for SADX extras.
+			// If the file is too small, the view is invalid.
+			data_sadx.append(SaveSlotView<sadx_extra_save_slot>(&fileData,
+				SA_SAVE_ADDRESS_GCN + sizeof(sa_save_slot), byteswap_dx));
 
-		// Loaded successfully.
-		ret = 0;
+			// Loaded successfully.
+			ret = 0;
+		}
 	} else {
 		// Unsupported file.
 		// TODO: Add support for the Windows version.
@@ -202,11 +215,18 @@ int SAEditorPrivate::load(File *file)
 	}
 
 end:
-	if (ret == 0) {
-		// File loaded successfully.
-		this->file = file;
+	if (ret != 0) {
+		// No save slots were loaded, e.g. if the file is too small.
+		// There's nothing to display, so disable the editor.
+		clear();
+		ui.tabWidget->setEnabled(false);
+		return ret;
 	}
 
+	// File loaded successfully.
+	this->file = file;
+	ui.tabWidget->setEnabled(true);
+
 	// Update the display.
 	Q_Q(SAEditor);
 	setSaveSlots(data_main.size());
@@ -217,23 +237,14 @@ end:
 }
 
 /**
- * Clear the sa_save_slot structs.
+ * Clear the file data.
  */
 void SAEditorPrivate::clear(void)
 {
-	// Delete all loaded sa_save_slot structs.
-	// NOTE: sa_save_slot is allocated using new, so use delete.
-	foreach (sa_save_slot *sa_save, data_main) {
-		delete sa_save;
-	}
 	data_main.clear();
-
-	// Delete loaded SADX extra save structs.
-	// NOTE: sadx_extra_save_slot is allocated using new, so use delete.
-	foreach (sadx_extra_save_slot *sadx_extra_save, data_sadx) {
-		delete sadx_extra_save;
-	}
 	data_sadx.clear();
+	fileData.clear();
+	loadedSlot = -1;
 }
 
 /**
@@ -242,9 +253,14 @@ void SAEditorPrivate::clear(void)
 void SAEditorPrivate::updateDisplay(void)
 {
 	assert(this->currentSaveSlot >= 0 && this->currentSaveSlot < this->saveSlots);
+	if (this->currentSaveSlot >= data_main.size()) {
+		// No save slot data. (File wasn't loaded.)
+		return;
+	}
 
 	// Display the data.
-	const sa_save_slot *sa_save = data_main.at(this->currentSaveSlot);
+	data_main.at(this->currentSaveSlot).load(&cur_sa_save);
+	const sa_save_slot *sa_save = &cur_sa_save;
 	foreach (SAEditWidget *saEditWidget, saEditWidgets) {
 		saEditWidget->load(sa_save);
 	}
@@ -261,8 +277,11 @@ void SAEditorPrivate::updateDisplay(void)
 	Q_Q(SAEditor);
 	const int missions_tab_idx = ui.tabWidget->indexOf(ui.tabMissions);
 	const sadx_extra_save_slot *sadx_extra_save = nullptr;
-	if (this->currentSaveSlot < data_sadx.size()) {
-		sadx_extra_save = data_sadx.at(this->currentSaveSlot);
+	if (this->currentSaveSlot < data_sadx.size() &&
+	    data_sadx.at(this->currentSaveSlot).isValid())
+	{
+		data_sadx.at(this->currentSaveSlot).load(&cur_sadx_extra_save);
+		sadx_extra_save = &cur_sadx_extra_save;
 	}
 	if (sadx_extra_save) {
 		// SADX extra data found. Load it.
@@ -295,6 +314,9 @@ void SAEditorPrivate::updateDisplay(void)
 			ui.tabMissions->setParent(q);
 		}
 	}
+
+	// The widgets now have this slot's data.
+	loadedSlot = this->currentSaveSlot;
 }
 
 /**
@@ -303,9 +325,13 @@ void SAEditorPrivate::updateDisplay(void)
 void SAEditorPrivate::saveCurrentSlot(void)
 {
 	assert(this->currentSaveSlot >= 0 && this->currentSaveSlot < this->saveSlots);
+	if (loadedSlot != this->currentSaveSlot) {
+		// The widgets don't have this slot's data.
+		return;
+	}
 
 	// Save the data.
-	sa_save_slot *sa_save = data_main.at(this->currentSaveSlot);
+	sa_save_slot *sa_save = &cur_sa_save;
 	foreach (SAEditWidget *saEditWidget, saEditWidgets) {
 		saEditWidget->save(sa_save);
 	}
@@ -314,13 +340,16 @@ void SAEditorPrivate::saveCurrentSlot(void)
 	saEventFlags.allFlags(&sa_save->events.all[0], NUM_ELEMENTS(sa_save->events.all));
 	saNPCFlags.allFlags(&sa_save->npc.all[0], NUM_ELEMENTS(sa_save->npc.all));
 
+	// Store the slot in the file data.
+	// Only the bytes that have changed are marked as dirty.
+	data_main[this->currentSaveSlot].store(sa_save);
+
 	// SADX extra data?
-	sadx_extra_save_slot *sadx_extra_save = nullptr;
-	if (this->currentSaveSlot < data_sadx.size()) {
-		sadx_extra_save = data_sadx.at(this->currentSaveSlot);
-	}
-	if (sadx_extra_save) {
+	if (this->currentSaveSlot < data_sadx.size() &&
+	    data_sadx.at(this->currentSaveSlot).isValid())
+	{
 		// SADX extra data found. Save it.
+		sadx_extra_save_slot *sadx_extra_save = &cur_sadx_extra_save;
 		foreach (SADXEditWidget *sadxEditWidget, sadxEditWidgets) {
 			sadxEditWidget->saveDX(sadx_extra_save);
 		}
@@ -328,6 +357,8 @@ void SAEditorPrivate::saveCurrentSlot(void)
 		// Missions.
 		sadxMissionFlags.allFlags(&sadx_extra_save->missions[0],
 				NUM_ELEMENTS(sadx_extra_save->missions));
+
+		data_sadx[this->currentSaveSlot].store(sadx_extra_save);
 	}
 }
 
@@ -589,98 +620,49 @@ int SAEditor::save(void)
 	// Make sure the current slot is saved.
 	d->saveCurrentSlot();
 
-	// Read the existing file data first.
-	QByteArray data = d->file->loadFileData();
-
 	// Determine which version of the game this save file is for.
 	// TODO: Test for GCN first, then DC?
 	int ret = -EINVAL;
 	if (qobject_cast<VmuFile*>(d->file) != nullptr) {
 		// DC version.
 
-		// Three, count 'em, *three* save slots!
-		char *dest = (data.data() + SA_SAVE_ADDRESS_DC_0);
-		for (int i = 0; i < 3; i++, dest += sizeof(sa_save_slot)) {
-			sa_save_slot *const sa_save = reinterpret_cast<sa_save_slot*>(dest);
-			assert(d->data_main.size() > i);
-			if (d->data_main.size() > i) {
-				// Save the slot.
-				memcpy(sa_save, d->data_main.at(i), sizeof(*sa_save));
-#if SYS_BYTEORDER == SYS_BIG_ENDIAN
-				// Byteswap the data.
-				// Dreamcast's SH-4 is little-endian.
-				d->byteswap_sa_save_slot(sa_save);
-#endif /* SYS_BYTEORDER == SYS_BIG_ENDIAN */
-			} else {
-				// No save slot available...
-				// Zero out the data.
-				memset(sa_save, 0, sizeof(*sa_save));
-			}
-
-			// Update the checksums.
-			// TODO: Not tested!
-			// Note that there are two sets of checksums:
-			// - Game checksum (CRC-16) [one per slot]
-			// - VMS checksum (custom)
-			uint8_t *src = (uint8_t*)data.data() + SA_SAVE_ADDRESS_DC_0;
-			for (int i = 0; i < 3; i++, src += sizeof(*sa_save)) {
-				uint16_t crc16 = Checksum::Crc16(src + 4, sizeof(*sa_save) - 4);
-				crc16 = cpu_to_le16(crc16);
-				memcpy(src + 2, &crc16, sizeof(crc16));
-			}
-
-			// VMS checksum.
-			uint16_t vmschk = Checksum::DreamcastVMU(src, data.size(), 0x46);
-			vmschk = cpu_to_le16(vmschk);
-			memcpy(&src[0x46], &vmschk, sizeof(vmschk));
-
-			// Save slots copied.
-			// Now it needs to be written to the file.
+		// Update the checksums.
+		// TODO: Not tested!
+		// Note that there are two sets of checksums:
+		// - Game checksum (CRC-16) [one per slot]
+		// - VMS checksum (custom)
+		foreach (const SaveSlotView<sa_save_slot> &sa_view, d->data_main) {
+			const int offset = sa_view.offset();
+			const uint16_t crc16 = Checksum::Crc16(d->fileData.constData(offset + 4),
+				sizeof(sa_save_slot) - 4);
+			d->fileData.updateLE16(offset + 2, crc16);
 		}
-	} else if (qobject_cast<GcnFile*>(d->file) != nullptr) {
-		// GameCube verison.
 
-		// Only one save slot.
-		sa_save_slot *const sa_save = reinterpret_cast<sa_save_slot*>
-			(data.data() + SA_SAVE_ADDRESS_GCN);
-		assert(d->data_main.size() > 0);
-		if (d->data_main.size() > 0) {
-			memcpy(sa_save, d->data_main.at(0), sizeof(*sa_save));
-#if SYS_BYTEORDER == SYS_LIL_ENDIAN
-			// Byteswap the data.
-			// GameCube's PowerPC 750 is big-endian.
-			d->byteswap_sa_save_slot(sa_save);
-#endif /* SYS_BYTEORDER == SYS_LIL_ENDIAN */
-		} else {
-			// No save slot available...
-			// Zero out the data.
-			memset(sa_save, 0, sizeof(*sa_save));
+		// VMS checksum.
+		// This covers the entire file, so it must be updated last.
+		if (d->fileData.isDirty()) {
+			const uint16_t vmschk = Checksum::DreamcastVMU(d->fileData.constData(),
+				d->fileData.size(), 0x46);
+			d->fileData.updateLE16(0x46, vmschk);
 		}
 
-		// Check for SADX extras.
-		sadx_extra_save_slot *const sadx_extra_save = reinterpret_cast<sadx_extra_save_slot*>
-			(data.data() + SA_SAVE_ADDRESS_GCN + sizeof(*sa_save));
-		if (d->data_sadx.size() > 0) {
-			// Found SADX extras.
-			memcpy(sadx_extra_save, d->data_sadx.at(0), sizeof(*sadx_extra_save));
-#if SYS_BYTEORDER == SYS_LIL_ENDIAN
-			// Byteswap the data.
-			// GameCube's PowerPC 750 is big-endian.
-			d->byteswap_sadx_extra_save_slot(sadx_extra_save);
-#endif /* SYS_BYTEORDER == SYS_LIL_ENDIAN */
-		} else {
-			// No SADX extras.
-			// Zero out the data.
-			memset(sadx_extra_save, 0, sizeof(*sadx_extra_save));
-		}
+		// Save slots updated.
+		// Now it needs to be written to the file.
+		ret = 0;
+	} else if (qobject_cast<GcnFile*>(d->file) != nullptr) {
+		// GameCube verison.
 
 		// Update the checksum.
-		uint16_t crc16 = Checksum::Crc16((const uint8_t*)data.data() + SA_SAVE_ADDRESS_GCN + 4,
-			sizeof(*sa_save) + sizeof(*sadx_extra_save) - 4);
-		crc16 = cpu_to_be16(crc16);
-		memcpy(data.data() + 0x1442, &crc16, sizeof(crc16));
+		// This covers the save slot and the SADX extras.
+		uint32_t crc_len = sizeof(sa_save_slot) - 4;
+		if (!d->data_sadx.isEmpty() && d->data_sadx.at(0).isValid()) {
+			crc_len += sizeof(sadx_extra_save_slot);
+		}
+		const uint16_t crc16 = Checksum::Crc16(
+			d->fileData.constData(SA_SAVE_ADDRESS_GCN + 4), crc_len);
+		d->fileData.updateBE16(0x1442, crc16);
 
-		// Save slots copied.
+		// Save slots updated.
 		// Now it needs to be written to the file.
 		ret = 0;
 	} else {
@@ -691,7 +673,8 @@ int SAEditor::save(void)
 	}
 
 	// Write the data.
-	ret = d->file->write(0, data.data(), data.size());
+	// Only the ranges that have changed are written.
+	ret = d->fileData.writeDirtyRanges(d->file);
 
 end:
 	return ret;
@@ -14,8 +14,13 @@
 #include <QtCore/QString>
 #include <QtCore/QVector>
 
+// Bit manipulation and byteswapping.
+#include "util/bitstuff.h"
+#include "util/byteswap.h"
+
 // C includes. (C++ namespace)
 #include <cassert>
+#include <cstring>
 
 // TODO: Put this in a common header file somewhere.
 #define NUM_ELEMENTS(x) ((int)(sizeof(x) / sizeof(x[0])))
@@ -45,9 +50,11 @@ class BitFlagsPrivate
 		// of said class are deleted?
 		QVector<const char*> flags_desc;
 
-		// Flags.
-		// NOTE: QVector<bool> does not have bit "optimization".
-		QVector<bool> flags;
+		// Flags, packed into 64-bit words.
+		// Flag n is bit (n % 64) of word (n / 64).
+		// Unused bits in the last word are always 0.
+		QVector<quint64> words;
+		int flagCount;
 
 		// Translation context for bit flags.
 		const char *tr_ctx;
@@ -62,7 +69,8 @@ class BitFlagsPrivate
  */
 BitFlagsPrivate::BitFlagsPrivate(int total_flags, const char *tr_ctx,
 				 const bit_flag_t *bit_flags, int count)
-	: tr_ctx(tr_ctx)
+	: flagCount(total_flags)
+	, tr_ctx(tr_ctx)
 {
 	// This is initialized by a derived private class.
 	assert(total_flags > 0);
@@ -70,8 +78,7 @@ BitFlagsPrivate::BitFlagsPrivate(int total_flags, const char *tr_ctx,
 	assert(count >= 0);
 
 	// Initialize flags.
-	// QVector automatically initializes the new elements to false.
-	flags.resize(total_flags);
+	words.fill(0, (total_flags + 63) / 64);
 
 	// Initialize flags_desc.
 	// TODO: Once per derived class, rather than once per instance?
@@ -137,7 +144,7 @@ BitFlags::~BitFlags()
 int BitFlags::count(void) const
 {
 	Q_D(const BitFlags);
-	return d->flags.size();
+	return d->flagCount;
 }
 
 /**
@@ -181,7 +188,7 @@ bool BitFlags::flag(int flag) const
 		return false;
 
 	Q_D(const BitFlags);
-	return d->flags.at(flag);
+	return !!(d->words.at(flag >> 6) & (1ULL << (flag & 63)));
 }
 
 /**
@@ -195,10 +202,51 @@ void BitFlags::setFlag(int flag, bool value)
 		return;
 
 	Q_D(BitFlags);
-	d->flags[flag] = value;
+	const quint64 bit = (1ULL << (flag & 63));
+	if (value) {
+		d->words[flag >> 6] |= bit;
+	} else {
+		d->words[flag >> 6] &= ~bit;
+	}
 	emit flagChanged(flag, value);
 }
 
+/**
+ * Count the flags that are set in a range.
+ * The range is clamped to the valid flag IDs.
+ * @param firstFlag First flag ID.
+ * @param lastFlag Last flag ID. (inclusive)
+ * @return Number of flags that are set.
+ */
+int BitFlags::countSetFlags(int firstFlag, int lastFlag) const
+{
+	Q_D(const BitFlags);
+	if (firstFlag < 0)
+		firstFlag = 0;
+	if (lastFlag >= d->flagCount)
+		lastFlag = d->flagCount - 1;
+	if (firstFlag > lastFlag)
+		return 0;
+
+	const quint64 *const words = d->words.constData();
+	const int firstWord = firstFlag >> 6;
+	const int lastWord = lastFlag >> 6;
+	const quint64 firstMask = ~0ULL << (firstFlag & 63);
+	const quint64 lastMask = ~0ULL >> (63 - (lastFlag & 63));
+
+	if (firstWord == lastWord) {
+		// Range is within a single word.
+		return popcount64(words[firstWord] & firstMask & lastMask);
+	}
+
+	int count = popcount64(words[firstWord] & firstMask);
+	for (int i = firstWord + 1; i < lastWord; i++) {
+		count += popcount64(words[i]);
+	}
+	count += popcount64(words[lastWord] & lastMask);
+	return count;
+}
+
 /**
  * Get all of the bit flags.
  *
@@ -206,6 +254,9 @@ void BitFlags::setFlag(int flag, bool value)
  * - Too small: Array will be used for the first sz*8 flags.
  * - Too big: Array will be used for count()*8 flags.
  *
+ * If count() isn't a multiple of 8, the unused bits
+ * in the last byte are left unchanged.
+ *
  * TODO: Various bit flag encodings.
  *
  * @param data Bit flags.
@@ -221,23 +272,32 @@ int BitFlags::allFlags(uint8_t *data, int sz) const
 
 	// Convert to bits.
 	int bits = sz * 8;
-	if (bits > d->flags.count())
-		bits = d->flags.count();
-
-	// TODO: Verify that this is correct.
-	const bool *flagBool = d->flags.constData();
-	for (int i = 0; i < bits; i++, flagBool++) {
-		if (i % 8 == 0) {
-			// New byte.
-			// TODO: Optimize this?
-			if (i > 0)
-				data++;
-			*data = 0;
-		}
+	if (bits > d->flagCount)
+		bits = d->flagCount;
+
+	// Flag n is bit (n % 8) of byte (n / 8), so the packed
+	// words have the same layout as the data in little-endian.
+	const quint64 *words = d->words.constData();
+	const int fullBytes = bits / 8;
+	const int fullWords = fullBytes / 8;
+	for (int i = fullWords; i > 0; i--, words++, data += 8) {
+		const quint64 word = cpu_to_le64(*words);
+		memcpy(data, &word, sizeof(word));
+	}
 
-		// Get this flag.
-		*data >>= 1;
-		*data |= (*flagBool ? 0x80 : 0);
+	const int remBytes = fullBytes % 8;
+	const int remBits = bits % 8;
+	if (remBytes > 0 || remBits > 0) {
+		// Partial word.
+		quint64 word = *words;
+		for (int i = remBytes; i > 0; i--, data++, word >>= 8) {
+			*data = (uint8_t)word;
+		}
+		if (remBits > 0) {
+			// Partial byte.
+			const uint8_t mask = (1U << remBits) - 1;
+			*data = (*data & ~mask) | ((uint8_t)word & mask);
+		}
 	}
 
 	return bits;
@@ -265,20 +325,29 @@ int BitFlags::setAllFlags(const uint8_t *data, int sz)
 
 	// Convert to bits.
 	int bits = sz * 8;
-	if (bits > d->flags.count())
-		bits = d->flags.count();
-
-	uint8_t curByte = 0;
-	bool *flagBool = d->flags.data();
-	for (int i = 0; i < bits; i++, flagBool++) {
-		if (i % 8 == 0) {
-			// New byte.
-			curByte = *data++;
-		}
+	if (bits > d->flagCount)
+		bits = d->flagCount;
+
+	// See allFlags() for the data layout.
+	quint64 *words = d->words.data();
+	const int fullWords = bits / 64;
+	for (int i = fullWords; i > 0; i--, words++, data += 8) {
+		quint64 word;
+		memcpy(&word, data, sizeof(word));
+		*words = le64_to_cpu(word);
+	}
 
-		// Set this flag.
-		*flagBool = (curByte & 0x01);
-		curByte >>= 1;
+	const int remBits = bits % 64;
+	if (remBits > 0) {
+		// Partial word.
+		// Flags past the end of the data are left unchanged.
+		quint64 word = 0;
+		const int remBytes = (remBits + 7) / 8;
+		for (int i = 0; i < remBytes; i++) {
+			word |= ((quint64)data[i] << (i * 8));
+		}
+		const quint64 mask = ~0ULL >> (64 - remBits);
+		*words = (*words & ~mask) | (word & mask);
 	}
 
 	emit flagsChanged(0, bits-1);
@@ -114,6 +114,15 @@ class BitFlags : public QObject
 		 */
 		void setFlag(int flag, bool value);
 
+		/**
+		 * Count the flags that are set in a range.
+		 * The range is clamped to the valid flag IDs.
+		 * @param firstFlag First flag ID.
+		 * @param lastFlag Last flag ID. (inclusive)
+		 * @return Number of flags that are set.
+		 */
+		int countSetFlags(int firstFlag, int lastFlag) const;
+
 		/**
 		 * Get the bit flags as an array of bitfield data.
 		 *
@@ -121,6 +130,9 @@ class BitFlags : public QObject
 		 * - Too small: Array will be used for the first sz*8 flags.
 		 * - Too big: Array will be used for count()*8 flags.
 		 *
+		 * If count() isn't a multiple of 8, the unused bits
+		 * in the last byte are left unchanged.
+		 *
 		 * TODO: Various bit flag encodings.
 		 *
 		 * @param data Bit flags.
@@ -298,6 +298,28 @@ QString BitFlagsModel::pageName(int page) const
 	return QString();
 }
 
+/**
+ * Get the number of flags that are set on a given page.
+ * If pagination is disabled (pageSize == 0), page 0 has all flags.
+ * @param page Page number.
+ * @return Number of flags that are set.
+ */
+int BitFlagsModel::flagsSetOnPage(int page) const
+{
+	Q_D(const BitFlagsModel);
+	if (!d->bitFlags || page < 0)
+		return 0;
+
+	const int pageSize = d->bitFlags->pageSize();
+	if (pageSize <= 0) {
+		// No pagination.
+		return (page == 0 ? d->bitFlags->countSetFlags(0, INT_MAX) : 0);
+	}
+
+	const int firstFlag = page * pageSize;
+	return d->bitFlags->countSetFlags(firstFlag, firstFlag + pageSize - 1);
+}
+
 /** Slots. **/
 
 /**
@@ -85,6 +85,14 @@ class BitFlagsModel : public QAbstractListModel
 		 */
 		QString pageName(int page) const;
 
+		/**
+		 * Get the number of flags that are set on a given page.
+		 * If pagination is disabled (pageSize == 0), page 0 has all flags.
+		 * @param page Page number.
+		 * @return Number of flags that are set.
+		 */
+		int flagsSetOnPage(int page) const;
+
 	protected slots:
 		/**
 		 * BitFlags object was destroyed.
@@ -51,6 +51,11 @@ class BitFlagsViewPrivate
 		 * @param forceTextUpdate If true, update all tab text. Needed for language changes.
 		 */
 		void updateTabBar(bool forceTextUpdate = false);
+
+		/**
+		 * Update the tab tooltips with the number of flags set on each page.
+		 */
+		void updateTabToolTips(void);
 };
 
 BitFlagsViewPrivate::BitFlagsViewPrivate(BitFlagsView *q)
@@ -133,6 +138,31 @@ void BitFlagsViewPrivate::updateTabBar(bool forceTextUpdate)
 
 	// Hide the tab bar if there's only one page.
 	ui.tabBar->setVisible(pageFilterModel->pageCount() > 1);
+
+	// Update the tooltips.
+	updateTabToolTips();
+}
+
+/**
+ * Update the tab tooltips with the number of flags set on each page.
+ */
+void BitFlagsViewPrivate::updateTabToolTips(void)
+{
+	const BitFlagsModel *model = qobject_cast<const BitFlagsModel*>(pageFilterModel->sourceModel());
+	if (!model)
+		return;
+
+	const int rowCount = model->rowCount();
+	const int pageSize = pageFilterModel->pageSize();
+	const int pages = ui.tabBar->count();
+	for (int i = 0; i < pages; i++) {
+		int pageFlags = rowCount;
+		if (pageSize > 0) {
+			pageFlags = qMin(pageSize, rowCount - (i * pageSize));
+		}
+		ui.tabBar->setTabToolTip(i, BitFlagsView::tr("%1 of %2 flags set")
+			.arg(model->flagsSetOnPage(i)).arg(pageFlags));
+	}
 }
 
 /** BitFlagsView **/
@@ -216,7 +246,16 @@ void BitFlagsView::setBitFlagsModel(BitFlagsModel *bitFlagsModel)
 	// TODO: Connect destroyed() signal for BitFlagsModel?
 	// TODO: Watch for row count changes to adjust pages?
 	Q_D(BitFlagsView);
+	BitFlagsModel *const oldModel = this->bitFlagsModel();
+	if (oldModel) {
+		disconnect(oldModel, &QAbstractItemModel::dataChanged,
+			   this, &BitFlagsView::bitFlagsModel_dataChanged_slot);
+	}
 	d->pageFilterModel->setSourceModel(bitFlagsModel);
+	if (bitFlagsModel) {
+		connect(bitFlagsModel, &QAbstractItemModel::dataChanged,
+			this, &BitFlagsView::bitFlagsModel_dataChanged_slot);
+	}
 	// TODO: Signal from pageFilterModel to adjust tabs?
 	d->pageFilterModel->setPageSize(bitFlagsModel->pageSize());
 
@@ -237,3 +276,15 @@ int BitFlagsView::pageSize(void) const
 }
 
 // TODO: Page count?
+
+/** Slots. **/
+
+/**
+ * BitFlagsModel: Data has changed.
+ */
+void BitFlagsView::bitFlagsModel_dataChanged_slot(void)
+{
+	// Update the number of flags set on each page.
+	Q_D(BitFlagsView);
+	d->updateTabToolTips();
+}
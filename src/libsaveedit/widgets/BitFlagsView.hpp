@@ -59,6 +59,12 @@ class BitFlagsView : public QWidget
 		int pageSize(void) const;
 
 		// TODO: Page count?
+
+	protected slots:
+		/**
+		 * BitFlagsModel: Data has changed.
+		 */
+		void bitFlagsModel_dataChanged_slot(void);
 };
 
 #endif /* __LIBSAVEEDIT_WIDGETS_BITFLAGSVIEW_HPP__ */
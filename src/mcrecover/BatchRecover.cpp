@@ -0,0 +1,581 @@
+/***************************************************************************
+ * GameCube Memory Card Recovery Program.                                  *
+ * BatchRecover.cpp: Headless batch recovery.                              *
+ *                                                                         *
+ * Copyright (c) 2013-2018 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "config.mcrecover.h"
+#include "BatchRecover.hpp"
+
+// Files.
+#include "libmemcard/GcnCard.hpp"
+#include "libmemcard/GcnFile.hpp"
+
+// Database and search.
+#include "db/GcnMcFileDb.hpp"
+#include "db/GcnSearchWorker.hpp"
+
+// C includes. (C++ namespace)
+#include <cstdio>
+#include <cstdlib>
+
+// Qt includes.
+#include <QtCore/QAtomicInt>
+#include <QtCore/QCommandLineParser>
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDir>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFileInfo>
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QRunnable>
+#include <QtCore/QSet>
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
+#include <QtGui/QGuiApplication>
+
+/** BatchRecoverPrivate **/
+
+class BatchRecoverPrivate
+{
+	public:
+		BatchRecoverPrivate();
+		~BatchRecoverPrivate();
+
+	private:
+		Q_DISABLE_COPY(BatchRecoverPrivate)
+
+	public:
+		// Properties.
+		QString outputDir;
+		char preferredRegion;
+		bool searchUsedBlocks;
+		int jobCount;
+
+		// Last error string.
+		QString errorString;
+
+		// GCN Memory Card File databases.
+		QVector<GcnMcFileDb*> dbs;
+
+		/**
+		 * Timing information for a single card.
+		 * Times are in nanoseconds.
+		 */
+		struct CardResult {
+			QString filename;
+			QString errorString;	// Empty on success.
+			int lostFilesFound;
+			int filesExported;
+			qint64 openTime;
+			qint64 searchTime;
+			qint64 exportTime;
+		};
+
+		/**
+		 * Get the output subdirectory names for a list of cards.
+		 * Cards with the same name in different directories get
+		 * a hash of the full path appended, so concurrent jobs
+		 * never export to the same directory.
+		 * @param cardFilenames Memory card image filenames.
+		 * @return Output subdirectory names, in the same order.
+		 */
+		static QStringList cardDirNames(const QStringList &cardFilenames);
+
+		/**
+		 * Get a filename in a directory that doesn't exist yet.
+		 * If the filename is already in use, a counter is
+		 * appended to the base name.
+		 * @param dir Directory.
+		 * @param filename Filename.
+		 * @return Absolute path of an unused filename.
+		 */
+		static QString unusedFilename(const QDir &dir, const QString &filename);
+
+		/**
+		 * Process a single card.
+		 * This function is reentrant.
+		 * @param filename		[in] Memory card image filename.
+		 * @param cardDirName		[in] Output subdirectory name for this card.
+		 * @param searchThreadCount	[in] Number of search threads for this card.
+		 * @return Card result.
+		 */
+		CardResult processCard(const QString &filename, const QString &cardDirName,
+			int searchThreadCount) const;
+
+		/**
+		 * Print a card result.
+		 * @param result Card result.
+		 */
+		void printResult(const CardResult &result);
+
+		// Serializes stdout.
+		QMutex mtxOutput;
+};
+
+BatchRecoverPrivate::BatchRecoverPrivate()
+	: preferredRegion(0)
+	, searchUsedBlocks(false)
+	, jobCount(0)
+{ }
+
+BatchRecoverPrivate::~BatchRecoverPrivate()
+{
+	qDeleteAll(dbs);
+	dbs.clear();
+}
+
+/**
+ * Get the output subdirectory names for a list of cards.
+ * Cards with the same name in different directories get
+ * a hash of the full path appended, so concurrent jobs
+ * never export to the same directory.
+ * @param cardFilenames Memory card image filenames.
+ * @return Output subdirectory names, in the same order.
+ */
+QStringList BatchRecoverPrivate::cardDirNames(const QStringList &cardFilenames)
+{
+	// Count the cards using each base name.
+	QHash<QString, int> baseNameCount;
+	foreach (const QString &filename, cardFilenames) {
+		baseNameCount[QFileInfo(filename).completeBaseName()]++;
+	}
+
+	QStringList dirNames;
+	dirNames.reserve(cardFilenames.size());
+	QSet<QString> usedNames;
+	foreach (const QString &filename, cardFilenames) {
+		const QFileInfo fileInfo(filename);
+		QString dirName = fileInfo.completeBaseName();
+		if (baseNameCount.value(dirName) > 1) {
+			// Another card has the same name.
+			// Append a hash of the full path.
+			const QByteArray pathHash = QCryptographicHash::hash(
+				fileInfo.absoluteFilePath().toUtf8(), QCryptographicHash::Sha1);
+			dirName += QChar(L'.') + QString::fromLatin1(pathHash.toHex().left(8));
+		}
+
+		// The same card may have been specified more than once.
+		if (usedNames.contains(dirName)) {
+			const QString baseDirName = dirName;
+			int counter = 2;
+			do {
+				dirName = baseDirName + QChar(L'.') + QString::number(counter++);
+			} while (usedNames.contains(dirName));
+		}
+
+		usedNames.insert(dirName);
+		dirNames.append(dirName);
+	}
+
+	return dirNames;
+}
+
+/**
+ * Get a filename in a directory that doesn't exist yet.
+ * If the filename is already in use, a counter is
+ * appended to the base name.
+ * @param dir Directory.
+ * @param filename Filename.
+ * @return Absolute path of an unused filename.
+ */
+QString BatchRecoverPrivate::unusedFilename(const QDir &dir, const QString &filename)
+{
+	QString path = dir.absoluteFilePath(filename);
+	if (!QFileInfo::exists(path))
+		return path;
+
+	// Split the filename into the base name and extension.
+	QString baseName = filename;
+	QString ext;
+	const int dotPos = filename.lastIndexOf(QChar(L'.'));
+	if (dotPos > 0) {
+		baseName = filename.left(dotPos);
+		ext = filename.mid(dotPos);
+	}
+
+	int counter = 2;
+	do {
+		path = dir.absoluteFilePath(baseName + QChar(L'_') +
+			QString::number(counter++) + ext);
+	} while (QFileInfo::exists(path));
+	return path;
+}
+
+/**
+ * Process a single card.
+ * This function is reentrant.
+ * @param filename		[in] Memory card image filename.
+ * @param cardDirName		[in] Output subdirectory name for this card.
+ * @param searchThreadCount	[in] Number of search threads for this card.
+ * @return Card result.
+ */
+BatchRecoverPrivate::CardResult BatchRecoverPrivate::processCard(
+	const QString &filename, const QString &cardDirName, int searchThreadCount) const
+{
+	CardResult result;
+	result.filename = filename;
+	result.lostFilesFound = 0;
+	result.filesExported = 0;
+	result.openTime = 0;
+	result.searchTime = 0;
+	result.exportTime = 0;
+
+	QElapsedTimer timer;
+	timer.start();
+
+	// Open the card.
+	GcnCard *card = GcnCard::open(filename, nullptr);
+	result.openTime = timer.nsecsElapsed();
+	if (!card->isOpen()) {
+		result.errorString = card->errorString();
+		if (result.errorString.isEmpty()) {
+			result.errorString = QLatin1String("unable to open the card");
+		}
+		delete card;
+		return result;
+	}
+
+	// Search for lost files.
+	timer.restart();
+	GcnSearchWorker worker;
+	worker.setCard(card);
+	worker.setDatabases(dbs);
+	worker.setPreferredRegion(preferredRegion);
+	worker.setSearchUsedBlocks(searchUsedBlocks);
+	worker.setSearchThreadCount(searchThreadCount);
+	worker.setOrigThread(nullptr);
+	int ret = worker.searchMemCard();
+	if (ret < 0) {
+		result.errorString = worker.errorString();
+		result.searchTime = timer.nsecsElapsed();
+		delete card;
+		return result;
+	}
+
+	// Add the lost files to the card.
+	QList<GcnFile*> files = card->addLostFiles(worker.filesFoundList());
+	result.lostFilesFound = files.size();
+	result.searchTime = timer.nsecsElapsed();
+
+	// Export the lost files.
+	timer.restart();
+	if (!files.isEmpty()) {
+		// Each card gets its own subdirectory.
+		QDir cardDir(outputDir);
+		if (!cardDir.mkpath(cardDirName) || !cardDir.cd(cardDirName)) {
+			result.errorString = QLatin1String("unable to create output directory: ") +
+				cardDir.absoluteFilePath(cardDirName);
+		} else {
+			// Existing files are never overwritten.
+			// This also handles lost files with the same name.
+			foreach (GcnFile *file, files) {
+				ret = file->exportToFile(
+					unusedFilename(cardDir, file->defaultExportFilename()));
+				if (ret == 0) {
+					result.filesExported++;
+				}
+			}
+		}
+	}
+	result.exportTime = timer.nsecsElapsed();
+
+	delete card;
+	return result;
+}
+
+/**
+ * Print a card result.
+ * @param result Card result.
+ */
+void BatchRecoverPrivate::printResult(const CardResult &result)
+{
+	// Tab-separated; times are in milliseconds.
+	// Tabs and newlines in the error string are replaced with spaces.
+	QString err = result.errorString;
+	err.replace(QChar(L'\t'), QChar(L' '));
+	err.replace(QChar(L'\n'), QChar(L' '));
+
+	QMutexLocker locker(&mtxOutput);
+	printf("%s\t%s\t%d\t%d\t%.3f\t%.3f\t%.3f\t%.3f\t%s\n",
+		result.filename.toLocal8Bit().constData(),
+		(result.errorString.isEmpty() ? "ok" : "error"),
+		result.lostFilesFound, result.filesExported,
+		(double)result.openTime / 1000000.0,
+		(double)result.searchTime / 1000000.0,
+		(double)result.exportTime / 1000000.0,
+		(double)(result.openTime + result.searchTime + result.exportTime) / 1000000.0,
+		err.toLocal8Bit().constData());
+	fflush(stdout);
+}
+
+/** BatchRecoverTask **/
+
+/**
+ * Process a single card on a QThreadPool.
+ */
+class BatchRecoverTask : public QRunnable
+{
+	public:
+		BatchRecoverTask(BatchRecoverPrivate *d, const QString &filename,
+				const QString &cardDirName,
+				int searchThreadCount, QAtomicInt *cardsFailed)
+			: d(d)
+			, filename(filename)
+			, cardDirName(cardDirName)
+			, searchThreadCount(searchThreadCount)
+			, cardsFailed(cardsFailed)
+		{ }
+
+		virtual void run(void) final
+		{
+			BatchRecoverPrivate::CardResult result =
+				d->processCard(filename, cardDirName, searchThreadCount);
+			if (!result.errorString.isEmpty()) {
+				cardsFailed->ref();
+			}
+			d->printResult(result);
+		}
+
+	private:
+		BatchRecoverPrivate *const d;
+		const QString filename;
+		const QString cardDirName;
+		const int searchThreadCount;
+		QAtomicInt *const cardsFailed;
+};
+
+/** BatchRecover **/
+
+BatchRecover::BatchRecover()
+	: d_ptr(new BatchRecoverPrivate())
+{ }
+
+BatchRecover::~BatchRecover()
+{
+	delete d_ptr;
+}
+
+/**
+ * Batch mode entry point.
+ * This is called by mcrecover_main() if "--batch" is specified.
+ * No widgets are created in batch mode.
+ * @param argc Number of arguments.
+ * @param argv Array of arguments.
+ * @return Return value.
+ */
+int BatchRecover::main(int argc, char *argv[])
+{
+	// File loads banners and icons as QPixmaps, which requires
+	// a QGuiApplication. Use the offscreen platform so batch mode
+	// doesn't need a display.
+	if (qgetenv("QT_QPA_PLATFORM").isEmpty()) {
+		qputenv("QT_QPA_PLATFORM", "offscreen");
+	}
+	QGuiApplication app(argc, argv);
+	QCoreApplication::setApplicationVersion(
+		QString::fromLatin1(MCRECOVER_VERSION_STRING));
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription(QLatin1String(
+		"Recover lost files from GameCube memory card images.\n"
+		"One line per card is written to stdout:\n"
+		"filename, status, lost files found, files exported,\n"
+		"open ms, search ms, export ms, total ms, error"));
+	parser.addHelpOption();
+	parser.addVersionOption();
+
+	const QCommandLineOption batchOption(QLatin1String("batch"),
+		QLatin1String("Run in batch mode."));
+	const QCommandLineOption outputOption(
+		QStringList() << QLatin1String("o") << QLatin1String("output"),
+		QLatin1String("Export recovered files to <dir>/<card name>/."),
+		QLatin1String("dir"), QLatin1String("."));
+	const QCommandLineOption regionOption(
+		QStringList() << QLatin1String("r") << QLatin1String("region"),
+		QLatin1String("Preferred region. (J, E, P)"),
+		QLatin1String("region"));
+	const QCommandLineOption usedBlocksOption(QLatin1String("search-used-blocks"),
+		QLatin1String("Search all blocks, not just empty blocks."));
+	const QCommandLineOption jobsOption(
+		QStringList() << QLatin1String("j") << QLatin1String("jobs"),
+		QLatin1String("Number of cards to process concurrently. (0 for automatic)"),
+		QLatin1String("n"), QLatin1String("0"));
+	parser.addOption(batchOption);
+	parser.addOption(outputOption);
+	parser.addOption(regionOption);
+	parser.addOption(usedBlocksOption);
+	parser.addOption(jobsOption);
+	parser.addPositionalArgument(QLatin1String("cards"),
+		QLatin1String("Memory card images."), QLatin1String("cards..."));
+	parser.process(app);
+
+	const QStringList cardFilenames = parser.positionalArguments();
+	if (cardFilenames.isEmpty()) {
+		fprintf(stderr, "mcrecover: no memory card images were specified\n");
+		return EXIT_FAILURE;
+	}
+
+	BatchRecover batch;
+	batch.setOutputDir(parser.value(outputOption));
+	batch.setSearchUsedBlocks(parser.isSet(usedBlocksOption));
+	batch.setJobCount(parser.value(jobsOption).toInt());
+	const QString region = parser.value(regionOption);
+	if (!region.isEmpty()) {
+		batch.setPreferredRegion((char)region.at(0).toUpper().unicode());
+	}
+
+	// Load the databases.
+	QVector<QString> dbFilenames = GcnMcFileDb::GetDbFilenames();
+	if (batch.loadGcnMcFileDbs(dbFilenames) != 0) {
+		fprintf(stderr, "mcrecover: %s\n", batch.errorString().toLocal8Bit().constData());
+		return EXIT_FAILURE;
+	}
+
+	int ret = batch.run(cardFilenames);
+	return (ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+/** Properties. **/
+
+/**
+ * Set the output directory.
+ * Files are exported to a subdirectory named after each card.
+ * If multiple cards have the same name, a hash of the
+ * card's path is appended. Existing files are not overwritten.
+ * @param outputDir Output directory.
+ */
+void BatchRecover::setOutputDir(const QString &outputDir)
+{
+	Q_D(BatchRecover);
+	d->outputDir = outputDir;
+}
+
+/**
+ * Set the preferred region.
+ * @param preferredRegion Preferred region.
+ */
+void BatchRecover::setPreferredRegion(char preferredRegion)
+{
+	Q_D(BatchRecover);
+	d->preferredRegion = preferredRegion;
+}
+
+/**
+ * Set the "search used blocks" flag.
+ * @param searchUsedBlocks If true, search all blocks, not just empty blocks.
+ */
+void BatchRecover::setSearchUsedBlocks(bool searchUsedBlocks)
+{
+	Q_D(BatchRecover);
+	d->searchUsedBlocks = searchUsedBlocks;
+}
+
+/**
+ * Set the number of cards to process concurrently.
+ * @param jobCount Number of jobs. (0 for automatic)
+ */
+void BatchRecover::setJobCount(int jobCount)
+{
+	Q_D(BatchRecover);
+	d->jobCount = (jobCount >= 0 ? jobCount : 0);
+}
+
+/**
+ * Get the last error string.
+ * @return Last error string.
+ */
+QString BatchRecover::errorString(void) const
+{
+	Q_D(const BatchRecover);
+	return d->errorString;
+}
+
+/** Functions. **/
+
+/**
+ * Load multiple GCN Memory Card File databases.
+ * @param dbFilenames Filenames of GCN Memory Card File database.
+ * @return 0 on success; non-zero on error. (Check error string!)
+ */
+int BatchRecover::loadGcnMcFileDbs(const QVector<QString> &dbFilenames)
+{
+	Q_D(BatchRecover);
+	qDeleteAll(d->dbs);
+	d->dbs.clear();
+
+	foreach (const QString &dbFilename, dbFilenames) {
+		GcnMcFileDb *db = new GcnMcFileDb();
+		int ret = db->load(dbFilename);
+		if (!ret) {
+			d->dbs.append(db);
+		} else {
+			fprintf(stderr, "mcrecover: %s: %s\n",
+				dbFilename.toLocal8Bit().constData(),
+				db->errorString().toLocal8Bit().constData());
+			delete db;
+		}
+	}
+
+	if (d->dbs.isEmpty()) {
+		d->errorString = QLatin1String("No GCN MemCard file databases were found.");
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * Recover lost files from multiple memory card images.
+ * One line of tab-separated timing information is
+ * written to stdout for each card.
+ * @param cardFilenames Memory card image filenames.
+ * @return Number of cards that failed; negative on error.
+ */
+int BatchRecover::run(const QStringList &cardFilenames)
+{
+	Q_D(BatchRecover);
+	if (d->dbs.isEmpty()) {
+		d->errorString = QLatin1String("No GCN MemCard file databases were loaded.");
+		return -1;
+	}
+
+	int jobCount = d->jobCount;
+	if (jobCount <= 0) {
+		jobCount = QThread::idealThreadCount();
+		if (jobCount <= 0)
+			jobCount = 1;
+	}
+	if (jobCount > cardFilenames.size())
+		jobCount = cardFilenames.size();
+
+	// If only one card is processed at a time,
+	// use multiple threads to search it instead.
+	const int searchThreadCount = (jobCount > 1 ? 1 : 0);
+
+	// Output subdirectory for each card.
+	const QStringList cardDirNames = d->cardDirNames(cardFilenames);
+
+	QAtomicInt cardsFailed(0);
+	if (jobCount <= 1) {
+		// Single-threaded.
+		for (int i = 0; i < cardFilenames.size(); i++) {
+			BatchRecoverTask task(d, cardFilenames.at(i), cardDirNames.at(i),
+				searchThreadCount, &cardsFailed);
+			task.run();
+		}
+	} else {
+		// Process multiple cards concurrently.
+		QThreadPool pool;
+		pool.setMaxThreadCount(jobCount);
+		for (int i = 0; i < cardFilenames.size(); i++) {
+			pool.start(new BatchRecoverTask(d, cardFilenames.at(i), cardDirNames.at(i),
+				searchThreadCount, &cardsFailed));
+		}
+		pool.waitForDone();
+	}
+
+	return cardsFailed.load();
+}
@@ -0,0 +1,94 @@
+/***************************************************************************
+ * GameCube Memory Card Recovery Program.                                  *
+ * BatchRecover.hpp: Headless batch recovery.                              *
+ *                                                                         *
+ * Copyright (c) 2013-2018 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#ifndef __MCRECOVER_BATCHRECOVER_HPP__
+#define __MCRECOVER_BATCHRECOVER_HPP__
+
+// Qt includes.
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QVector>
+
+class BatchRecoverPrivate;
+class BatchRecover
+{
+	public:
+		BatchRecover();
+		~BatchRecover();
+
+	protected:
+		BatchRecoverPrivate *const d_ptr;
+		Q_DECLARE_PRIVATE(BatchRecover)
+	private:
+		Q_DISABLE_COPY(BatchRecover)
+
+	public:
+		/**
+		 * Batch mode entry point.
+		 * This is called by mcrecover_main() if "--batch" is specified.
+		 * No widgets are created in batch mode.
+		 * @param argc Number of arguments.
+		 * @param argv Array of arguments.
+		 * @return Return value.
+		 */
+		static int main(int argc, char *argv[]);
+
+		/** Properties. **/
+
+		/**
+		 * Set the output directory.
+		 * Files are exported to a subdirectory named after each card.
+		 * If multiple cards have the same name, a hash of the
+		 * card's path is appended. Existing files are not overwritten.
+		 * @param outputDir Output directory.
+		 */
+		void setOutputDir(const QString &outputDir);
+
+		/**
+		 * Set the preferred region.
+		 * @param preferredRegion Preferred region.
+		 */
+		void setPreferredRegion(char preferredRegion);
+
+		/**
+		 * Set the "search used blocks" flag.
+		 * @param searchUsedBlocks If true, search all blocks, not just empty blocks.
+		 */
+		void setSearchUsedBlocks(bool searchUsedBlocks);
+
+		/**
+		 * Set the number of cards to process concurrently.
+		 * @param jobCount Number of jobs. (0 for automatic)
+		 */
+		void setJobCount(int jobCount);
+
+		/**
+		 * Get the last error string.
+		 * @return Last error string.
+		 */
+		QString errorString(void) const;
+
+	public:
+		/**
+		 * Load multiple GCN Memory Card File databases.
+		 * @param dbFilenames Filenames of GCN Memory Card File database.
+		 * @return 0 on success; non-zero on error. (Check error string!)
+		 */
+		int loadGcnMcFileDbs(const QVector<QString> &dbFilenames);
+
+		/**
+		 * Recover lost files from multiple memory card images.
+		 * One line of tab-separated timing information is
+		 * written to stdout for each card.
+		 * @param cardFilenames Memory card image filenames.
+		 * @return Number of cards that failed; negative on error.
+		 */
+		int run(const QStringList &cardFilenames);
+};
+
+#endif /* __MCRECOVER_BATCHRECOVER_HPP__ */
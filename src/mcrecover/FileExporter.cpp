@@ -0,0 +1,377 @@
+/***************************************************************************
+ * GameCube Memory Card Recovery Program.                                  *
+ * FileExporter.cpp: Pipelined file exporter.                              *
+ *                                                                         *
+ * Copyright (c) 2013-2018 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "FileExporter.hpp"
+
+// Files.
+#include "libmemcard/File.hpp"
+#include "libmemcard/FileImages.hpp"
+
+// Qt includes.
+#include <QtCore/QBuffer>
+#include <QtCore/QFile>
+#include <QtCore/QPointer>
+#include <QtCore/QQueue>
+#include <QtCore/QRunnable>
+#include <QtCore/QThreadPool>
+
+/** FileExporterPrivate **/
+
+class FileExporterPrivate
+{
+	public:
+		explicit FileExporterPrivate(FileExporter *q);
+		~FileExporterPrivate();
+
+	protected:
+		FileExporter *const q_ptr;
+		Q_DECLARE_PUBLIC(FileExporter)
+	private:
+		Q_DISABLE_COPY(FileExporterPrivate)
+
+	public:
+		// Queued file.
+		struct QueuedFile {
+			QPointer<File> file;
+			QString filename;
+			QString bannerFilenameNoExt;
+			QString iconFilenameNoExt;
+			GcImageWriter::AnimImageFormat animImgf;
+			GcImageWriter::PngCompression pngCompression;
+		};
+
+		// Files that haven't been read yet.
+		QQueue<QueuedFile> queue;
+
+		// Worker threads for encoding and writing.
+		QThreadPool threadPool;
+
+		// Export status.
+		bool running;
+		bool readScheduled;
+		int total;		// Total files in this export.
+		int processed;		// Files processed so far.
+		int saved;		// Files saved successfully.
+		int inFlight;		// Tasks submitted to the thread pool.
+
+		// Number of files to read per event loop iteration.
+		// This keeps the UI responsive while reading.
+		static const int READ_BATCH = 4;
+
+		/**
+		 * Maximum number of tasks in flight per worker thread.
+		 * This limits memory usage for large exports.
+		 */
+		static const int MAX_IN_FLIGHT_PER_THREAD = 2;
+
+		/**
+		 * Schedule reading the next batch of queued files.
+		 */
+		void scheduleRead(void);
+
+		/**
+		 * A file has been processed.
+		 * @param success True if the file was saved successfully.
+		 */
+		void fileProcessed(bool success);
+};
+
+FileExporterPrivate::FileExporterPrivate(FileExporter *q)
+	: q_ptr(q)
+	, running(false)
+	, readScheduled(false)
+	, total(0)
+	, processed(0)
+	, saved(0)
+	, inFlight(0)
+{ }
+
+FileExporterPrivate::~FileExporterPrivate()
+{
+	// Wait for all tasks to finish.
+	// NOTE: Tasks don't reference the File or Card,
+	// so it's safe if they've already been deleted.
+	threadPool.waitForDone();
+}
+
+/**
+ * Schedule reading the next batch of queued files.
+ */
+void FileExporterPrivate::scheduleRead(void)
+{
+	if (readScheduled || queue.isEmpty())
+		return;
+	if (inFlight >= threadPool.maxThreadCount() * MAX_IN_FLIGHT_PER_THREAD)
+		return;
+
+	Q_Q(FileExporter);
+	readScheduled = true;
+	QMetaObject::invokeMethod(q, "readQueued_slot", Qt::QueuedConnection);
+}
+
+/**
+ * A file has been processed.
+ * @param success True if the file was saved successfully.
+ */
+void FileExporterPrivate::fileProcessed(bool success)
+{
+	Q_Q(FileExporter);
+	processed++;
+	if (success)
+		saved++;
+	emit q->exportProgress(processed, total);
+
+	if (processed >= total && queue.isEmpty()) {
+		// Export is finished.
+		const int filesSaved = saved;
+		running = false;
+		total = 0;
+		processed = 0;
+		saved = 0;
+		emit q->exportFinished(filesSaved);
+	}
+}
+
+/** ExportTask **/
+
+/**
+ * Decode and encode the images and write the output files for one File.
+ * This runs on a worker thread, and only uses data that
+ * was copied from the File on the main thread.
+ */
+class ExportTask : public QRunnable
+{
+	public:
+		ExportTask(FileExporter *exporter, const QByteArray &data,
+			   FileImages *images,
+			   const FileExporterPrivate::QueuedFile &qf)
+			: exporter(exporter)
+			, data(data)
+			, images(images)
+			, filename(qf.filename)
+			, bannerFilenameNoExt(qf.bannerFilenameNoExt)
+			, iconFilenameNoExt(qf.iconFilenameNoExt)
+			, animImgf(qf.animImgf)
+		{ }
+
+		virtual ~ExportTask()
+		{
+			delete images;
+		}
+
+		virtual void run(void) final;
+
+	private:
+		FileExporter *const exporter;
+		const QByteArray data;
+		FileImages *const images;
+		const QString filename;
+		const QString bannerFilenameNoExt;
+		const QString iconFilenameNoExt;
+		const GcImageWriter::AnimImageFormat animImgf;
+};
+
+void ExportTask::run(void)
+{
+	// Save the file.
+	bool success = false;
+	QFile file(filename);
+	if (file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		success = (file.write(data) == data.size());
+		file.close();
+		if (!success) {
+			// Error saving the file.
+			file.remove();
+		}
+	}
+
+	if (!success) {
+		// Don't save the images if the file wasn't saved.
+		QMetaObject::invokeMethod(exporter, "taskFinished_slot",
+			Qt::QueuedConnection, Q_ARG(bool, false));
+		return;
+	}
+
+	// Decode the images.
+	images->decode();
+
+	// Extract the banner.
+	// TODO: Error handling and details.
+	if (!bannerFilenameNoExt.isEmpty() && images->gcBanner) {
+		images->saveBanner(bannerFilenameNoExt);
+	}
+
+	// Extract the icon.
+	// TODO: Error handling and details.
+	if (!iconFilenameNoExt.isEmpty() && !images->gcIcons.isEmpty()) {
+		images->saveIcon(iconFilenameNoExt, animImgf);
+	}
+
+	// Notify the exporter on the main thread.
+	QMetaObject::invokeMethod(exporter, "taskFinished_slot",
+		Qt::QueuedConnection, Q_ARG(bool, success));
+}
+
+/** FileExporter **/
+
+FileExporter::FileExporter(QObject *parent)
+	: super(parent)
+	, d_ptr(new FileExporterPrivate(this))
+{ }
+
+FileExporter::~FileExporter()
+{
+	Q_D(FileExporter);
+	delete d;
+}
+
+/**
+ * Is an export currently running?
+ * @return True if running; false if not.
+ */
+bool FileExporter::isRunning(void) const
+{
+	Q_D(const FileExporter);
+	return d->running;
+}
+
+/**
+ * Add a file to the export queue.
+ *
+ * File data is read on the main thread, since Card
+ * isn't thread-safe. Images are decoded and encoded,
+ * and all output files are written by worker threads.
+ *
+ * If the File is deleted before it's read, e.g. if
+ * the card is closed, it's counted as a failure.
+ *
+ * @param file File to export.
+ * @param filename Filename for the exported file.
+ * @param bannerFilenameNoExt Filename for the banner, sans extension. (empty to skip)
+ * @param iconFilenameNoExt Filename for the icon, sans extension. (empty to skip)
+ * @param animImgf Animated image format for animated icons.
+ * @param pngCompression PNG compression level for banners and icons.
+ */
+void FileExporter::addFile(File *file, const QString &filename,
+	const QString &bannerFilenameNoExt,
+	const QString &iconFilenameNoExt,
+	GcImageWriter::AnimImageFormat animImgf,
+	GcImageWriter::PngCompression pngCompression)
+{
+	Q_D(FileExporter);
+	FileExporterPrivate::QueuedFile qf;
+	qf.file = file;
+	qf.filename = filename;
+	qf.bannerFilenameNoExt = bannerFilenameNoExt;
+	qf.iconFilenameNoExt = iconFilenameNoExt;
+	qf.animImgf = animImgf;
+	qf.pngCompression = pngCompression;
+	d->queue.enqueue(qf);
+	d->total++;
+}
+
+/**
+ * Start exporting the queued files.
+ * If an export is already running, the new files
+ * are added to the current export.
+ */
+void FileExporter::start(void)
+{
+	Q_D(FileExporter);
+	if (d->queue.isEmpty())
+		return;
+
+	if (!d->running) {
+		d->running = true;
+
+		// Load the image encoder libraries on the main thread.
+		// APNG and giflib are loaded with dlopen() on first use,
+		// which isn't thread-safe.
+		GcImageWriter::isAnimImageFormatSupported(d->queue.head().animImgf);
+		emit exportStarted();
+	}
+
+	emit exportProgress(d->processed, d->total);
+	d->scheduleRead();
+}
+
+/** Private slots. **/
+
+/**
+ * Read the next batch of queued files.
+ */
+void FileExporter::readQueued_slot(void)
+{
+	Q_D(FileExporter);
+	d->readScheduled = false;
+
+	const int maxInFlight = d->threadPool.maxThreadCount() *
+				FileExporterPrivate::MAX_IN_FLIGHT_PER_THREAD;
+	for (int i = FileExporterPrivate::READ_BATCH; i > 0; i--) {
+		if (d->queue.isEmpty() || d->inFlight >= maxInFlight)
+			break;
+
+		const FileExporterPrivate::QueuedFile qf = d->queue.dequeue();
+		File *const file = qf.file.data();
+		if (!file) {
+			// File was deleted.
+			d->fileProcessed(false);
+			continue;
+		}
+
+		// Read the file data.
+		// NOTE: The data is copied even if the card is mapped.
+		// Writing from the mapping on a worker thread isn't safe,
+		// since the card could be closed and unmapped, or written
+		// to, while the task is running.
+		QByteArray data;
+		QBuffer buffer(&data);
+		buffer.open(QIODevice::WriteOnly);
+		int ret = file->exportToFile(&buffer);
+		buffer.close();
+		if (ret != 0) {
+			// An error occurred while reading the file.
+			// TODO: Error details.
+			d->fileProcessed(false);
+			continue;
+		}
+
+		// Copy the images.
+		// If they haven't been decoded yet, only the raw image
+		// data is copied, and the worker thread decodes it.
+		const bool banner = !qf.bannerFilenameNoExt.isEmpty();
+		const bool icons = (!qf.iconFilenameNoExt.isEmpty() && file->iconCount() >= 1);
+		FileImages *const images = file->copyImages(banner, icons);
+		images->pngCompression = qf.pngCompression;
+
+		// If there are fewer tasks than worker threads,
+		// the idle threads can be used to encode animated icons.
+		// Otherwise, each task encodes on its own worker thread.
+		const int tasks = d->inFlight + 1 + d->queue.size();
+		const int maxThreads = d->threadPool.maxThreadCount();
+		images->threadCount = (tasks < maxThreads ? (maxThreads / tasks) : 1);
+
+		// Encode and write on a worker thread.
+		d->inFlight++;
+		d->threadPool.start(new ExportTask(this, data, images, qf));
+	}
+
+	d->scheduleRead();
+}
+
+/**
+ * An export task has finished.
+ * @param success True if the file was saved successfully.
+ */
+void FileExporter::taskFinished_slot(bool success)
+{
+	Q_D(FileExporter);
+	d->inFlight--;
+	d->fileProcessed(success);
+	d->scheduleRead();
+}
@@ -0,0 +1,109 @@
+/***************************************************************************
+ * GameCube Memory Card Recovery Program.                                  *
+ * FileExporter.hpp: Pipelined file exporter.                              *
+ *                                                                         *
+ * Copyright (c) 2013-2018 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#ifndef __MCRECOVER_FILEEXPORTER_HPP__
+#define __MCRECOVER_FILEEXPORTER_HPP__
+
+// GcImageWriter.
+#include "GcImageWriter.hpp"
+
+// Qt includes.
+#include <QtCore/QObject>
+#include <QtCore/QString>
+
+class File;
+
+class FileExporterPrivate;
+class FileExporter : public QObject
+{
+	Q_OBJECT
+	typedef QObject super;
+
+	Q_PROPERTY(bool running READ isRunning)
+
+	public:
+		explicit FileExporter(QObject *parent = 0);
+		virtual ~FileExporter();
+
+	protected:
+		FileExporterPrivate *const d_ptr;
+		Q_DECLARE_PRIVATE(FileExporter)
+	private:
+		Q_DISABLE_COPY(FileExporter)
+
+	public:
+		/**
+		 * Is an export currently running?
+		 * @return True if running; false if not.
+		 */
+		bool isRunning(void) const;
+
+		/**
+		 * Add a file to the export queue.
+		 *
+		 * File data is read on the main thread, since Card
+		 * isn't thread-safe. Images are decoded and encoded,
+		 * and all output files are written by worker threads.
+		 *
+		 * If the File is deleted before it's read, e.g. if
+		 * the card is closed, it's counted as a failure.
+		 *
+		 * @param file File to export.
+		 * @param filename Filename for the exported file.
+		 * @param bannerFilenameNoExt Filename for the banner, sans extension. (empty to skip)
+		 * @param iconFilenameNoExt Filename for the icon, sans extension. (empty to skip)
+		 * @param animImgf Animated image format for animated icons.
+		 * @param pngCompression PNG compression level for banners and icons.
+		 */
+		void addFile(File *file, const QString &filename,
+			     const QString &bannerFilenameNoExt,
+			     const QString &iconFilenameNoExt,
+			     GcImageWriter::AnimImageFormat animImgf,
+			     GcImageWriter::PngCompression pngCompression = GcImageWriter::PNGC_DEFAULT);
+
+		/**
+		 * Start exporting the queued files.
+		 * If an export is already running, the new files
+		 * are added to the current export.
+		 */
+		void start(void);
+
+	signals:
+		/**
+		 * Export has started.
+		 * This is only emitted if an export wasn't already running.
+		 */
+		void exportStarted(void);
+
+		/**
+		 * Export progress.
+		 * @param current Number of files processed so far.
+		 * @param total Total number of files in this export.
+		 */
+		void exportProgress(int current, int total);
+
+		/**
+		 * Export has finished.
+		 * @param filesSaved Number of files saved successfully.
+		 */
+		void exportFinished(int filesSaved);
+
+	private slots:
+		/**
+		 * Read the next batch of queued files.
+		 */
+		void readQueued_slot(void);
+
+		/**
+		 * An export task has finished.
+		 * @param success True if the file was saved successfully.
+		 */
+		void taskFinished_slot(bool success);
+};
+
+#endif /* __MCRECOVER_FILEEXPORTER_HPP__ */
@@ -14,6 +14,8 @@
 #include <QtCore/QSettings>
 #include <QtCore/QHash>
 #include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
 #include <QtCore/QString>
 #include <QtCore/QVariant>
 #include <QtCore/QPointer>
@@ -394,6 +396,37 @@ QString ConfigStore::ConfigPath(void)
 	return ConfigStorePrivate::ConfigPath;
 }
 
+/**
+ * Remove least-recently-used files from the cache directory.
+ * Files are ordered by mtime, so cache files should be
+ * rewritten or touched when they're used.
+ * The most recently used file is always kept.
+ * @param nameFilter Filename filter, e.g. "*.scancache".
+ * @param maxFiles Maximum number of matching files to keep.
+ * @param maxSize Maximum total size of matching files to keep, in bytes.
+ */
+void ConfigStore::PruneCache(const QString &nameFilter, int maxFiles, qint64 maxSize)
+{
+	const QDir cacheDir(QDir(ConfigPath()).absoluteFilePath(QLatin1String("cache")));
+
+	// Newest files first.
+	const QFileInfoList files = cacheDir.entryInfoList(
+		QStringList(nameFilter), QDir::Files, QDir::Time);
+
+	int count = 0;
+	qint64 totalSize = 0;
+	foreach (const QFileInfo &fileInfo, files) {
+		count++;
+		totalSize += fileInfo.size();
+		if (count > 1 && (count > maxFiles || totalSize > maxSize)) {
+			// Over the limit. Remove this file.
+			// NOTE: Errors are ignored; another instance
+			// may have already removed the file.
+			QFile::remove(fileInfo.absoluteFilePath());
+		}
+	}
+}
+
 /**
  * Load the configuration file.
  * @param filename Configuration filename.
@@ -70,6 +70,17 @@ class ConfigStore : public QObject
 		 */
 		static QString ConfigPath(void);
 
+		/**
+		 * Remove least-recently-used files from the cache directory.
+		 * Files are ordered by mtime, so cache files should be
+		 * rewritten or touched when they're used.
+		 * The most recently used file is always kept.
+		 * @param nameFilter Filename filter, e.g. "*.scancache".
+		 * @param maxFiles Maximum number of matching files to keep.
+		 * @param maxSize Maximum total size of matching files to keep, in bytes.
+		 */
+		static void PruneCache(const QString &nameFilter, int maxFiles, qint64 maxSize);
+
 		/**
 		 * Load the configuration file.
 		 * @param filename Configuration filename.
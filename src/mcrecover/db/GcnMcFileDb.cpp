@@ -31,10 +31,19 @@
 #include <cstdio>
 #include <cstring>
 
+// C++ includes.
+#include <algorithm>
+
 // Qt includes.
 #include <QtCore/QCoreApplication>
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDataStream>
+#include <QtCore/QDateTime>
 #include <QtCore/QDir>
 #include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QHash>
+#include <QtCore/QSaveFile>
 #include <QtCore/QMap>
 #include <QtCore/QTextCodec>
 #include <QtCore/QVector>
@@ -62,6 +71,91 @@ class GcnMcFileDbPrivate
 		 */
 		QMap<uint32_t, QVector<GcnMcFileDef*>*> addr_file_defs;
 
+		/**
+		 * Compiled matcher for a single search address.
+		 * Built once after the database is loaded so checkBlock()
+		 * only runs the regexes for plausible file definitions.
+		 */
+		struct AddrMatcher {
+			/**
+			 * File definitions indexed by the first character
+			 * of the gameDesc literal prefix.
+			 * - Key: First character of the prefix.
+			 * - Value: Indexes into the address's QVector<GcnMcFileDef*>.
+			 */
+			QHash<ushort, QVector<int> > byFirstChar;
+
+			// File definitions that don't have a gameDesc literal prefix.
+			QVector<int> noPrefix;
+
+			/**
+			 * Raw byte pre-screen.
+			 * Indexed by the first non-whitespace byte of the
+			 * raw game description. (0 if the comment is empty)
+			 * If false, no file definition can match, so the
+			 * comment doesn't need to be decoded.
+			 */
+			bool firstBytes[256];
+		};
+
+		/**
+		 * Compiled matchers.
+		 * - Key: Search address. (same as addr_file_defs)
+		 * - Value: AddrMatcher.
+		 */
+		QMap<uint32_t, AddrMatcher> addr_matchers;
+
+		/**
+		 * Get the literal prefix required by a regular expression.
+		 * Only anchored regexes ("^...") have a literal prefix.
+		 * The returned prefix may be shorter than the actual
+		 * required prefix, but it will never be longer.
+		 * @param pattern Regular expression.
+		 * @return Literal prefix, or empty string if none.
+		 */
+		static QString LiteralPrefix(const QString &pattern);
+
+		/**
+		 * Characters that can start a decoded comment.
+		 * - Index: First raw byte.
+		 * - Value: Possible first characters, before trimming.
+		 */
+		typedef QVector<ushort> FirstCharTable[256];
+		FirstCharTable firstCharsUS;
+		FirstCharTable firstCharsJP;
+		bool firstCharsInit;
+
+		/**
+		 * Initialize a FirstCharTable.
+		 * @param table		[out] FirstCharTable.
+		 * @param textCodec	[in] QTextCodec. (If nullptr, use latin1.)
+		 */
+		static void InitFirstCharTable(FirstCharTable &table, QTextCodec *textCodec);
+
+		/**
+		 * Build the compiled matchers from addr_file_defs.
+		 */
+		void buildMatchers(void);
+
+		/**
+		 * Pre-screen a raw game description.
+		 * @param matcher	[in] AddrMatcher.
+		 * @param buf		[in] Game description. (raw)
+		 * @param siz		[in] Size of buf. (usually 32)
+		 * @return True if any file definition might match; false if not.
+		 */
+		static inline bool Prescreen(const AddrMatcher &matcher, const char *buf, int siz);
+
+		/**
+		 * Get candidate file definitions for a game description.
+		 * @param matcher	[in] AddrMatcher.
+		 * @param gameDescUS	[in] Game description. (cp1252)
+		 * @param gameDescJP	[in] Game description. (Shift-JIS)
+		 * @return Sorted indexes of candidate file definitions.
+		 */
+		static QVector<int> candidates(const AddrMatcher &matcher,
+			const QString &gameDescUS, const QString &gameDescJP);
+
 		/**
 		 * Convert a region character to a GcnMcFileDef::regions_t bitfield value.
 		 * @param regionChr Region character.
@@ -82,6 +176,62 @@ class GcnMcFileDbPrivate
 		 */
 		int load(const QString &filename);
 
+		/**
+		 * Initialize the search regexes and literal prefixes
+		 * for a file definition.
+		 * @param gcnMcFileDef File definition.
+		 */
+		static void initSearch(GcnMcFileDef *gcnMcFileDef);
+
+		/**
+		 * Add a file definition to addr_file_defs.
+		 * @param gcnMcFileDef File definition.
+		 */
+		void addFileDef(GcnMcFileDef *gcnMcFileDef);
+
+		/** Database cache. **/
+
+		// Cache file magic and version.
+		// Increment CACHE_VERSION if GcnMcFileDef or the
+		// parser changes in a way that affects parsed data.
+		static const quint32 CACHE_MAGIC = 0x4D434442;	// "MCDB"
+		static const quint32 CACHE_VERSION = 1;
+
+		// Cache limits.
+		// Least-recently-used caches are removed
+		// when a cache is saved.
+		static const int CACHE_MAX_FILES = 16;
+		static const qint64 CACHE_MAX_SIZE = 32*1024*1024;
+
+		/**
+		 * Get the cache filename for a database file.
+		 * @param fileInfo Database file.
+		 * @return Cache filename.
+		 */
+		static QString CacheFilename(const QFileInfo &fileInfo);
+
+		/**
+		 * Load the database from the cache.
+		 * The cache is used if the database file's size and mtime
+		 * match, or if xmlHash is specified and matches.
+		 * @param cacheFilename	[in] Cache filename.
+		 * @param fileInfo	[in] Database file.
+		 * @param xmlHash	[in] SHA-1 of the database file, or empty to check size/mtime only.
+		 * @return 0 on success; 1 if the cache is stale; negative on error.
+		 */
+		int loadCache(const QString &cacheFilename,
+			const QFileInfo &fileInfo, const QByteArray &xmlHash);
+
+		/**
+		 * Save the database to the cache.
+		 * @param cacheFilename	[in] Cache filename.
+		 * @param fileInfo	[in] Database file.
+		 * @param xmlHash	[in] SHA-1 of the database file.
+		 * @return 0 on success; non-zero on error.
+		 */
+		int saveCache(const QString &cacheFilename,
+			const QFileInfo &fileInfo, const QByteArray &xmlHash) const;
+
 		void parseXml_GcnMcFileDb(QXmlStreamReader &xml);
 		GcnMcFileDef *parseXml_file(QXmlStreamReader &xml);
 		QString parseXml_element(QXmlStreamReader &xml);
@@ -97,6 +247,9 @@ class GcnMcFileDbPrivate
 		 */
 		QString errorString;
 
+		// SHA-1 of the loaded database file.
+		QByteArray xmlHash;
+
 		// Text codecs.
 		QTextCodec *const textCodecJP;
 		QTextCodec *const textCodecUS;
@@ -134,6 +287,7 @@ class GcnMcFileDbPrivate
 
 GcnMcFileDbPrivate::GcnMcFileDbPrivate(GcnMcFileDb *q)
 	: q_ptr(q)
+	, firstCharsInit(false)
 	, textCodecJP(QTextCodec::codecForName("Shift-JIS"))
 	, textCodecUS(QTextCodec::codecForName("Windows-1252"))
 { }
@@ -182,6 +336,232 @@ void GcnMcFileDbPrivate::clear(void)
 	}
 
 	addr_file_defs.clear();
+	addr_matchers.clear();
+}
+
+
+/**
+ * Get the literal prefix required by a regular expression.
+ * Only anchored regexes ("^...") have a literal prefix.
+ * The returned prefix may be shorter than the actual
+ * required prefix, but it will never be longer.
+ * @param pattern Regular expression.
+ * @return Literal prefix, or empty string if none.
+ */
+QString GcnMcFileDbPrivate::LiteralPrefix(const QString &pattern)
+{
+	if (!pattern.startsWith(QChar(L'^')))
+		return QString();
+
+	// A top-level alternation means the prefix
+	// only applies to the first alternative.
+	int depth = 0;
+	bool inClass = false;
+	const int len = pattern.size();
+	for (int i = 0; i < len; i++) {
+		const QChar chr = pattern.at(i);
+		if (chr == QChar(L'\\')) {
+			// Skip the escaped character.
+			i++;
+		} else if (inClass) {
+			if (chr == QChar(L']'))
+				inClass = false;
+		} else if (chr == QChar(L'[')) {
+			inClass = true;
+		} else if (chr == QChar(L'(')) {
+			depth++;
+		} else if (chr == QChar(L')')) {
+			depth--;
+		} else if (chr == QChar(L'|') && depth <= 0) {
+			return QString();
+		}
+	}
+
+	QString prefix;
+	prefix.reserve(len);
+	for (int i = 1; i < len; i++) {
+		const QChar chr = pattern.at(i);
+		switch (chr.unicode()) {
+			case '\\': {
+				// Escaped punctuation is a literal character.
+				// Anything else is a character class or assertion.
+				if (i + 1 >= len)
+					return prefix;
+				const QChar next = pattern.at(i + 1);
+				if (next.isLetterOrNumber() || next.unicode() >= 0x80)
+					return prefix;
+				prefix += next;
+				i++;
+				break;
+			}
+
+			case '?': case '*': case '{':
+				// Previous character is optional.
+				prefix.chop(1);
+				if (!prefix.isEmpty() && prefix.at(prefix.size()-1).isHighSurrogate())
+					prefix.chop(1);
+				return prefix;
+
+			case '+': case '.': case '^': case '$':
+			case '(': case ')': case '[': case ']':
+			case '|':
+				// End of the literal prefix.
+				return prefix;
+
+			default:
+				prefix += chr;
+				break;
+		}
+	}
+
+	return prefix;
+}
+
+
+/**
+ * Initialize a FirstCharTable.
+ * @param table		[out] FirstCharTable.
+ * @param textCodec	[in] QTextCodec. (If nullptr, use latin1.)
+ */
+void GcnMcFileDbPrivate::InitFirstCharTable(FirstCharTable &table, QTextCodec *textCodec)
+{
+	char buf[2];
+	for (int b = 0; b < 256; b++) {
+		QVector<ushort> &chars = table[b];
+		chars.clear();
+		buf[0] = (char)b;
+
+		// Check if this is a single-byte character.
+		buf[1] = 'A';
+		QString str = (textCodec
+			? textCodec->toUnicode(buf, 2)
+			: QString::fromLatin1(buf, 2));
+		if (str.size() == 2 && str.at(1) == QChar(L'A')) {
+			chars.append(str.at(0).unicode());
+			continue;
+		}
+
+		// Lead byte. Check the byte by itself, since the
+		// comment may end here, and all possible trail bytes.
+		str = (textCodec
+			? textCodec->toUnicode(buf, 1)
+			: QString::fromLatin1(buf, 1));
+		if (!str.isEmpty()) {
+			chars.append(str.at(0).unicode());
+		}
+		for (int t = 0; t < 256; t++) {
+			buf[1] = (char)t;
+			str = (textCodec
+				? textCodec->toUnicode(buf, 2)
+				: QString::fromLatin1(buf, 2));
+			if (!str.isEmpty()) {
+				chars.append(str.at(0).unicode());
+			}
+		}
+		std::sort(chars.begin(), chars.end());
+		chars.erase(std::unique(chars.begin(), chars.end()), chars.end());
+	}
+}
+
+
+/**
+ * Build the compiled matchers from addr_file_defs.
+ */
+void GcnMcFileDbPrivate::buildMatchers(void)
+{
+	addr_matchers.clear();
+	if (addr_file_defs.isEmpty())
+		return;
+
+	if (!firstCharsInit) {
+		// Codecs don't change, so this only has to be done once.
+		InitFirstCharTable(firstCharsUS, textCodecUS);
+		InitFirstCharTable(firstCharsJP, textCodecJP);
+		firstCharsInit = true;
+	}
+
+	for (auto iter = addr_file_defs.cbegin(); iter != addr_file_defs.cend(); ++iter) {
+		const QVector<GcnMcFileDef*> *const vec = iter.value();
+		AddrMatcher &matcher = addr_matchers[iter.key()];
+		for (int i = 0; i < vec->size(); i++) {
+			const QString &prefix = vec->at(i)->search.gameDesc_prefix;
+			if (prefix.isEmpty()) {
+				matcher.noPrefix.append(i);
+			} else {
+				matcher.byFirstChar[prefix.at(0).unicode()].append(i);
+			}
+		}
+
+		// Raw byte pre-screen.
+		// A byte passes if it can decode to the first character
+		// of a literal prefix in either codec. Bytes that can
+		// decode to whitespace always pass, since the comment
+		// is trimmed after decoding.
+		const bool anyPrefix = !matcher.noPrefix.isEmpty();
+		for (int b = 0; b < 256; b++) {
+			bool ok = anyPrefix;
+			for (int c = 0; c < 2 && !ok; c++) {
+				const QVector<ushort> &chars = (c == 0 ? firstCharsUS[b] : firstCharsJP[b]);
+				foreach (ushort chr, chars) {
+					if (QChar(chr).isSpace() || matcher.byFirstChar.contains(chr)) {
+						ok = true;
+						break;
+					}
+				}
+			}
+			matcher.firstBytes[b] = ok;
+		}
+
+		// An empty comment only matches definitions without a prefix.
+		matcher.firstBytes[0] = anyPrefix;
+	}
+}
+
+
+/**
+ * Pre-screen a raw game description.
+ * @param matcher	[in] AddrMatcher.
+ * @param buf		[in] Game description. (raw)
+ * @param siz		[in] Size of buf. (usually 32)
+ * @return True if any file definition might match; false if not.
+ */
+inline bool GcnMcFileDbPrivate::Prescreen(const AddrMatcher &matcher, const char *buf, int siz)
+{
+	// Skip leading ASCII whitespace. This is the same
+	// in both codecs, and is removed by trimmed().
+	int i = 0;
+	for (; i < siz; i++) {
+		const uint8_t chr = (uint8_t)buf[i];
+		if (chr != ' ' && (chr < '\t' || chr > '\r'))
+			break;
+	}
+	return matcher.firstBytes[i < siz ? (uint8_t)buf[i] : 0];
+}
+
+
+/**
+ * Get candidate file definitions for a game description.
+ * @param matcher	[in] AddrMatcher.
+ * @param gameDescUS	[in] Game description. (cp1252)
+ * @param gameDescJP	[in] Game description. (Shift-JIS)
+ * @return Sorted indexes of candidate file definitions.
+ */
+QVector<int> GcnMcFileDbPrivate::candidates(const AddrMatcher &matcher,
+	const QString &gameDescUS, const QString &gameDescJP)
+{
+	QVector<int> ret = matcher.noPrefix;
+	if (!gameDescUS.isEmpty()) {
+		ret += matcher.byFirstChar.value(gameDescUS.at(0).unicode());
+	}
+	if (!gameDescJP.isEmpty() && (gameDescUS.isEmpty() || gameDescJP.at(0) != gameDescUS.at(0))) {
+		ret += matcher.byFirstChar.value(gameDescJP.at(0).unicode());
+	}
+
+	// Keep the database order so matches are returned
+	// in the same order as a linear scan.
+	std::sort(ret.begin(), ret.end());
+	ret.erase(std::unique(ret.begin(), ret.end()), ret.end());
+	return ret;
 }
 
 
@@ -194,16 +574,56 @@ int GcnMcFileDbPrivate::load(const QString &filename)
 {
 	// Clear the loaded database.
 	clear();
+	xmlHash.clear();
+
+	// Check the cache first. If the database file
+	// hasn't been modified, the XML doesn't need
+	// to be read at all.
+	const QFileInfo fileInfo(filename);
+	const QString cacheFilename = CacheFilename(fileInfo);
+	int ret = loadCache(cacheFilename, fileInfo, QByteArray());
+	if (ret == 0) {
+		// Database loaded from the cache.
+#if QT_VERSION >= QT_VERSION_CHECK(5,10,0)
+		// Touch the cache file so it's treated as recently used.
+		QFile cacheFile(cacheFilename);
+		if (cacheFile.open(QIODevice::ReadWrite)) {
+			cacheFile.setFileTime(QDateTime::currentDateTime(),
+				QFileDevice::FileModificationTime);
+		}
+#endif /* QT_VERSION >= QT_VERSION_CHECK(5,10,0) */
+		errorString = QString();
+		return 0;
+	}
 
 	// Attempt to open the specified database file.
 	QFile file(filename);
-	if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+	if (!file.open(QIODevice::ReadOnly)) {
 		// Error opening the file.
 		errorString = file.errorString();
 		return -1;
 	}
 
-	QXmlStreamReader xml(&file);
+	// Read the entire file so it can be hashed and parsed
+	// without reading it twice.
+	const QByteArray xmlData = file.readAll();
+	file.close();
+	const QByteArray xmlHash = QCryptographicHash::hash(xmlData, QCryptographicHash::Sha1);
+	this->xmlHash = xmlHash;
+
+	if (ret == 1) {
+		// The mtime changed, but the contents might not have.
+		// (e.g. the file was copied or touched)
+		if (loadCache(cacheFilename, fileInfo, xmlHash) == 0) {
+			// Contents are unchanged.
+			// Update the cache so the mtime matches next time.
+			saveCache(cacheFilename, fileInfo, xmlHash);
+			errorString = QString();
+			return 0;
+		}
+	}
+
+	QXmlStreamReader xml(xmlData);
 	while (!xml.atEnd() && !xml.hasError()) {
 		// Read the next element.
 		QXmlStreamReader::TokenType token = xml.readNext();
@@ -224,6 +644,9 @@ int GcnMcFileDbPrivate::load(const QString &filename)
 		}
 	}
 
+	// Build the compiled matchers.
+	buildMatchers();
+
 	if (xml.hasError()) {
 		// XML parse error occurred.
 		errorString = xml.errorString() + QChar(L' ') +
@@ -234,11 +657,301 @@ int GcnMcFileDbPrivate::load(const QString &filename)
 	}
 
 	// Database parsed successfully.
+	// Save it to the cache for next time.
+	saveCache(cacheFilename, fileInfo, xmlHash);
 	errorString = QString();
 	return 0;
 }
 
 
+/**
+ * Initialize the search regexes and literal prefixes
+ * for a file definition. The regexes are compiled lazily.
+ * @param gcnMcFileDef File definition.
+ */
+void GcnMcFileDbPrivate::initSearch(GcnMcFileDef *gcnMcFileDef)
+{
+	// Literal prefixes for the compiled matcher.
+	gcnMcFileDef->search.gameDesc_prefix = LiteralPrefix(gcnMcFileDef->search.gameDesc);
+	gcnMcFileDef->search.fileDesc_prefix = LiteralPrefix(gcnMcFileDef->search.fileDesc);
+
+	// Set the regular expressions.
+	// These aren't compiled until a comment passes
+	// the literal prefix check.
+	gcnMcFileDef->search.gameDesc_regex.setPattern(gcnMcFileDef->search.gameDesc);
+	gcnMcFileDef->search.fileDesc_regex.setPattern(gcnMcFileDef->search.fileDesc);
+}
+
+
+/**
+ * Add a file definition to addr_file_defs.
+ * @param gcnMcFileDef File definition.
+ */
+void GcnMcFileDbPrivate::addFileDef(GcnMcFileDef *gcnMcFileDef)
+{
+	uint32_t address = gcnMcFileDef->search.address;
+	address &= BLOCK_SIZE_MASK;	// search the specific block only
+	QVector<GcnMcFileDef*>* vec = addr_file_defs.value(address);
+	if (!vec) {
+		// Create a new QVector.
+		vec = new QVector<GcnMcFileDef*>();
+		addr_file_defs.insert(address, vec);
+	}
+	vec->append(gcnMcFileDef);
+}
+
+
+/**
+ * Get the cache filename for a database file.
+ * @param fileInfo Database file.
+ * @return Cache filename.
+ */
+QString GcnMcFileDbPrivate::CacheFilename(const QFileInfo &fileInfo)
+{
+	// Databases with the same name can exist in multiple
+	// directories, so include a hash of the full path.
+	const QByteArray pathHash = QCryptographicHash::hash(
+		fileInfo.absoluteFilePath().toUtf8(), QCryptographicHash::Sha1);
+
+	QDir configDir(ConfigStore::ConfigPath());
+	return configDir.absoluteFilePath(QLatin1String("cache/") +
+		fileInfo.completeBaseName() + QChar(L'.') +
+		QString::fromLatin1(pathHash.toHex().left(8)) +
+		QLatin1String(".dbcache"));
+}
+
+
+/**
+ * Load the database from the cache.
+ * The cache is used if the database file's size and mtime
+ * match, or if xmlHash is specified and matches.
+ * @param cacheFilename	[in] Cache filename.
+ * @param fileInfo	[in] Database file.
+ * @param xmlHash	[in] SHA-1 of the database file, or empty to check size/mtime only.
+ * @return 0 on success; 1 if the cache is stale; negative on error.
+ */
+int GcnMcFileDbPrivate::loadCache(const QString &cacheFilename,
+	const QFileInfo &fileInfo, const QByteArray &xmlHash)
+{
+	QFile file(cacheFilename);
+	if (!file.open(QIODevice::ReadOnly)) {
+		// No cache.
+		return -1;
+	}
+
+	QDataStream ds(&file);
+	ds.setVersion(QDataStream::Qt_5_0);
+
+	// Header.
+	quint32 magic, version;
+	qint64 xmlSize, xmlMTime;
+	QByteArray cacheHash;
+	ds >> magic >> version;
+	if (magic != CACHE_MAGIC || version != CACHE_VERSION) {
+		// Wrong format.
+		return -2;
+	}
+	ds >> xmlSize >> xmlMTime >> cacheHash;
+	if (ds.status() != QDataStream::Ok) {
+		// Truncated header.
+		return -2;
+	}
+
+	if (xmlHash.isEmpty()) {
+		// Only check the size and mtime.
+		if (xmlSize != fileInfo.size() ||
+		    xmlMTime != fileInfo.lastModified().toMSecsSinceEpoch())
+		{
+			return 1;
+		}
+	} else if (xmlHash != cacheHash) {
+		// Contents have changed.
+		return 1;
+	}
+
+	// File definitions.
+	quint32 count;
+	ds >> count;
+	for (; count > 0 && ds.status() == QDataStream::Ok; count--) {
+		GcnMcFileDef *gcnMcFileDef = new GcnMcFileDef();
+
+		ds >> gcnMcFileDef->gameName >> gcnMcFileDef->fileInfo;
+		ds.readRawData(gcnMcFileDef->id6, sizeof(gcnMcFileDef->id6));
+		ds >> gcnMcFileDef->regions;
+
+		// Search.
+		ds >> gcnMcFileDef->search.address
+		   >> gcnMcFileDef->search.gameDesc
+		   >> gcnMcFileDef->search.fileDesc;
+
+		// Checksum definitions.
+		quint32 chkCount;
+		ds >> chkCount;
+		for (; chkCount > 0 && ds.status() == QDataStream::Ok; chkCount--) {
+			Checksum::ChecksumDef checksumDef;
+			quint8 algorithm, endian;
+			ds >> algorithm >> checksumDef.address >> checksumDef.param
+			   >> checksumDef.start >> checksumDef.length >> endian;
+			checksumDef.algorithm = (Checksum::ChkAlgorithm)algorithm;
+			checksumDef.endian = (Checksum::ChkEndian)endian;
+			gcnMcFileDef->checksumDefs.append(checksumDef);
+		}
+
+		// Directory entry.
+		ds >> gcnMcFileDef->dirEntry.filename
+		   >> gcnMcFileDef->dirEntry.bannerFormat
+		   >> gcnMcFileDef->dirEntry.iconAddress
+		   >> gcnMcFileDef->dirEntry.iconFormat
+		   >> gcnMcFileDef->dirEntry.iconSpeed
+		   >> gcnMcFileDef->dirEntry.permission
+		   >> gcnMcFileDef->dirEntry.length;
+
+		// Variable modifiers.
+		quint32 varCount;
+		ds >> varCount;
+		for (; varCount > 0 && ds.status() == QDataStream::Ok; varCount--) {
+			QString id;
+			VarModifierDef varModifierDef;
+			qint8 fillChar;
+			qint32 addValue;
+			ds >> id >> varModifierDef.useAs >> varModifierDef.varType
+			   >> varModifierDef.minWidth >> fillChar
+			   >> varModifierDef.fieldAlign >> addValue;
+			varModifierDef.fillChar = (char)fillChar;
+			varModifierDef.addValue = addValue;
+			gcnMcFileDef->varModifiers.insert(id, varModifierDef);
+		}
+
+		if (ds.status() != QDataStream::Ok ||
+		    gcnMcFileDef->search.address > BLOCK_SIZE_MASK)
+		{
+			// Corrupted cache.
+			delete gcnMcFileDef;
+			break;
+		}
+
+		initSearch(gcnMcFileDef);
+		addFileDef(gcnMcFileDef);
+	}
+
+	if (ds.status() != QDataStream::Ok || count != 0) {
+		// Corrupted cache. Discard what was loaded.
+		clear();
+		return -3;
+	}
+
+	// Build the compiled matchers.
+	buildMatchers();
+	this->xmlHash = cacheHash;
+	return 0;
+}
+
+
+/**
+ * Save the database to the cache.
+ * @param cacheFilename	[in] Cache filename.
+ * @param fileInfo	[in] Database file.
+ * @param xmlHash	[in] SHA-1 of the database file.
+ * @return 0 on success; non-zero on error.
+ */
+int GcnMcFileDbPrivate::saveCache(const QString &cacheFilename,
+	const QFileInfo &fileInfo, const QByteArray &xmlHash) const
+{
+	// Make sure the cache directory exists.
+	QFileInfo cacheFileInfo(cacheFilename);
+	if (!cacheFileInfo.dir().mkpath(QLatin1String("."))) {
+		// Unable to create the cache directory.
+		return -1;
+	}
+
+	// Write to a temporary file so a partially-written
+	// cache is never seen by another instance.
+	QSaveFile file(cacheFilename);
+	if (!file.open(QIODevice::WriteOnly)) {
+		// Unable to create the cache file.
+		return -1;
+	}
+
+	QDataStream ds(&file);
+	ds.setVersion(QDataStream::Qt_5_0);
+
+	// Header.
+	ds << CACHE_MAGIC << CACHE_VERSION;
+	ds << (qint64)fileInfo.size()
+	   << (qint64)fileInfo.lastModified().toMSecsSinceEpoch()
+	   << xmlHash;
+
+	// File definitions.
+	quint32 count = 0;
+	for (QMap<uint32_t, QVector<GcnMcFileDef*>*>::const_iterator iter = addr_file_defs.constBegin();
+	     iter != addr_file_defs.constEnd(); ++iter)
+	{
+		count += (*iter)->size();
+	}
+	ds << count;
+
+	for (QMap<uint32_t, QVector<GcnMcFileDef*>*>::const_iterator iter = addr_file_defs.constBegin();
+	     iter != addr_file_defs.constEnd(); ++iter)
+	{
+		const QVector<GcnMcFileDef*> *vec = *iter;
+		for (int i = 0; i < vec->size(); i++) {
+			const GcnMcFileDef *gcnMcFileDef = vec->at(i);
+
+			ds << gcnMcFileDef->gameName << gcnMcFileDef->fileInfo;
+			ds.writeRawData(gcnMcFileDef->id6, sizeof(gcnMcFileDef->id6));
+			ds << gcnMcFileDef->regions;
+
+			// Search.
+			ds << gcnMcFileDef->search.address
+			   << gcnMcFileDef->search.gameDesc
+			   << gcnMcFileDef->search.fileDesc;
+
+			// Checksum definitions.
+			ds << (quint32)gcnMcFileDef->checksumDefs.size();
+			foreach (const Checksum::ChecksumDef &checksumDef, gcnMcFileDef->checksumDefs) {
+				ds << (quint8)checksumDef.algorithm << checksumDef.address
+				   << checksumDef.param << checksumDef.start
+				   << checksumDef.length << (quint8)checksumDef.endian;
+			}
+
+			// Directory entry.
+			ds << gcnMcFileDef->dirEntry.filename
+			   << gcnMcFileDef->dirEntry.bannerFormat
+			   << gcnMcFileDef->dirEntry.iconAddress
+			   << gcnMcFileDef->dirEntry.iconFormat
+			   << gcnMcFileDef->dirEntry.iconSpeed
+			   << gcnMcFileDef->dirEntry.permission
+			   << gcnMcFileDef->dirEntry.length;
+
+			// Variable modifiers.
+			ds << (quint32)gcnMcFileDef->varModifiers.size();
+			for (QHash<QString, VarModifierDef>::const_iterator varIter = gcnMcFileDef->varModifiers.constBegin();
+			     varIter != gcnMcFileDef->varModifiers.constEnd(); ++varIter)
+			{
+				const VarModifierDef &varModifierDef = *varIter;
+				ds << varIter.key() << varModifierDef.useAs << varModifierDef.varType
+				   << varModifierDef.minWidth << (qint8)varModifierDef.fillChar
+				   << varModifierDef.fieldAlign << (qint32)varModifierDef.addValue;
+			}
+		}
+	}
+
+	if (ds.status() != QDataStream::Ok) {
+		// Write error.
+		file.cancelWriting();
+		return -2;
+	}
+
+	if (!file.commit())
+		return -2;
+
+	// Remove old caches.
+	ConfigStore::PruneCache(QLatin1String("*.dbcache"),
+		CACHE_MAX_FILES, CACHE_MAX_SIZE);
+	return 0;
+}
+
+
 void GcnMcFileDbPrivate::parseXml_GcnMcFileDb(QXmlStreamReader &xml)
 {
 	const QLatin1String myTokenType("GcnMcFileDb");
@@ -264,15 +977,7 @@ void GcnMcFileDbPrivate::parseXml_GcnMcFileDb(QXmlStreamReader &xml)
 				delete gcnMcFileDef;
 			} else if (gcnMcFileDef) {
 				// Add the file to the database.
-				uint32_t address = gcnMcFileDef->search.address;
-				address &= BLOCK_SIZE_MASK;	// search the specific block only
-				QVector<GcnMcFileDef*>* vec = addr_file_defs.value(address);
-				if (!vec) {
-					// Create a new QVector.
-					vec = new QVector<GcnMcFileDef*>();
-					addr_file_defs.insert(address, vec);
-				}
-				vec->append(gcnMcFileDef);
+				addFileDef(gcnMcFileDef);
 			}
 		} else {
 			// Skip unreocgnized tokens.
@@ -441,17 +1146,8 @@ void GcnMcFileDbPrivate::parseXml_file_search(QXmlStreamReader &xml, GcnMcFileDe
 		xml.readNext();
 	}
 
-	// Set the regular expressions.
-	gcnMcFileDef->search.gameDesc_regex.setPattern(gcnMcFileDef->search.gameDesc);
-	gcnMcFileDef->search.fileDesc_regex.setPattern(gcnMcFileDef->search.fileDesc);
-#if QT_VERSION >= QT_VERSION_CHECK(5,4,0)
-	// TODO: If compiling with older Qt, set QRegularExpression::OptimizeOnFirstUsageOption.
-	// This will allow optimization if used with newer Qt without recompiling.
-	// QRegularExpression::PatternOption enum value 0x0080
-	// QRegularExpression::setPatternOptions()
-	gcnMcFileDef->search.gameDesc_regex.optimize();
-	gcnMcFileDef->search.fileDesc_regex.optimize();
-#endif /* QT_VERSION >= QT_VERSION_CHECK(5,4,0) */
+	// Initialize the regexes.
+	initSearch(gcnMcFileDef);
 }
 
 
@@ -938,6 +1634,27 @@ QString GcnMcFileDb::errorString(void) const
 }
 
 
+/**
+ * Get the database key.
+ * This changes if the database file or the
+ * parsed database format changes, so it can
+ * be used to invalidate cached search results.
+ * @return Database key, or empty QByteArray if no database is loaded.
+ */
+QByteArray GcnMcFileDb::cacheKey(void) const
+{
+	Q_D(const GcnMcFileDb);
+	if (d->xmlHash.isEmpty())
+		return QByteArray();
+
+	QCryptographicHash hash(QCryptographicHash::Sha1);
+	const quint32 version = GcnMcFileDbPrivate::CACHE_VERSION;
+	hash.addData(reinterpret_cast<const char*>(&version), sizeof(version));
+	hash.addData(d->xmlHash);
+	return hash.result();
+}
+
+
 /**
  * Check a GCN memory card block to see if it matches any search patterns.
  * @param buf	[in] GCN memory card block to check.
@@ -950,28 +1667,49 @@ QVector<GcnSearchData> GcnMcFileDb::checkBlock(const void *buf, int siz) const
 	QVector<GcnSearchData> fileMatches;
 
 	Q_D(const GcnMcFileDb);
-	foreach (uint32_t address, d->addr_file_defs.keys()) {
+	for (auto iter = d->addr_file_defs.cbegin(); iter != d->addr_file_defs.cend(); ++iter) {
 		// Make sure this address is within the bounds of the buffer.
 		// Game Description + File Description == 64 bytes. (0x40)
+		const uint32_t address = iter.key();
 		const int maxAddress = (int)(address + 0x40);
 		if (maxAddress < 0 || maxAddress > siz)
 			continue;
 
-		// Get the game description and file description.
+		// Check the raw game description before decoding it.
 		const char *const commentData = ((const char*)buf + address);
+		const GcnMcFileDbPrivate::AddrMatcher &matcher = *d->addr_matchers.constFind(address);
+		if (!d->Prescreen(matcher, commentData, 32))
+			continue;
+
+		// Get the game description.
 		const QString gameDescUS = d->GetGcnCommentUtf16(commentData, 32, d->textCodecUS);
 		const QString gameDescJP = d->GetGcnCommentUtf16(commentData, 32, d->textCodecJP);
-		const QString fileDescUS = d->GetGcnCommentUtf16(commentData+32, 32, d->textCodecUS);
-		const QString fileDescJP = d->GetGcnCommentUtf16(commentData+32, 32, d->textCodecJP);
 
-		QVector<GcnMcFileDef*> *vec = d->addr_file_defs.value(address);
-		foreach (const GcnMcFileDef *gcnMcFileDef, *vec) {
+		// Only check file definitions whose literal prefix
+		// can match the game description.
+		const QVector<int> candidates = d->candidates(matcher, gameDescUS, gameDescJP);
+		if (candidates.isEmpty())
+			continue;
+
+		// File description is only decoded if needed.
+		QString fileDescUS, fileDescJP;
+		bool hasFileDesc = false;
+
+		const QVector<GcnMcFileDef*> *const vec = iter.value();
+		foreach (int idx, candidates) {
+			const GcnMcFileDef *const gcnMcFileDef = vec->at(idx);
+
 			// Check if the Game Description (US) matches.
-			QRegularExpressionMatch gameDescMatch =
-				gcnMcFileDef->search.gameDesc_regex.match(gameDescUS);
+			const QString &gameDescPrefix = gcnMcFileDef->search.gameDesc_prefix;
+			QRegularExpressionMatch gameDescMatch;
+			if (gameDescUS.startsWith(gameDescPrefix)) {
+				gameDescMatch = gcnMcFileDef->search.gameDesc_regex.match(gameDescUS);
+			}
 			if (!gameDescMatch.hasMatch()) {
 				// No match for US.
 				// Check if the Game Description (JP) matches.
+				if (!gameDescJP.startsWith(gameDescPrefix))
+					continue;
 				gameDescMatch = gcnMcFileDef->search.gameDesc_regex.match(gameDescJP);
 				if (!gameDescMatch.hasMatch()) {
 					// No match for JP.
@@ -979,12 +1717,24 @@ QVector<GcnSearchData> GcnMcFileDb::checkBlock(const void *buf, int siz) const
 				}
 			}
 
+			if (!hasFileDesc) {
+				// Get the file description.
+				fileDescUS = d->GetGcnCommentUtf16(commentData+32, 32, d->textCodecUS);
+				fileDescJP = d->GetGcnCommentUtf16(commentData+32, 32, d->textCodecJP);
+				hasFileDesc = true;
+			}
+
 			// Check if the File Description (US) matches.
-			QRegularExpressionMatch fileDescMatch =
-				gcnMcFileDef->search.fileDesc_regex.match(fileDescUS);
+			const QString &fileDescPrefix = gcnMcFileDef->search.fileDesc_prefix;
+			QRegularExpressionMatch fileDescMatch;
+			if (fileDescUS.startsWith(fileDescPrefix)) {
+				fileDescMatch = gcnMcFileDef->search.fileDesc_regex.match(fileDescUS);
+			}
 			if (!fileDescMatch.hasMatch()) {
 				// No match for US.
 				// Check if the Game Description (JP) matches.
+				if (!fileDescJP.startsWith(fileDescPrefix))
+					continue;
 				fileDescMatch = gcnMcFileDef->search.fileDesc_regex.match(fileDescJP);
 				if (!fileDescMatch.hasMatch()) {
 					// No match for JP.
@@ -1136,6 +1886,15 @@ bool GcnMcFileDb::addChecksumDefs(GcnFile *file) const
 				continue;
 			}
 
+			// Check the literal prefixes first so the
+			// regexes don't get compiled unnecessarily.
+			if (!gameDesc.startsWith(gcnMcFileDef->search.gameDesc_prefix) ||
+			    !fileDesc.startsWith(gcnMcFileDef->search.fileDesc_prefix))
+			{
+				// Not a match.
+				continue;
+			}
+
 			// Make sure the GameDesc matches.
 			QRegularExpressionMatch gameDescMatch =
 				gcnMcFileDef->search.gameDesc_regex.match(gameDesc);
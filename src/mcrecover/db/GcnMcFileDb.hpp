@@ -19,6 +19,7 @@
 #include "GcnSearchData.hpp"
 
 // Qt includes.
+#include <QtCore/QByteArray>
 #include <QtCore/QObject>
 #include <QtCore/QString>
 #include <QtCore/QVector>
@@ -56,6 +57,15 @@ class GcnMcFileDb : public QObject
 		 */
 		QString errorString(void) const;
 
+		/**
+		 * Get the database key.
+		 * This changes if the database file or the
+		 * parsed database format changes, so it can
+		 * be used to invalidate cached search results.
+		 * @return Database key, or empty QByteArray if no database is loaded.
+		 */
+		QByteArray cacheKey(void) const;
+
 		/**
 		 * Check a GCN memory card block to see if it matches any search patterns.
 		 * @param buf	[in] GCN memory card block to check.
@@ -16,11 +16,105 @@
 // Qt includes.
 #include <QtCore/QString>
 #include <QtCore/QHash>
+#include <QtCore/QAtomicPointer>
 #include <QtCore/QRegularExpression>
 
 #include "Checksum.hpp"
 #include "VarModifierDef.hpp"
 
+/**
+ * Regular expression that isn't compiled until it's used.
+ * Most file definitions never match anything on a given card,
+ * so compiling every regex when the database is loaded wastes
+ * time and memory.
+ *
+ * match() is thread-safe: if two threads compile the regex
+ * at the same time, one of the compiled regexes is discarded.
+ */
+class LazyRegex {
+	public:
+		LazyRegex()
+			: m_regex(nullptr) { }
+		~LazyRegex()
+		{
+			delete m_regex.loadAcquire();
+		}
+
+	private:
+		Q_DISABLE_COPY(LazyRegex);
+
+	public:
+		/**
+		 * Set the pattern.
+		 * This must not be called while match() is in use.
+		 * @param pattern Regular expression.
+		 */
+		void setPattern(const QString &pattern)
+		{
+			delete m_regex.fetchAndStoreOrdered(nullptr);
+			m_pattern = pattern;
+		}
+
+		/**
+		 * Get the pattern.
+		 * @return Regular expression.
+		 */
+		const QString &pattern(void) const
+		{
+			return m_pattern;
+		}
+
+		/**
+		 * Has the regex been compiled yet?
+		 * @return True if compiled; false if not.
+		 */
+		bool isCompiled(void) const
+		{
+			return (m_regex.loadAcquire() != nullptr);
+		}
+
+		/**
+		 * Match the regex against a string.
+		 * The regex is compiled on first use.
+		 * @param subject String to match.
+		 * @return QRegularExpressionMatch.
+		 */
+		QRegularExpressionMatch match(const QString &subject) const
+		{
+			return regex()->match(subject);
+		}
+
+	private:
+		/**
+		 * Get the compiled regex, compiling it if necessary.
+		 * @return Compiled regex.
+		 */
+		const QRegularExpression *regex(void) const
+		{
+			QRegularExpression *regex = m_regex.loadAcquire();
+			if (regex)
+				return regex;
+
+			regex = new QRegularExpression(m_pattern);
+#if QT_VERSION >= QT_VERSION_CHECK(5,4,0)
+			regex->optimize();
+#else /* QT_VERSION < QT_VERSION_CHECK(5,4,0) */
+			// optimize() isn't available before Qt 5.4.
+			// The regex will be compiled when it's first matched.
+#endif /* QT_VERSION >= QT_VERSION_CHECK(5,4,0) */
+
+			if (!m_regex.testAndSetOrdered(nullptr, regex)) {
+				// Another thread compiled the regex first.
+				delete regex;
+				regex = m_regex.loadAcquire();
+			}
+			return regex;
+		}
+
+		QString m_pattern;
+		mutable QAtomicPointer<QRegularExpression> m_regex;
+};
+
 class GcnMcFileDef {
 	public:
 		enum regions_t {
@@ -64,9 +158,19 @@ class GcnMcFileDef {
 			QString gameDesc;	// regex
 			QString fileDesc;	// regex
 
+			/**
+			 * Literal prefixes required by the regexes.
+			 * A comment that doesn't start with the prefix
+			 * can't match the regex, so this is checked first.
+			 * Empty if the regex doesn't have a fixed prefix.
+			 */
+			QString gameDesc_prefix;
+			QString fileDesc_prefix;
+
 			// Regular expressions.
-			QRegularExpression gameDesc_regex;
-			QRegularExpression fileDesc_regex;
+			// These are compiled on first use.
+			LazyRegex gameDesc_regex;
+			LazyRegex fileDesc_regex;
 		} search;
 
 		/**
@@ -52,6 +52,28 @@ class GcnSearchThreadPrivate
 		 * Stop the worker thread.
 		 */
 		void stopWorkerThread(void);
+
+		/**
+		 * Search a memory card for "lost" files.
+		 * Synchronous search; non-threaded.
+		 * @param card Memory Card to search.
+		 * @param preferredRegion Preferred region.
+		 * @param searchUsedBlocks If true, search all blocks, not just blocks marked as empty.
+		 * @param incremental If true, reuse results from the previous search.
+		 * @return Number of files found on success; negative on error.
+		 */
+		int searchMemCard(GcnCard *card, char preferredRegion, bool searchUsedBlocks, bool incremental);
+
+		/**
+		 * Search a memory card for "lost" files.
+		 * Asynchronous search; uses a separate thread.
+		 * @param card Memory Card to search.
+		 * @param preferredRegion Preferred region.
+		 * @param searchUsedBlocks If true, search all blocks, not just blocks marked as empty.
+		 * @param incremental If true, reuse results from the previous search.
+		 * @return 0 if thread started successfully; non-zero on error.
+		 */
+		int searchMemCard_async(GcnCard *card, char preferredRegion, bool searchUsedBlocks, bool incremental);
 };
 
 GcnSearchThreadPrivate::GcnSearchThreadPrivate(GcnSearchThread* q)
@@ -97,6 +119,91 @@ void GcnSearchThreadPrivate::stopWorkerThread(void)
 	workerThread = nullptr;
 }
 
+/**
+ * Search a memory card for "lost" files.
+ * Synchronous search; non-threaded.
+ * @param card Memory Card to search.
+ * @param preferredRegion Preferred region.
+ * @param searchUsedBlocks If true, search all blocks, not just blocks marked as empty.
+ * @param incremental If true, reuse results from the previous search.
+ * @return Number of files found on success; negative on error.
+ */
+int GcnSearchThreadPrivate::searchMemCard(GcnCard *card, char preferredRegion, bool searchUsedBlocks, bool incremental)
+{
+	// TODO: Mutex?
+	if (workerThread) {
+		// Thread is running.
+		return -255;	// TODO: Error code constant?
+	}
+
+	// Don't do anything if no databases are loaded.
+	if (dbs.isEmpty())
+		return 0;
+
+	// Set the GcnSearchWorker's properties.
+	worker->setCard(card);
+	worker->setDatabases(dbs);
+	worker->setPreferredRegion(preferredRegion);
+	worker->setSearchUsedBlocks(searchUsedBlocks);
+	worker->setSearchThreadCount(0);	// automatic
+	worker->setScanCache(true);
+	worker->setOrigThread(nullptr);
+
+	// Search for files.
+	return (incremental ? worker->rescanMemCard() : worker->searchMemCard());
+}
+
+/**
+ * Search a memory card for "lost" files.
+ * Asynchronous search; uses a separate thread.
+ * @param card Memory Card to search.
+ * @param preferredRegion Preferred region.
+ * @param searchUsedBlocks If true, search all blocks, not just blocks marked as empty.
+ * @param incremental If true, reuse results from the previous search.
+ * @return 0 if thread started successfully; non-zero on error.
+ */
+int GcnSearchThreadPrivate::searchMemCard_async(GcnCard *card, char preferredRegion, bool searchUsedBlocks, bool incremental)
+{
+	// TODO: Mutex?
+	if (workerThread) {
+		// Thread is already running.
+		return -255;	// TODO: Error code constant?
+	}
+
+	// Don't do anything if no databases are loaded.
+	if (dbs.isEmpty())
+		return 0;
+
+	// Set up the worker thread.
+	// TODO: Do synchronous search if this fails.
+	Q_Q(GcnSearchThread);
+	workerThread = new QThread(q);
+	worker->moveToThread(workerThread);
+
+	// Set the GcnSearchWorker's properties.
+	worker->setCard(card);
+	worker->setDatabases(dbs);
+	worker->setPreferredRegion(preferredRegion);
+	worker->setSearchUsedBlocks(searchUsedBlocks);
+	worker->setSearchThreadCount(0);	// automatic
+	worker->setScanCache(true);
+	worker->setOrigThread(QThread::currentThread());
+
+	if (incremental) {
+		QObject::connect(workerThread, &QThread::started,
+				 worker, &GcnSearchWorker::rescanMemCard_threaded);
+	} else {
+		QObject::connect(workerThread, &QThread::started,
+				 worker, &GcnSearchWorker::searchMemCard_threaded);
+	}
+
+	// Start the thread.
+	workerThread->start();
+
+	// Thread initialized successfully.
+	return 0;
+}
+
 /** GcnSearchThread **/
 
 GcnSearchThread::GcnSearchThread(QObject *parent)
@@ -188,26 +295,7 @@ list<GcnSearchData> GcnSearchThread::filesFoundList(void)
 int GcnSearchThread::searchMemCard(GcnCard *card, char preferredRegion, bool searchUsedBlocks)
 {
 	Q_D(GcnSearchThread);
-
-	// TODO: Mutex?
-	if (d->workerThread) {
-		// Thread is running.
-		return -255;	// TODO: Error code constant?
-	}
-
-	// Don't do anything if no databases are loaded.
-	if (d->dbs.isEmpty())
-		return 0;
-
-	// Set the GcnSearchWorker's properties.
-	d->worker->setCard(card);
-	d->worker->setDatabases(d->dbs);
-	d->worker->setPreferredRegion(preferredRegion);
-	d->worker->setSearchUsedBlocks(searchUsedBlocks);
-	d->worker->setOrigThread(nullptr);
-
-	// Search for files.
-	return d->worker->searchMemCard();
+	return d->searchMemCard(card, preferredRegion, searchUsedBlocks, false);
 }
 
 /**
@@ -227,37 +315,43 @@ int GcnSearchThread::searchMemCard(GcnCard *card, char preferredRegion, bool sea
 int GcnSearchThread::searchMemCard_async(GcnCard *card, char preferredRegion, bool searchUsedBlocks)
 {
 	Q_D(GcnSearchThread);
+	return d->searchMemCard_async(card, preferredRegion, searchUsedBlocks, false);
+}
 
-	// TODO: Mutex?
-	if (d->workerThread) {
-		// Thread is already running.
-		return -255;	// TODO: Error code constant?
-	}
-
-	// Don't do anything if no databases are loaded.
-	if (d->dbs.isEmpty())
-		return 0;
-
-	// Set up the worker thread.
-	// TODO: Do synchronous search if this fails.
-	d->workerThread = new QThread(this);
-	d->worker->moveToThread(d->workerThread);
-
-	// Set the GcnSearchWorker's properties.
-	d->worker->setCard(card);
-	d->worker->setDatabases(d->dbs);
-	d->worker->setPreferredRegion(preferredRegion);
-	d->worker->setSearchUsedBlocks(searchUsedBlocks);
-	d->worker->setOrigThread(QThread::currentThread());
-
-	connect(d->workerThread, &QThread::started,
-		d->worker, &GcnSearchWorker::searchMemCard_threaded);
-
-	// Start the thread.
-	d->workerThread->start();
+/**
+ * Search a memory card for "lost" files, reusing the
+ * results of the previous search where possible.
+ * Only blocks that have changed since the previous
+ * search are checked again, e.g. after writing to the card.
+ * Synchronous search; non-threaded.
+ * @param card Memory Card to search.
+ * @param preferredRegion Preferred region.
+ * @param searchUsedBlocks If true, search all blocks, not just blocks marked as empty.
+ * @return Number of files found on success; negative on error.
+ */
+int GcnSearchThread::rescanMemCard(GcnCard *card, char preferredRegion, bool searchUsedBlocks)
+{
+	Q_D(GcnSearchThread);
+	return d->searchMemCard(card, preferredRegion, searchUsedBlocks, true);
+}
 
-	// Thread initialized successfully.
-	return 0;
+/**
+ * Search a memory card for "lost" files, reusing the
+ * results of the previous search where possible.
+ * Only blocks that have changed since the previous
+ * search are checked again, e.g. after writing to the card.
+ * Asynchronous search; uses a separate thread.
+ * @param card Memory Card to search.
+ * @param preferredRegion Preferred region.
+ * @param searchUsedBlocks If true, search all blocks, not just blocks marked as empty.
+ * @return 0 if thread started successfully; non-zero on error.
+ *
+ * The same signals are emitted as searchMemCard_async().
+ */
+int GcnSearchThread::rescanMemCard_async(GcnCard *card, char preferredRegion, bool searchUsedBlocks)
+{
+	Q_D(GcnSearchThread);
+	return d->searchMemCard_async(card, preferredRegion, searchUsedBlocks, true);
 }
 
 /** Slots. **/
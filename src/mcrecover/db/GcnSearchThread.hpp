@@ -146,6 +146,34 @@ class GcnSearchThread : public QObject
 		 */
 		int searchMemCard_async(GcnCard *card, char preferredRegion = 0, bool searchUsedBlocks = false);
 
+		/**
+		 * Search a memory card for "lost" files, reusing the
+		 * results of the previous search where possible.
+		 * Only blocks that have changed since the previous
+		 * search are checked again, e.g. after writing to the card.
+		 * Synchronous search; non-threaded.
+		 * @param card Memory Card to search.
+		 * @param preferredRegion Preferred region.
+		 * @param searchUsedBlocks If true, search all blocks, not just blocks marked as empty.
+		 * @return Number of files found on success; negative on error.
+		 */
+		int rescanMemCard(GcnCard *card, char preferredRegion = 0, bool searchUsedBlocks = false);
+
+		/**
+		 * Search a memory card for "lost" files, reusing the
+		 * results of the previous search where possible.
+		 * Only blocks that have changed since the previous
+		 * search are checked again, e.g. after writing to the card.
+		 * Asynchronous search; uses a separate thread.
+		 * @param card Memory Card to search.
+		 * @param preferredRegion Preferred region.
+		 * @param searchUsedBlocks If true, search all blocks, not just blocks marked as empty.
+		 * @return 0 if thread started successfully; non-zero on error.
+		 *
+		 * The same signals are emitted as searchMemCard_async().
+		 */
+		int rescanMemCard_async(GcnCard *card, char preferredRegion = 0, bool searchUsedBlocks = false);
+
 	private slots:
 		/**
 		 * Search has been cancelled.
@@ -13,6 +13,7 @@
 
 // GCN Memory Card File Database
 #include "db/GcnMcFileDb.hpp"
+#include "config/ConfigStore.hpp"
 
 // Checksum algorithm class.
 #include "Checksum.hpp"
@@ -21,12 +22,25 @@
 #include <cstdio>
 
 // C++ includes.
+#include <algorithm>
 #include <limits>
 #include <memory>
 using std::list;
 using std::unique_ptr;
 
 // Qt includes.
+#include <QtCore/QAtomicInt>
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDataStream>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QHash>
+#include <QtCore/QPointer>
+#include <QtCore/QRunnable>
+#include <QtCore/QSaveFile>
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
 #include <QtCore/QVector>
 
 /** GcnSearchWorkerPrivate **/
@@ -59,9 +73,113 @@ class GcnSearchWorkerPrivate
 		QVector<GcnMcFileDb*> databases;
 		char preferredRegion;
 		bool searchUsedBlocks;
+		int searchThreadCount;
+		bool scanCache;
 
 		// Original thread.
 		QThread *origThread;
+
+		/**
+		 * Check a block in all of the databases.
+		 * This function is reentrant.
+		 * @param buf	[in] Block data.
+		 * @param siz	[in] Size of buf.
+		 * @return Matches from all databases.
+		 */
+		QVector<GcnSearchData> checkBlock(const void *buf, int siz) const;
+
+		/**
+		 * Result of checking a single block.
+		 */
+		struct BlockResult {
+			QByteArray fingerprint;		// MD5 of the block data.
+			QVector<GcnSearchData> matches;	// Matches from all databases.
+		};
+
+		/**
+		 * Results from a previous search.
+		 * - Key: Physical block number.
+		 * - Value: BlockResult.
+		 * If a block's fingerprint hasn't changed,
+		 * the previous matches are reused.
+		 */
+		QHash<uint16_t, BlockResult> prevResults;
+
+		/**
+		 * Results from the last search, for rescanMemCard().
+		 * Only valid if the card and databases haven't changed.
+		 */
+		QHash<uint16_t, BlockResult> lastResults;
+		QPointer<GcnCard> lastCard;
+		QByteArray lastDbKey;
+
+		/**
+		 * Check a block, reusing the previous result if the
+		 * block hasn't changed since the previous search.
+		 * This function is reentrant.
+		 * @param buf		[in] Block data.
+		 * @param siz		[in] Size of buf.
+		 * @param physBlock	[in] Physical block number.
+		 * @return Block result.
+		 */
+		BlockResult checkBlockCached(const uint8_t *buf, int siz, uint16_t physBlock) const;
+
+		/** Scan cache. **/
+
+		// Scan cache magic and version.
+		// Increment SCAN_CACHE_VERSION if the format changes.
+		static const quint32 SCAN_CACHE_MAGIC = 0x4D435343;	// "MCSC"
+		static const quint32 SCAN_CACHE_VERSION = 1;
+
+		// Scan cache limits.
+		// Least-recently-used scan caches are removed
+		// when a scan cache is saved.
+		static const int SCAN_CACHE_MAX_FILES = 64;
+		static const qint64 SCAN_CACHE_MAX_SIZE = 64*1024*1024;
+
+		/**
+		 * Get a key identifying the loaded databases.
+		 * @return Database key, or empty QByteArray if unavailable.
+		 */
+		QByteArray databasesKey(void) const;
+
+		/**
+		 * Get the scan cache filename for the current card.
+		 * The filename depends on searchUsedBlocks.
+		 * @return Scan cache filename, or empty string if unavailable.
+		 */
+		QString scanCacheFilename(void) const;
+
+		/**
+		 * Load the scan cache into prevResults.
+		 * @param filename	[in] Scan cache filename.
+		 * @param dbKey		[in] Database key.
+		 * @return 0 on success; non-zero on error.
+		 */
+		int loadScanCache(const QString &filename, const QByteArray &dbKey);
+
+		/**
+		 * Save the scan cache.
+		 * @param filename		[in] Scan cache filename.
+		 * @param dbKey			[in] Database key.
+		 * @param blockSearchList	[in] Block search list.
+		 * @param results		[in] Block results, in search order.
+		 * @return 0 on success; non-zero on error.
+		 */
+		int saveScanCache(const QString &filename, const QByteArray &dbKey,
+			const QVector<uint16_t> &blockSearchList,
+			const QVector<BlockResult> &results) const;
+
+		/**
+		 * Add a matched block to filesFoundList.
+		 * This constructs the FAT entries for the file,
+		 * so it must be called in search order.
+		 * @param searchDataEntries	[in] Matches for this block.
+		 * @param physBlock		[in] Physical block number.
+		 * @param usedBlockMap		[in/out] Used block map.
+		 */
+		void addMatch(const QVector<GcnSearchData> &searchDataEntries,
+			uint16_t physBlock, QVector<uint8_t> &usedBlockMap);
 };
 
 GcnSearchWorkerPrivate::GcnSearchWorkerPrivate(GcnSearchWorker* q)
@@ -69,9 +187,444 @@ GcnSearchWorkerPrivate::GcnSearchWorkerPrivate(GcnSearchWorker* q)
 	, card(nullptr)
 	, preferredRegion(0)
 	, searchUsedBlocks(false)
+	, searchThreadCount(1)
+	, scanCache(false)
 	, origThread(nullptr)
 { }
 
+/**
+ * Check a block in all of the databases.
+ * This function is reentrant.
+ * @param buf	[in] Block data.
+ * @param siz	[in] Size of buf.
+ * @return Matches from all databases.
+ */
+QVector<GcnSearchData> GcnSearchWorkerPrivate::checkBlock(const void *buf, int siz) const
+{
+	QVector<GcnSearchData> searchDataEntries;
+	foreach (const GcnMcFileDb *db, databases) {
+		searchDataEntries += db->checkBlock(buf, siz);
+	}
+	return searchDataEntries;
+}
+
+/**
+ * Check a block, reusing the previous result if the
+ * block hasn't changed since the previous search.
+ * This function is reentrant.
+ * @param buf		[in] Block data.
+ * @param siz		[in] Size of buf.
+ * @param physBlock	[in] Physical block number.
+ * @return Block result.
+ */
+GcnSearchWorkerPrivate::BlockResult GcnSearchWorkerPrivate::checkBlockCached(
+	const uint8_t *buf, int siz, uint16_t physBlock) const
+{
+	BlockResult result;
+	result.fingerprint = QCryptographicHash::hash(
+		QByteArray::fromRawData(reinterpret_cast<const char*>(buf), siz),
+		QCryptographicHash::Md5);
+
+	auto iter = prevResults.constFind(physBlock);
+	if (iter != prevResults.constEnd() && iter->fingerprint == result.fingerprint) {
+		// Block hasn't changed.
+		result.matches = iter->matches;
+	} else {
+		result.matches = checkBlock(buf, siz);
+	}
+	return result;
+}
+
+/**
+ * Get a key identifying the loaded databases.
+ * @return Database key, or empty QByteArray if unavailable.
+ */
+QByteArray GcnSearchWorkerPrivate::databasesKey(void) const
+{
+	QCryptographicHash hash(QCryptographicHash::Sha1);
+	foreach (const GcnMcFileDb *db, databases) {
+		const QByteArray dbKey = db->cacheKey();
+		if (dbKey.isEmpty())
+			return QByteArray();
+		hash.addData(dbKey);
+	}
+	return hash.result();
+}
+
+/**
+ * Get the scan cache filename for the current card.
+ * The filename depends on searchUsedBlocks.
+ * @return Scan cache filename, or empty string if unavailable.
+ */
+QString GcnSearchWorkerPrivate::scanCacheFilename(void) const
+{
+	const QString filename = card->filename();
+	if (filename.isEmpty())
+		return QString();
+
+	// Cards with the same name can exist in multiple
+	// directories, so include a hash of the full path.
+	const QFileInfo fileInfo(filename);
+	const QByteArray pathHash = QCryptographicHash::hash(
+		fileInfo.absoluteFilePath().toUtf8(), QCryptographicHash::Sha1);
+
+	QDir configDir(ConfigStore::ConfigPath());
+	return configDir.absoluteFilePath(QLatin1String("cache/") +
+		fileInfo.completeBaseName() + QChar(L'.') +
+		QString::fromLatin1(pathHash.toHex().left(8)) +
+		(searchUsedBlocks ? QLatin1String(".all") : QLatin1String(".free")) +
+		QLatin1String(".scancache"));
+}
+
+/**
+ * Load the scan cache into prevResults.
+ * @param filename	[in] Scan cache filename.
+ * @param dbKey		[in] Database key.
+ * @return 0 on success; non-zero on error.
+ */
+int GcnSearchWorkerPrivate::loadScanCache(const QString &filename, const QByteArray &dbKey)
+{
+	QFile file(filename);
+	if (!file.open(QIODevice::ReadOnly)) {
+		// No cache.
+		return -1;
+	}
+
+	QDataStream ds(&file);
+	ds.setVersion(QDataStream::Qt_5_0);
+
+	// Header.
+	quint32 magic, version;
+	QString cardFilename;
+	QByteArray cacheDbKey;
+	qint32 blockSize, totalPhysBlocks;
+	ds >> magic >> version;
+	if (magic != SCAN_CACHE_MAGIC || version != SCAN_CACHE_VERSION) {
+		// Wrong format.
+		return -2;
+	}
+	ds >> cardFilename >> cacheDbKey >> blockSize >> totalPhysBlocks;
+	if (ds.status() != QDataStream::Ok ||
+	    cardFilename != QFileInfo(card->filename()).absoluteFilePath() ||
+	    cacheDbKey != dbKey ||
+	    blockSize != card->blockSize() ||
+	    totalPhysBlocks != card->totalPhysBlocks())
+	{
+		// Cache is for a different card or database.
+		return -3;
+	}
+
+	// Block results.
+	QHash<uint16_t, BlockResult> results;
+	quint32 count;
+	ds >> count;
+	for (; count > 0 && ds.status() == QDataStream::Ok; count--) {
+		quint16 physBlock;
+		quint32 matchCount;
+		BlockResult result;
+		ds >> physBlock >> result.fingerprint >> matchCount;
+		for (; matchCount > 0 && ds.status() == QDataStream::Ok; matchCount--) {
+			GcnSearchData searchData;
+			ds.readRawData(reinterpret_cast<char*>(&searchData.dirEntry),
+				sizeof(searchData.dirEntry));
+
+			quint32 chkCount;
+			ds >> chkCount;
+			for (; chkCount > 0 && ds.status() == QDataStream::Ok; chkCount--) {
+				Checksum::ChecksumDef checksumDef;
+				quint8 algorithm, endian;
+				ds >> algorithm >> checksumDef.address >> checksumDef.param
+				   >> checksumDef.start >> checksumDef.length >> endian;
+				checksumDef.algorithm = (Checksum::ChkAlgorithm)algorithm;
+				checksumDef.endian = (Checksum::ChkEndian)endian;
+				searchData.checksumDefs.append(checksumDef);
+			}
+			result.matches.append(searchData);
+		}
+		results.insert(physBlock, result);
+	}
+
+	if (ds.status() != QDataStream::Ok || count != 0) {
+		// Corrupted cache.
+		return -4;
+	}
+
+	prevResults = results;
+	return 0;
+}
+
+/**
+ * Save the scan cache.
+ * @param filename		[in] Scan cache filename.
+ * @param dbKey			[in] Database key.
+ * @param blockSearchList	[in] Block search list.
+ * @param results		[in] Block results, in search order.
+ * @return 0 on success; non-zero on error.
+ */
+int GcnSearchWorkerPrivate::saveScanCache(const QString &filename, const QByteArray &dbKey,
+	const QVector<uint16_t> &blockSearchList,
+	const QVector<BlockResult> &results) const
+{
+	// Make sure the cache directory exists.
+	QFileInfo cacheFileInfo(filename);
+	if (!cacheFileInfo.dir().mkpath(QLatin1String("."))) {
+		// Unable to create the cache directory.
+		return -1;
+	}
+
+	QSaveFile file(filename);
+	if (!file.open(QIODevice::WriteOnly)) {
+		// Unable to create the cache file.
+		return -1;
+	}
+
+	QDataStream ds(&file);
+	ds.setVersion(QDataStream::Qt_5_0);
+
+	// Header.
+	ds << SCAN_CACHE_MAGIC << SCAN_CACHE_VERSION;
+	ds << QFileInfo(card->filename()).absoluteFilePath() << dbKey
+	   << (qint32)card->blockSize() << (qint32)card->totalPhysBlocks();
+
+	// Block results.
+	// Blocks that couldn't be read don't have a fingerprint.
+	quint32 count = 0;
+	foreach (const BlockResult &result, results) {
+		if (!result.fingerprint.isEmpty())
+			count++;
+	}
+	ds << count;
+
+	for (int i = 0; i < results.size(); i++) {
+		const BlockResult &result = results.at(i);
+		if (result.fingerprint.isEmpty())
+			continue;
+
+		ds << (quint16)blockSearchList.at(i) << result.fingerprint
+		   << (quint32)result.matches.size();
+		foreach (const GcnSearchData &searchData, result.matches) {
+			ds.writeRawData(reinterpret_cast<const char*>(&searchData.dirEntry),
+				sizeof(searchData.dirEntry));
+			ds << (quint32)searchData.checksumDefs.size();
+			foreach (const Checksum::ChecksumDef &checksumDef, searchData.checksumDefs) {
+				ds << (quint8)checksumDef.algorithm << checksumDef.address
+				   << checksumDef.param << checksumDef.start
+				   << checksumDef.length << (quint8)checksumDef.endian;
+			}
+		}
+	}
+
+	if (ds.status() != QDataStream::Ok) {
+		// Write error.
+		file.cancelWriting();
+		return -2;
+	}
+
+	if (!file.commit())
+		return -2;
+
+	// Remove old scan caches.
+	ConfigStore::PruneCache(QLatin1String("*.scancache"),
+		SCAN_CACHE_MAX_FILES, SCAN_CACHE_MAX_SIZE);
+	return 0;
+}
+
+/**
+ * Add a matched block to filesFoundList.
+ * This constructs the FAT entries for the file,
+ * so it must be called in search order.
+ * @param searchDataEntries	[in] Matches for this block.
+ * @param physBlock		[in] Physical block number.
+ * @param usedBlockMap		[in/out] Used block map.
+ */
+void GcnSearchWorkerPrivate::addMatch(const QVector<GcnSearchData> &searchDataEntries,
+	uint16_t physBlock, QVector<uint8_t> &usedBlockMap)
+{
+	if (searchDataEntries.isEmpty())
+		return;
+
+	// TODO: Search for preferred region. For now, just use the first hit.
+	// Matched!
+	GcnSearchData searchData;
+	if (searchDataEntries.size() == 1 || preferredRegion == 0) {
+		// Only one entry, or no preferred region.
+		searchData = searchDataEntries.at(0);
+	} else {
+		// Find an entry matching the preferred region.
+		bool isMatch = false;
+		for (int i = 0; i < searchDataEntries.size(); i++) {
+			const GcnSearchData &schk = searchDataEntries.at(i);
+			if (schk.dirEntry.gamecode[3] == preferredRegion) {
+				// Found a match!
+				searchData = schk;
+				isMatch = true;
+				break;
+			}
+		}
+
+		if (!isMatch) {
+			// No region match. Use the first entry.
+			searchData = searchDataEntries.at(0);
+		}
+	}
+
+	// NOTE: GcnMcFileDb doesn't initialize fatEntries.
+	// Hence, we have to make a copy and initialize the list.
+	fprintf(stderr, "FOUND A MATCH: %-.4s%-.2s %-.32s\n",
+		searchData.dirEntry.gamecode,
+		searchData.dirEntry.company,
+		searchData.dirEntry.filename);
+	fprintf(stderr, "bannerFmt == %02X, iconAddress == %08X, iconFormat == %02X, iconSpeed == %02X\n",
+		searchData.dirEntry.bannerfmt,
+		searchData.dirEntry.iconaddr,
+		searchData.dirEntry.iconfmt,
+		searchData.dirEntry.iconspeed);
+
+	// NOTE: dirEntry's block start is not set by d->db->checkBlock().
+	// Set it here.
+	searchData.dirEntry.block = physBlock;
+	if (searchData.dirEntry.length == 0) {
+		// This only happens if an entry is either
+		// missing a <dirEntry>, or has <length>0</length>.
+		// TODO: Check for this in GcnMcFileDb.
+		searchData.dirEntry.length = 1;
+	}
+
+	// Construct the FAT entries for this file.
+	const int totalPhysBlocks = usedBlockMap.size();
+	searchData.fatEntries.clear();
+	searchData.fatEntries.reserve(searchData.dirEntry.length);
+
+	// First block is always valid.
+	searchData.fatEntries.append(searchData.dirEntry.block);
+	if (usedBlockMap[searchData.dirEntry.block] < std::numeric_limits<uint8_t>::max())
+		usedBlockMap[searchData.dirEntry.block]++;
+
+	uint16_t blocksRemaining = (searchData.dirEntry.length - 1);
+	uint16_t block = (searchData.dirEntry.block + 1);
+	bool wasWrapped = false;
+
+	// Skip used blocks and go after empty blocks only.
+	while (blocksRemaining > 0) {
+		if (block >= totalPhysBlocks) {
+			// Wraparound.
+			// Do NOT mark the wrapped blocks as used,
+			// since they might be used by actual files.
+			block = 5;
+			wasWrapped = true;
+			continue;
+		} else if (block == searchData.dirEntry.block) {
+			// ERROR: We wrapped around!
+			// Use the "naive" algorithm after the last valid block.
+			break;
+		}
+
+		// Check if this block is used.
+		if (usedBlockMap[block] == 0) {
+			// Block is not used.
+			searchData.fatEntries.append(block);
+			if (!wasWrapped)
+				usedBlockMap[block]++;
+			blocksRemaining--;
+		}
+
+		// Next block.
+		block++;
+	}
+
+	// Naive block algorithm for the remaining blocks.
+	block = (searchData.fatEntries.value(searchData.fatEntries.size() - 1) + 1);
+	wasWrapped = false;
+	while (blocksRemaining > 0) {
+		if (block >= totalPhysBlocks) {
+			// Wraparound.
+			// Do NOT mark the wrapped blocks as used,
+			// since they might be used by actual files.
+			block = 5;
+			continue;
+		}
+
+		// Add this block.
+		searchData.fatEntries.append(block);
+		if (usedBlockMap[block] < std::numeric_limits<uint8_t>::max()) {
+			if (!wasWrapped)
+				usedBlockMap[block]++;
+		}
+		block++;
+		blocksRemaining--;
+	}
+
+	// Add the search data to the list. (front of list)
+	filesFoundList.push_front(searchData);
+}
+
+/** GcnSearchBlockTask **/
+
+/**
+ * Check a range of blocks on a QThreadPool thread.
+ * The block data must be available in memory beforehand,
+ * since Card::readBlock() is not reentrant.
+ */
+class GcnSearchBlockTask : public QRunnable
+{
+	public:
+		/**
+		 * Create a block search task.
+		 * @param d		[in] GcnSearchWorkerPrivate.
+		 * @param blockPtrs	[in] Block data pointers for the entire search list.
+		 * @param physBlocks	[in] Physical block numbers for the entire search list.
+		 * @param blockSize	[in] Block size.
+		 * @param first		[in] First index in the search list.
+		 * @param count		[in] Number of blocks to check.
+		 * @param results	[out] Per-block results for the entire search list.
+		 * @param blocksDone	[in/out] Number of blocks checked.
+		 * @param blocksMatched	[in/out] Number of blocks with matches.
+		 */
+		GcnSearchBlockTask(const GcnSearchWorkerPrivate *d,
+			const uint8_t *const *blockPtrs, const uint16_t *physBlocks,
+			int blockSize, int first, int count,
+			GcnSearchWorkerPrivate::BlockResult *results,
+			QAtomicInt *blocksDone, QAtomicInt *blocksMatched)
+			: d(d)
+			, blockPtrs(blockPtrs)
+			, physBlocks(physBlocks)
+			, blockSize(blockSize)
+			, first(first)
+			, count(count)
+			, results(results)
+			, blocksDone(blocksDone)
+			, blocksMatched(blocksMatched)
+		{ }
+
+	private:
+		Q_DISABLE_COPY(GcnSearchBlockTask)
+
+	public:
+		void run(void) final
+		{
+			const int last = first + count;
+			for (int i = first; i < last; i++) {
+				if (blockPtrs[i]) {
+					results[i] = d->checkBlockCached(blockPtrs[i], blockSize, physBlocks[i]);
+					if (!results[i].matches.isEmpty())
+						blocksMatched->ref();
+				}
+				blocksDone->ref();
+			}
+		}
+
+	private:
+		const GcnSearchWorkerPrivate *const d;
+		const uint8_t *const *const blockPtrs;
+		const uint16_t *const physBlocks;
+		const int blockSize;
+		const int first;
+		const int count;
+		GcnSearchWorkerPrivate::BlockResult *const results;
+		QAtomicInt *const blocksDone;
+		QAtomicInt *const blocksMatched;
+};
+
 /** GcnSearchWorker **/
 
 GcnSearchWorker::GcnSearchWorker(QObject *parent)
@@ -198,6 +751,60 @@ void GcnSearchWorker::setSearchUsedBlocks(bool searchUsedBlocks)
 	d->searchUsedBlocks = searchUsedBlocks;
 }
 
+/**
+ * Get the number of threads used to check blocks.
+ * @return Number of threads. (0 == automatic; 1 == single-threaded)
+ */
+int GcnSearchWorker::searchThreadCount(void) const
+{
+	Q_D(const GcnSearchWorker);
+	return d->searchThreadCount;
+}
+
+/**
+ * Set the number of threads used to check blocks.
+ *
+ * If more than one thread is used, blocks are read into
+ * memory first, checked in parallel, and then merged in
+ * search order. The results are identical to a
+ * single-threaded search.
+ *
+ * @param searchThreadCount Number of threads. (0 == automatic; 1 == single-threaded)
+ */
+void GcnSearchWorker::setSearchThreadCount(int searchThreadCount)
+{
+	// TODO: Not if searching?
+	Q_D(GcnSearchWorker);
+	d->searchThreadCount = (searchThreadCount >= 0 ? searchThreadCount : 1);
+}
+
+/**
+ * Is the scan cache enabled?
+ * @return True if enabled; false if not.
+ */
+bool GcnSearchWorker::scanCache(void) const
+{
+	Q_D(const GcnSearchWorker);
+	return d->scanCache;
+}
+
+/**
+ * Enable or disable the scan cache.
+ *
+ * If enabled, the results of checking each block are saved
+ * in the configuration directory. When the same card is
+ * searched again with the same databases, blocks that
+ * haven't changed aren't checked again.
+ *
+ * @param scanCache True to enable; false to disable.
+ */
+void GcnSearchWorker::setScanCache(bool scanCache)
+{
+	// TODO: Not if searching?
+	Q_D(GcnSearchWorker);
+	d->scanCache = scanCache;
+}
+
 /**
  * Get the "original thread".
  *
@@ -240,6 +847,35 @@ void GcnSearchWorker::setOrigThread(QThread *origThread)
  * If an error occurs, check the errorString(). (TODO)
  */
 int GcnSearchWorker::searchMemCard(void)
+{
+	return searchMemCard_int(false);
+}
+
+/**
+ * Search a memory card for "lost" files, reusing the
+ * results of the previous search where possible.
+ *
+ * Each block's fingerprint is compared to the previous
+ * search of the same card with the same databases. Only
+ * blocks that have changed are checked again, e.g. after
+ * writing to the card. FAT reconstruction is always redone.
+ *
+ * If the card or databases have changed, this is the
+ * same as searchMemCard().
+ *
+ * @return Number of files found on success; negative on error.
+ */
+int GcnSearchWorker::rescanMemCard(void)
+{
+	return searchMemCard_int(true);
+}
+
+/**
+ * Search a memory card for "lost" files.
+ * @param incremental If true, reuse results from the previous search.
+ * @return Number of files found on success; negative on error.
+ */
+int GcnSearchWorker::searchMemCard_int(bool incremental)
 {
 	Q_D(GcnSearchWorker);
 	d->filesFoundList.clear();
@@ -300,152 +936,155 @@ int GcnSearchWorker::searchMemCard(void)
 		return 0;
 	}
 
-	// Block buffer.
 	const int blockSize = d->card->blockSize();
-	unique_ptr<uint8_t[]> buf(new uint8_t[blockSize]);
+	const int totalSearchBlocks = blockSearchList.size();
+
+	// Number of threads to use for checking blocks.
+	int threadCount = d->searchThreadCount;
+	if (threadCount <= 0) {
+		threadCount = QThread::idealThreadCount();
+	}
+	if (threadCount > totalSearchBlocks) {
+		threadCount = totalSearchBlocks;
+	}
 
 	fprintf(stderr, "--------------------------------\n");
 	fprintf(stderr, "SCANNING MEMORY CARD...\n");
 
-	const int totalSearchBlocks = blockSearchList.size();
+	// Get the previous results.
+	// Unchanged blocks will reuse them.
+	d->prevResults.clear();
+	const QByteArray dbKey = d->databasesKey();
+	QString scanCacheFilename;
+	if (d->scanCache && !dbKey.isEmpty()) {
+		scanCacheFilename = d->scanCacheFilename();
+	}
+	if (incremental && d->lastCard == d->card &&
+	    !dbKey.isEmpty() && d->lastDbKey == dbKey)
+	{
+		// Use the results from the last search.
+		d->prevResults = d->lastResults;
+	} else if (!scanCacheFilename.isEmpty()) {
+		// Load the scan cache.
+		d->loadScanCache(scanCacheFilename, dbKey);
+	}
+
 	int currentPhysBlock = blockSearchList.value(0);
 	emit searchStarted(totalPhysBlocks, totalSearchBlocks, currentPhysBlock);
 
-	int currentSearchBlock = -1;	// compensate for currentSearchBlock++
-	foreach (currentPhysBlock, blockSearchList) {
-		currentSearchBlock++;
-		fprintf(stderr, "Searching block: %d...\n", currentPhysBlock);
-		emit searchUpdate(currentPhysBlock, currentSearchBlock, d->filesFoundList.size());
-
-		int ret = d->card->readBlock(buf.get(), blockSize, currentPhysBlock);
-		if (ret != blockSize) {
-			// Error reading block.
-			fprintf(stderr, "ERROR reading block %d - readBlock() returned %d.\n", currentPhysBlock, ret);
-			continue;
-		}
+	// Block results, in search order.
+	QVector<GcnSearchWorkerPrivate::BlockResult> results(totalSearchBlocks);
 
-		// Check the block in the databases.
-		QVector<GcnSearchData> searchDataEntries;
-		foreach (GcnMcFileDb *db, d->databases) {
-			QVector<GcnSearchData> curEntries = db->checkBlock(buf.get(), blockSize);
-			searchDataEntries += curEntries;
-		}
-
-		// TODO: Search for preferred region. For now, just use the first hit.
-		if (!searchDataEntries.isEmpty()) {
-			// Matched!
-			GcnSearchData searchData;
-			if (searchDataEntries.size() == 1 || d->preferredRegion == 0) {
-				// Only one entry, or no preferred region.
-				searchData = searchDataEntries.at(0);
-			} else {
-				// Find an entry matching the preferred region.
-				bool isMatch = false;
-				for (int i = 0; i < searchDataEntries.size(); i++) {
-					const GcnSearchData &schk = searchDataEntries.at(i);
-					if (schk.dirEntry.gamecode[3] == d->preferredRegion) {
-						// Found a match!
-						searchData = schk;
-						isMatch = true;
-						break;
-					}
+	int currentSearchBlock = -1;	// compensate for currentSearchBlock++
+	if (threadCount <= 1) {
+		// Single-threaded search.
+		// Block buffer. (Only used if the card isn't mapped.)
+		unique_ptr<uint8_t[]> buf;
+
+		foreach (currentPhysBlock, blockSearchList) {
+			currentSearchBlock++;
+			fprintf(stderr, "Searching block: %d...\n", currentPhysBlock);
+			emit searchUpdate(currentPhysBlock, currentSearchBlock, d->filesFoundList.size());
+
+			// If the card is mapped, check the block in place.
+			const uint8_t *blockData = d->card->blockPtr(currentPhysBlock);
+			if (!blockData) {
+				if (!buf) {
+					buf.reset(new uint8_t[blockSize]);
 				}
-
-				if (!isMatch) {
-					// No region match. Use the first entry.
-					searchData = searchDataEntries.at(0);
+				int ret = d->card->readBlock(buf.get(), blockSize, currentPhysBlock);
+				if (ret != blockSize) {
+					// Error reading block.
+					fprintf(stderr, "ERROR reading block %d - readBlock() returned %d.\n", currentPhysBlock, ret);
+					continue;
 				}
+				blockData = buf.get();
 			}
 
-			// NOTE: GcnMcFileDb doesn't initialize fatEntries.
-			// Hence, we have to make a copy and initialize the list.
-			fprintf(stderr, "FOUND A MATCH: %-.4s%-.2s %-.32s\n",
-				searchData.dirEntry.gamecode,
-				searchData.dirEntry.company,
-				searchData.dirEntry.filename);
-			fprintf(stderr, "bannerFmt == %02X, iconAddress == %08X, iconFormat == %02X, iconSpeed == %02X\n",
-				searchData.dirEntry.bannerfmt,
-				searchData.dirEntry.iconaddr,
-				searchData.dirEntry.iconfmt,
-				searchData.dirEntry.iconspeed);
-
-			// NOTE: dirEntry's block start is not set by d->db->checkBlock().
-			// Set it here.
-			searchData.dirEntry.block = currentPhysBlock;
-			if (searchData.dirEntry.length == 0) {
-				// This only happens if an entry is either
-				// missing a <dirEntry>, or has <length>0</length>.
-				// TODO: Check for this in GcnMcFileDb.
-				searchData.dirEntry.length = 1;
+			// Check the block in the databases.
+			results[currentSearchBlock] = d->checkBlockCached(
+				blockData, blockSize, currentPhysBlock);
+			d->addMatch(results.at(currentSearchBlock).matches,
+				currentPhysBlock, usedBlockMap);
+		}
+	} else {
+		// Multi-threaded search.
+		fprintf(stderr, "Searching %d blocks using %d threads...\n", totalSearchBlocks, threadCount);
+
+		// Get pointers to all of the blocks first.
+		// If the card is mapped, the blocks are checked in place.
+		// Otherwise, they're read into memory, since
+		// Card::readBlock() isn't reentrant.
+		QVector<const uint8_t*> blockPtrs(totalSearchBlocks, nullptr);
+		unique_ptr<uint8_t[]> blockData;
+		for (int i = 0; i < totalSearchBlocks; i++) {
+			const uint16_t physBlock = blockSearchList.at(i);
+			blockPtrs[i] = d->card->blockPtr(physBlock);
+			if (blockPtrs[i])
+				continue;
+
+			if (!blockData) {
+				blockData.reset(new uint8_t[(size_t)totalSearchBlocks * blockSize]);
 			}
-
-			// Construct the FAT entries for this file.
-			searchData.fatEntries.clear();
-			searchData.fatEntries.reserve(searchData.dirEntry.length);
-
-			// First block is always valid.
-			searchData.fatEntries.append(searchData.dirEntry.block);
-			if (usedBlockMap[searchData.dirEntry.block] < std::numeric_limits<uint8_t>::max())
-				usedBlockMap[searchData.dirEntry.block]++;
-
-			uint16_t blocksRemaining = (searchData.dirEntry.length - 1);
-			uint16_t block = (searchData.dirEntry.block + 1);
-			bool wasWrapped = false;
-
-			// Skip used blocks and go after empty blocks only.
-			while (blocksRemaining > 0) {
-				if (block >= totalPhysBlocks) {
-					// Wraparound.
-					// Do NOT mark the wrapped blocks as used,
-					// since they might be used by actual files.
-					block = 5;
-					wasWrapped = true;
-					continue;
-				} else if (block == searchData.dirEntry.block) {
-					// ERROR: We wrapped around!
-					// Use the "naive" algorithm after the last valid block.
-					break;
-				}
-
-				// Check if this block is used.
-				if (usedBlockMap[block] == 0) {
-					// Block is not used.
-					searchData.fatEntries.append(block);
-					if (!wasWrapped)
-						usedBlockMap[block]++;
-					blocksRemaining--;
-				}
-
-				// Next block.
-				block++;
+			uint8_t *const ptr = &blockData[(size_t)i * blockSize];
+			int ret = d->card->readBlock(ptr, blockSize, physBlock);
+			if (ret != blockSize) {
+				// Error reading block.
+				fprintf(stderr, "ERROR reading block %d - readBlock() returned %d.\n", physBlock, ret);
+				continue;
 			}
+			blockPtrs[i] = ptr;
+		}
 
-			// Naive block algorithm for the remaining blocks.
-			block = (searchData.fatEntries.value(searchData.fatEntries.size() - 1) + 1);
-			wasWrapped = false;
-			while (blocksRemaining > 0) {
-				if (block >= totalPhysBlocks) {
-					// Wraparound.
-					// Do NOT mark the wrapped blocks as used,
-					// since they might be used by actual files.
-					block = 5;
-					continue;
-				}
+		// Check the blocks in a thread pool.
+		// Small chunks keep the threads balanced,
+		// since most of the time is spent on blocks
+		// that have potential matches.
+		static const int CHUNK_SIZE = 16;
+		QAtomicInt blocksDone(0), blocksMatched(0);
+		QThreadPool pool;
+		pool.setMaxThreadCount(threadCount);
+		for (int i = 0; i < totalSearchBlocks; i += CHUNK_SIZE) {
+			const int count = std::min(CHUNK_SIZE, totalSearchBlocks - i);
+			pool.start(new GcnSearchBlockTask(d, blockPtrs.constData(),
+				blockSearchList.constData(), blockSize,
+				i, count, results.data(), &blocksDone, &blocksMatched));
+		}
 
-				// Add this block.
-				searchData.fatEntries.append(block);
-				if (usedBlockMap[block] < std::numeric_limits<uint8_t>::max()) {
-					if (!wasWrapped)
-						usedBlockMap[block]++;
-				}
-				block++;
-				blocksRemaining--;
+		// Report progress while the threads are running.
+		while (!pool.waitForDone(50)) {
+			const int done = blocksDone.load();
+			if (done > 0 && done < totalSearchBlocks) {
+				emit searchUpdate(blockSearchList.at(done), done - 1, blocksMatched.load());
 			}
+		}
+
+		// Merge the results in search order.
+		// FAT reconstruction depends on usedBlockMap,
+		// so this must be done serially.
+		for (int i = 0; i < totalSearchBlocks; i++) {
+			currentSearchBlock++;
+			d->addMatch(results.at(i).matches, blockSearchList.at(i), usedBlockMap);
+		}
+	}
 
-			// Add the search data to the list. (front of list)
-			d->filesFoundList.push_front(searchData);
+	// Save the results for rescanMemCard().
+	// Blocks that couldn't be read don't have a fingerprint.
+	d->prevResults.clear();
+	d->lastResults.clear();
+	d->lastResults.reserve(totalSearchBlocks);
+	for (int i = 0; i < totalSearchBlocks; i++) {
+		if (!results.at(i).fingerprint.isEmpty()) {
+			d->lastResults.insert(blockSearchList.at(i), results.at(i));
 		}
 	}
+	d->lastCard = d->card;
+	d->lastDbKey = dbKey;
+
+	// Save the scan cache.
+	if (!scanCacheFilename.isEmpty()) {
+		d->saveScanCache(scanCacheFilename, dbKey, blockSearchList, results);
+	}
 
 	// Send an update for the last block.
 	emit searchUpdate(5, currentSearchBlock, d->filesFoundList.size());
@@ -464,6 +1103,26 @@ int GcnSearchWorker::searchMemCard(void)
  * Thread information must have been set using setThreadInfo().
  */
 void GcnSearchWorker::searchMemCard_threaded(void)
+{
+	searchMemCard_threaded_int(false);
+}
+
+/**
+ * Search the memory card for "lost" files, reusing the
+ * results of the previous search where possible.
+ * This version should be connected to a QThread's SIGNAL(started()).
+ * Thread information must have been set using setThreadInfo().
+ */
+void GcnSearchWorker::rescanMemCard_threaded(void)
+{
+	searchMemCard_threaded_int(true);
+}
+
+/**
+ * Search the memory card for "lost" files in the worker thread.
+ * @param incremental If true, reuse results from the previous search.
+ */
+void GcnSearchWorker::searchMemCard_threaded_int(bool incremental)
 {
 	Q_D(GcnSearchWorker);
 
@@ -483,7 +1142,7 @@ void GcnSearchWorker::searchMemCard_threaded(void)
 	}
 
 	// Search the memory card.
-	searchMemCard();
+	searchMemCard_int(incremental);
 
 	// Move back to the original thread.
 	moveToThread(d->origThread);
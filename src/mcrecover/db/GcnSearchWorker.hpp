@@ -42,6 +42,8 @@ class GcnSearchWorker : public QObject
 	Q_PROPERTY(QVector<GcnMcFileDb*> databases READ databases WRITE setDatabases)
 	Q_PROPERTY(char preferredRegion READ preferredRegion WRITE setPreferredRegion)
 	Q_PROPERTY(bool searchUsedBlocks READ searchUsedBlocks WRITE setSearchUsedBlocks)
+	Q_PROPERTY(int searchThreadCount READ searchThreadCount WRITE setSearchThreadCount)
+	Q_PROPERTY(bool scanCache READ scanCache WRITE setScanCache)
 	Q_PROPERTY(QThread* origThread READ origThread WRITE setOrigThread)
 
 	public:
@@ -158,6 +160,42 @@ class GcnSearchWorker : public QObject
 		 */
 		void setSearchUsedBlocks(bool searchUsedBlocks);
 
+		/**
+		 * Get the number of threads used to check blocks.
+		 * @return Number of threads. (0 == automatic; 1 == single-threaded)
+		 */
+		int searchThreadCount(void) const;
+
+		/**
+		 * Set the number of threads used to check blocks.
+		 *
+		 * If more than one thread is used, blocks are read into
+		 * memory first, checked in parallel, and then merged in
+		 * search order. The results are identical to a
+		 * single-threaded search.
+		 *
+		 * @param searchThreadCount Number of threads. (0 == automatic; 1 == single-threaded)
+		 */
+		void setSearchThreadCount(int searchThreadCount);
+
+		/**
+		 * Is the scan cache enabled?
+		 * @return True if enabled; false if not.
+		 */
+		bool scanCache(void) const;
+
+		/**
+		 * Enable or disable the scan cache.
+		 *
+		 * If enabled, the results of checking each block are saved
+		 * in the configuration directory. When the same card is
+		 * searched again with the same databases, blocks that
+		 * haven't changed aren't checked again.
+		 *
+		 * @param scanCache True to enable; false to disable.
+		 */
+		void setScanCache(bool scanCache);
+
 		/**
 		 * Get the "original thread".
 		 *
@@ -193,6 +231,22 @@ class GcnSearchWorker : public QObject
 		 */
 		int searchMemCard(void);
 
+		/**
+		 * Search a memory card for "lost" files, reusing the
+		 * results of the previous search where possible.
+		 *
+		 * Each block's fingerprint is compared to the previous
+		 * search of the same card with the same databases. Only
+		 * blocks that have changed are checked again, e.g. after
+		 * writing to the card. FAT reconstruction is always redone.
+		 *
+		 * If the card or databases have changed, this is the
+		 * same as searchMemCard().
+		 *
+		 * @return Number of files found on success; negative on error.
+		 */
+		int rescanMemCard(void);
+
 		/**
 		 * Set internal information for threading purposes.
 		 * This is basically the parameters to searchMemCard().
@@ -215,6 +269,28 @@ class GcnSearchWorker : public QObject
 		 * Thread information must have been set using setThreadInfo().
 		 */
 		void searchMemCard_threaded(void);
+
+		/**
+		 * Search the memory card for "lost" files, reusing the
+		 * results of the previous search where possible.
+		 * This version should be connected to a QThread's SIGNAL(started()).
+		 * Thread information must have been set using setThreadInfo().
+		 */
+		void rescanMemCard_threaded(void);
+
+	private:
+		/**
+		 * Search a memory card for "lost" files.
+		 * @param incremental If true, reuse results from the previous search.
+		 * @return Number of files found on success; negative on error.
+		 */
+		int searchMemCard_int(bool incremental);
+
+		/**
+		 * Search the memory card for "lost" files in the worker thread.
+		 * @param incremental If true, reuse results from the previous search.
+		 */
+		void searchMemCard_threaded_int(bool incremental);
 };
 
 #endif /* __MCRECOVER_DB_GCNSEARCHWORKER_HPP__ */
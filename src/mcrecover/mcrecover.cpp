@@ -9,10 +9,12 @@
 #include "mcrecover.hpp"
 
 #include "windows/McRecoverWindow.hpp"
+#include "BatchRecover.hpp"
 
 // C includes.
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 // Qt includes.
 #include "McRecoverQApplication.hpp"
@@ -26,6 +28,13 @@
  */
 int mcrecover_main(int argc, char *argv[])
 {
+	// Batch mode doesn't use any widgets.
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "--batch")) {
+			return BatchRecover::main(argc, argv);
+		}
+	}
+
 	// Enable High DPI.
 	McRecoverQApplication::setAttribute(Qt::AA_UseHighDpiPixmaps, true);
 #if QT_VERSION >= 0x050600
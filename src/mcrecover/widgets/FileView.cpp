@@ -11,6 +11,7 @@
 #include "libmemcard/File.hpp"
 #include "libmemcard/GcnFile.hpp" /* FIXME: Remove later */
 #include "libmemcard/VmuFile.hpp" /* FIXME: Remove later */
+#include "IconAnimClock.hpp"
 #include "IconAnimHelper.hpp"
 
 // XML template dialog.
@@ -21,9 +22,6 @@
 #include "libsaveedit/EditorWindow.hpp"
 #include "libsaveedit/EditorWidgetFactory.hpp"
 
-// Qt includes.
-#include <QtCore/QTimer>
-
 /** FileViewPrivate **/
 
 #include "ui_FileView.h"
@@ -48,8 +46,10 @@ class FileViewPrivate
 		// Icon animation helper.
 		IconAnimHelper helper;
 
-		// Animation timer.
-		QTimer *animTimer;
+		// Animation tick for the next frame.
+		// Only valid if animActive is true.
+		quint64 nextFrameTick;
+		bool animActive;
 		// Pause count. If >0, animation is paused.
 		int pauseCounter;
 
@@ -60,7 +60,7 @@ class FileViewPrivate
 
 		/**
 		 * Update the animation timer state.
-		 * Starts the timer if animated icons are present; stops the timer if not.
+		 * Schedules the next frame if an animated icon is present.
 		 */
 		void updateAnimTimerState(void);
 
@@ -73,12 +73,13 @@ class FileViewPrivate
 FileViewPrivate::FileViewPrivate(FileView *q)
 	: q_ptr(q)
 	, file(nullptr)
-	, animTimer(new QTimer(q))
+	, nextFrameTick(0)
+	, animActive(false)
 	, pauseCounter(0)
 	, xmlTemplateDialogManager(new XmlTemplateDialogManager(q))
 {
-	// Connect animTimer's timeout() signal.
-	QObject::connect(animTimer, &QTimer::timeout,
+	// Connect the shared animation clock.
+	QObject::connect(IconAnimClock::instance(), &IconAnimClock::tick,
 		q, &FileView::animTimer_slot);
 }
 
@@ -214,20 +215,21 @@ void FileViewPrivate::updateWidgetDisplay(void)
 
 /**
  * Update the animation timer state.
- * Starts the timer if animated icons are present; stops the timer if not.
+ * Schedules the next frame if an animated icon is present.
  */
 void FileViewPrivate::updateAnimTimerState(void)
 {
 	if (pauseCounter <= 0 && file != nullptr && helper.isAnimated()) {
 		// Animation is not paused, and we have an animated icon.
-		// Start the timer.
-		// FIXME: Support PAL; handle extra beginning frame and reduced ending frame.
-		// FIXME: Dreamcast animation timing?
-		animTimer->start(67 /*4*1000/60*/);
+		// Request a tick from the animation clock for the next frame.
+		IconAnimClock *const clock = IconAnimClock::instance();
+		nextFrameTick = clock->currentTick() + helper.ticksUntilNextFrame();
+		animActive = true;
+		clock->requestTick(nextFrameTick);
 	} else {
 		// Either animation is paused, or we don't have an animated icon.
-		// Stop the timer.
-		animTimer->stop();
+		// Don't request any more ticks.
+		animActive = false;
 	}
 }
 
@@ -368,24 +370,34 @@ void FileView::file_destroyed_slot(QObject *obj)
 
 
 /**
- * Animation timer slot.
+ * Animation clock tick.
+ * @param now Current animation tick.
  */
-void FileView::animTimer_slot(void)
+void FileView::animTimer_slot(quint64 now)
 {
 	Q_D(FileView);
+	if (!d->animActive || now < d->nextFrameTick) {
+		// Our icon isn't due yet.
+		// (The tick was requested by another client.)
+		// Our own request is still pending in the clock.
+		return;
+	}
 	if (!d->file || !d->helper.isAnimated() || d->pauseCounter > 0) {
 		// No file is loaded, or the file doesn't have an animated icon.
-		// Stop the animation timer.
-		d->animTimer->stop();
+		d->animActive = false;
 		return;
 	}
 
-	// Check if the animated icon should be updated.
-	bool iconUpdated = d->helper.tick();
+	// Go to the next frame.
+	bool iconUpdated = d->helper.advanceFrame();
 	if (iconUpdated) {
 		// Icon has been updated.
 		d->ui.lblFileIcon->setPixmap(d->helper.icon());
 	}
+
+	// Schedule the next frame.
+	d->nextFrameTick = now + d->helper.ticksUntilNextFrame();
+	IconAnimClock::instance()->requestTick(d->nextFrameTick);
 }
 
 /**
@@ -73,9 +73,10 @@ class FileView : public QWidget
 		void file_destroyed_slot(QObject *obj = 0);
 
 		/**
-		 * Animation timer slot.
+		 * Animation clock tick.
+		 * @param now Current animation tick.
 		 */
-		void animTimer_slot(void);
+		void animTimer_slot(quint64 now);
 
 		/**
 		 * XML button was pressed.
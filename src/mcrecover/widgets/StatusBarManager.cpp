@@ -68,6 +68,13 @@ class StatusBarManagerPrivate
 		int totalSearchBlocks;
 		int lostFilesFound;
 
+		// Are we currently saving files?
+		bool saving;
+
+		// Save status from last filesSaving() update.
+		int currentSaveFile;
+		int totalSaveFiles;
+
 		// Number of seconds to wait before hiding the
 		// progress bar after the search has completed.
 		static const int SECONDS_TO_HIDE_PROGRESS_BAR = 5;
@@ -91,6 +98,9 @@ StatusBarManagerPrivate::StatusBarManagerPrivate(StatusBarManager *q)
 	, currentSearchBlock(0)
 	, totalSearchBlocks(0)
 	, lostFilesFound(0)
+	, saving(false)
+	, currentSaveFile(0)
+	, totalSaveFiles(0)
 	, taskbarButtonManager(nullptr)
 {
 	// Default message.
@@ -126,6 +136,11 @@ void StatusBarManagerPrivate::updateStatusBar(void)
 		QString filesFoundText = StatusBarManager::tr("%n lost file(s) found.", nullptr, lostFilesFound);
 		q->lblFilesFound->setText(filesFoundText);
 		*/
+	} else if (saving) {
+		// We're saving files.
+		lastStatusMessage = StatusBarManager::tr("Saving files... (%L1 of %L2 saved)")
+					.arg(currentSaveFile)
+					.arg(totalSaveFiles);
 	}
 
 	// Set the status bar message.
@@ -141,18 +156,20 @@ void StatusBarManagerPrivate::updateStatusBar(void)
 		lblMessage->resize(w, lblMessage->height());
 	}
 
-	// Make sure the progress bar is visible when scanning.
-	if (scanning && progressBar)
+	// Make sure the progress bar is visible when scanning or saving.
+	if ((scanning || saving) && progressBar)
 		progressBar->setVisible(true);
 
 	// Set the progress bar values.
 	if (progressBar && progressBar->isVisible()) {
-		progressBar->setMaximum(totalSearchBlocks);
-		progressBar->setValue(currentSearchBlock);
+		const int value = (saving ? currentSaveFile : currentSearchBlock);
+		const int max = (saving ? totalSaveFiles : totalSearchBlocks);
+		progressBar->setMaximum(max);
+		progressBar->setValue(value);
 		if (taskbarButtonManager) {
 			// TODO: Set max only in initialization?
-			taskbarButtonManager->setProgressBarValue(currentSearchBlock);
-			taskbarButtonManager->setProgressBarMax(totalSearchBlocks);
+			taskbarButtonManager->setProgressBarValue(value);
+			taskbarButtonManager->setProgressBarMax(max);
 		}
 	} else {
 		if (taskbarButtonManager) {
@@ -367,6 +384,7 @@ void StatusBarManager::opened(const QString &filename, const QString &productNam
 
 	Q_D(StatusBarManager);
 	d->scanning = false;
+	d->saving = false;
 	d->progressBar->setVisible(false);
 	d->lastStatusMessage = tr("Loaded %1 image %2")
 				.arg(productName)
@@ -385,6 +403,7 @@ void StatusBarManager::closed(const QString &productName)
 {
 	Q_D(StatusBarManager);
 	d->scanning = false;
+	d->saving = false;
 	d->progressBar->setVisible(false);
 	d->lastStatusMessage = tr("%1 image closed.").arg(productName);
 	d->updateStatusBar();
@@ -393,6 +412,24 @@ void StatusBarManager::closed(const QString &productName)
 	d->tmrHideProgressBar.stop();
 }
 
+/**
+ * Files are being saved.
+ * @param current Number of files processed so far.
+ * @param total Total number of files being saved.
+ */
+void StatusBarManager::filesSaving(int current, int total)
+{
+	Q_D(StatusBarManager);
+	d->scanning = false;
+	d->saving = true;
+	d->currentSaveFile = current;
+	d->totalSaveFiles = total;
+	d->updateStatusBar();
+
+	// Stop the Hide Progress Bar timer.
+	d->tmrHideProgressBar.stop();
+}
+
 /**
  * Files were saved.
  * @param n Number of files saved.
@@ -402,6 +439,7 @@ void StatusBarManager::filesSaved(int n, const QString &path)
 {
 	Q_D(StatusBarManager);
 	d->scanning = false;
+	d->saving = false;
 	d->progressBar->setVisible(false);
 	d->lastStatusMessage = tr("%Ln file(s) saved to %1.", "", n)
 				.arg(QDir::toNativeSeparators(path));
@@ -450,6 +488,7 @@ void StatusBarManager::searchStarted_slot(int totalPhysBlocks, int totalSearchBl
 
 	// Initialize the search status.
 	d->scanning = true;
+	d->saving = false;
 	// NOTE: When scanning, lastStatusMessage is set by updateStatusBar().
 	d->currentPhysBlock = firstPhysBlock;
 	d->totalPhysBlocks = totalPhysBlocks;
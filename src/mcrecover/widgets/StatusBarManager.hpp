@@ -90,6 +90,13 @@ class StatusBarManager : public QObject
 		 */
 		void closed(const QString &productName);
 
+		/**
+		 * Files are being saved.
+		 * @param current Number of files processed so far.
+		 * @param total Total number of files being saved.
+		 */
+		void filesSaving(int current, int total);
+
 		/**
 		 * Files were saved.
 		 * @param n Number of files saved.
@@ -34,6 +34,7 @@
 // Search classes.
 #include "db/GcnSearchThread.hpp"
 #include "widgets/StatusBarManager.hpp"
+#include "FileExporter.hpp"
 
 // Taskbar Button Manager.
 #include "TaskbarButtonManager/TaskbarButtonManager.hpp"
@@ -125,6 +126,17 @@ class McRecoverWindowPrivate
 		// Search thread.
 		GcnSearchThread *searchThread;
 
+		// Has the current card been searched?
+		// If so, scanning again only checks blocks that changed.
+		bool cardSearched;
+
+		/**
+		 * Search the current card for lost files.
+		 * The databases must have been loaded.
+		 * @param incremental If true, only check blocks that changed since the last search.
+		 */
+		void searchCard(bool incremental);
+
 		/**
 		 * Initialize the toolbar.
 		 */
@@ -163,6 +175,11 @@ class McRecoverWindowPrivate
 		 */
 		void saveFiles(const QVector<File*> &files, QString path = QString());
 
+		// File exporter.
+		FileExporter *fileExporter;
+		// Path of the current export, for the status bar.
+		QString exportPath;
+
 		// UI busy counter.
 		int uiBusyCounter;
 
@@ -203,6 +220,12 @@ class McRecoverWindowPrivate
 		 */
 		GcImageWriter::AnimImageFormat animIconFormat(void) const;
 
+		/**
+		 * Get the PNG compression level to use for banners and icons.
+		 * @return PNG compression level to use.
+		 */
+		GcImageWriter::PngCompression pngCompression(void) const;
+
 		/**
 		 * "Allow Write" checkbox in the toolbar.
 		 * TODO: Better name, and/or change to "Read Only"?
@@ -235,7 +258,9 @@ McRecoverWindowPrivate::McRecoverWindowPrivate(McRecoverWindow *q)
 	, proxyModel(new MemCardSortFilterProxyModel(q))
 	, cols_init(false)
 	, searchThread(new GcnSearchThread(q))
+	, cardSearched(false)
 	, statusBarManager(nullptr)
+	, fileExporter(new FileExporter(q))
 	, uiBusyCounter(0)
 	, preferredRegion(0)
 	, lblPreferredRegion(nullptr)
@@ -268,6 +293,18 @@ McRecoverWindowPrivate::McRecoverWindowPrivate(McRecoverWindow *q)
 	QObject::connect(searchThread, &QObject::destroyed,
 			 q, &McRecoverWindow::markUiNotBusy);
 
+	// Connect the FileExporter slots.
+	QObject::connect(fileExporter, &FileExporter::exportFinished,
+			 q, &McRecoverWindow::fileExporter_exportFinished_slot);
+
+	// Connect fileExporter to the mark-as-busy slots.
+	// This prevents the card from being closed or searched
+	// while files are being exported.
+	QObject::connect(fileExporter, &FileExporter::exportStarted,
+			 q, &McRecoverWindow::markUiBusy);
+	QObject::connect(fileExporter, &FileExporter::exportFinished,
+			 q, &McRecoverWindow::markUiNotBusy);
+
 	// Connect the QSignalMapper slot for "Preferred Region" selection.
 	QObject::connect(mapperPreferredRegion, SIGNAL(mapped(int)),
 			 q, SLOT(setPreferredRegion_slot(int)));
@@ -488,6 +525,52 @@ void McRecoverWindowPrivate::updateWindowTitle(void)
 	q->setWindowTitle(windowTitle);
 }
 
+/**
+ * Search the current card for lost files.
+ * The databases must have been loaded.
+ * @param incremental If true, only check blocks that changed since the last search.
+ */
+void McRecoverWindowPrivate::searchCard(bool incremental)
+{
+	GcnCard *gcnCard = qobject_cast<GcnCard*>(card);
+	if (!gcnCard)
+		return;
+
+	// Remove "lost" files from the card.
+	card->removeLostFiles();
+
+	// Update the status bar manager.
+	statusBarManager->setSearchThread(searchThread);
+
+	// Should we search used blocks?
+	const bool searchUsedBlocks = ui.actionSearchUsedBlocks->isChecked();
+	if (!searchUsedBlocks && card->freeBlocks() <= 0) {
+		// TODO: Print a message in the status bar.
+		// For now, the search thread will simply indicate
+		// that the search has been cancelled.
+	}
+
+	// Search blocks for lost files.
+	// TODO: Handle errors.
+	int ret;
+	if (incremental) {
+		ret = searchThread->rescanMemCard_async(gcnCard, preferredRegion, searchUsedBlocks);
+	} else {
+		ret = searchThread->searchMemCard_async(gcnCard, preferredRegion, searchUsedBlocks);
+	}
+	if (ret < 0) {
+		// Error starting the thread.
+		// Use the synchronous version.
+		// TODO: Handle errors.
+		// NOTE: Files will be added by searchThread_searchFinished_slot().
+		if (incremental) {
+			searchThread->rescanMemCard(gcnCard, preferredRegion, searchUsedBlocks);
+		} else {
+			searchThread->searchMemCard(gcnCard, preferredRegion, searchUsedBlocks);
+		}
+	}
+}
+
 /**
  * Change the file extension of the specified file.
  * @param filename Filename.
@@ -521,6 +604,12 @@ void McRecoverWindowPrivate::saveFiles(const QVector<File*> &files, QString path
 
 	if (files.isEmpty())
 		return;
+	if (fileExporter->isRunning()) {
+		// An export is already in progress.
+		// The UI should be busy, but check anyway
+		// so exportPath isn't overwritten.
+		return;
+	}
 
 	const bool extractBanners = ui.actionExtractBanners->isChecked();
 	const bool extractIcons = ui.actionExtractIcons->isChecked();
@@ -541,7 +630,7 @@ void McRecoverWindowPrivate::saveFiles(const QVector<File*> &files, QString path
 		OVERWRITEALL_NOTOALL	= 2,
 	};
 
-	int filesSaved = 0;
+	int filesQueued = 0;
 	OverwriteAllStatus overwriteAll = OVERWRITEALL_UNKNOWN;
 
 	if (files.size() == 1 && path.isEmpty()) {
@@ -582,6 +671,8 @@ void McRecoverWindowPrivate::saveFiles(const QVector<File*> &files, QString path
 
 	// Animted image format for icons.
 	GcImageWriter::AnimImageFormat animImgf = animIconFormat();
+	// PNG compression level for banners and icons.
+	const GcImageWriter::PngCompression pngc = pngCompression();
 
 	foreach (File *file, files) {
 		if (!singleFile) {
@@ -636,32 +727,14 @@ void McRecoverWindowPrivate::saveFiles(const QVector<File*> &files, QString path
 			}
 		}
 
-		// Save the file.
-		int ret = file->exportToFile(filename);
-		if (ret == 0) {
-			// File saved successfully.
-			filesSaved++;
-		} else {
-			// An error occurred while saving the file.
-			// TODO: Error details.
-		}
-
-		// Extract the banner.
-		if (extractBanners) {
-			// TODO: Error handling and details.
-			QString bannerFilename = changeFileExtension(filename, extBanner);
-			file->saveBanner(bannerFilename);
-		}
-
-		// Extract the icon.
-		if (extractIcons) {
-			// TODO: Error handling and details.
-			if (file->iconCount() >= 1) {
-				// File has an icon.
-				QString iconFilename = changeFileExtension(filename, extIcon);
-				file->saveIcon(iconFilename, animImgf);
-			}
-		}
+		// Queue the file for export.
+		// The file is read here, and the banner, icon, and
+		// file data are written by FileExporter's worker threads.
+		fileExporter->addFile(file, filename,
+			(extractBanners ? changeFileExtension(filename, extBanner) : QString()),
+			(extractIcons ? changeFileExtension(filename, extIcon) : QString()),
+			animImgf, pngc);
+		filesQueued++;
 	}
 
 	// Update the status bar.
@@ -681,7 +754,16 @@ void McRecoverWindowPrivate::saveFiles(const QVector<File*> &files, QString path
 		absolutePath += QChar(L'/');
 	}
 
-	statusBarManager->filesSaved(filesSaved, absolutePath);
+	if (filesQueued == 0) {
+		// No files were queued.
+		statusBarManager->filesSaved(0, absolutePath);
+		return;
+	}
+
+	// Start the export.
+	// The status bar is updated when the export is finished.
+	exportPath = absolutePath;
+	fileExporter->start();
 }
 
 /**
@@ -769,6 +851,23 @@ GcImageWriter::AnimImageFormat McRecoverWindowPrivate::animIconFormat(void) cons
 	return animImgf;
 }
 
+/**
+ * Get the PNG compression level to use for banners and icons.
+ * @return PNG compression level to use.
+ */
+GcImageWriter::PngCompression McRecoverWindowPrivate::pngCompression(void) const
+{
+	// "fast" is useful for bulk exports, since zlib
+	// can otherwise limit the export speed.
+	const QString pngc = cfg->get(QLatin1String("pngCompression")).toString();
+	if (pngc == QLatin1String("fast")) {
+		return GcImageWriter::PNGC_FAST;
+	} else if (pngc == QLatin1String("best")) {
+		return GcImageWriter::PNGC_BEST;
+	}
+	return GcImageWriter::PNGC_DEFAULT;
+}
+
 /**
  * Read a memory card file and try to guess
  * what system it's for.
@@ -905,6 +1004,8 @@ McRecoverWindow::McRecoverWindow(QWidget *parent)
 	d->updateLstFileList();
 	d->initToolbar();
 	d->statusBarManager = new StatusBarManager(d->ui.statusBar, this);
+	connect(d->fileExporter, &FileExporter::exportProgress,
+		d->statusBarManager, &StatusBarManager::filesSaving);
 	d->updateWindowTitle();
 
 	// Shh... it's a secret to everybody.
@@ -946,6 +1047,9 @@ void McRecoverWindow::openCard(const QString &filename, FileType type)
 		delete d->card;
 	}
 
+	// New card hasn't been searched yet.
+	d->cardSearched = false;
+
 	/** TODO: CardFactory **/
 
 	// TODO: Use an enum for 'type'?
@@ -1144,6 +1248,7 @@ void McRecoverWindow::closeCard(bool noMsg)
 	d->ui.mcfFileView->setFile(nullptr);
 	delete d->card;
 	d->card = nullptr;
+	d->cardSearched = false;
 
 	// Disable the "Allow Write" checkbox.
 	d->chkAllowWrite->setEnabled(false);
@@ -1520,30 +1625,10 @@ void McRecoverWindow::on_actionScan_triggered(void)
 	if (ret != 0)
 		return;
 
-	// Remove "lost" files from the card.
-	d->card->removeLostFiles();
-
-	// Update the status bar manager.
-	d->statusBarManager->setSearchThread(d->searchThread);
-
-	// Should we search used blocks?
-	const bool searchUsedBlocks = d->ui.actionSearchUsedBlocks->isChecked();
-	if (!searchUsedBlocks && d->card->freeBlocks() <= 0) {
-		// TODO: Print a message in the status bar.
-		// For now, the search thread will simply indicate
-		// that the search has been cancelled.
-	}
-
 	// Search blocks for lost files.
-	// TODO: Handle errors.
-	ret = d->searchThread->searchMemCard_async(gcnCard, d->preferredRegion, searchUsedBlocks);
-	if (ret < 0) {
-		// Error starting the thread.
-		// Use the synchronous version.
-		// TODO: Handle errors.
-		// NOTE: Files will be added by searchThread_searchFinished_slot().
-		ret = d->searchThread->searchMemCard(gcnCard, d->preferredRegion, searchUsedBlocks);
-	}
+	// If the card was searched before, only blocks that
+	// changed since then (e.g. after saving a file) are checked.
+	d->searchCard(d->cardSearched);
 }
 
 /**
@@ -1722,6 +1807,19 @@ void McRecoverWindow::searchThread_searchFinished_slot(int lostFilesFound)
 
 	// Add the directory entries.
 	QList<GcnFile*> files = gcnCard->addLostFiles(filesFoundList);
+
+	// The next search can reuse these results.
+	d->cardSearched = true;
+}
+
+/**
+ * File export has completed.
+ * @param filesSaved Number of files saved successfully.
+ */
+void McRecoverWindow::fileExporter_exportFinished_slot(int filesSaved)
+{
+	Q_D(McRecoverWindow);
+	d->statusBarManager->filesSaved(filesSaved, d->exportPath);
 }
 
 /**
@@ -116,6 +116,9 @@ class McRecoverWindow : public QMainWindow
 		// SearchThread has finished.
 		void searchThread_searchFinished_slot(int lostFilesFound);
 
+		// FileExporter has finished.
+		void fileExporter_exportFinished_slot(int filesSaved);
+
 		// lstFileList slots.
 		void lstFileList_selectionModel_selectionChanged(const QItemSelection& selected, const QItemSelection& deselected);
 